@@ -0,0 +1,220 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Implementation of the AllowedPayments class. The whole file is
+ *              read up front, since every game of a batch may need it. Names
+ *              are interned so a league's million allowed payments keep each
+ *              player's name once, and a game's pairs are turned into its
+ *              graph's node indices only when the game is settled.
+*******************************************************************************/
+#include "AllowedPayments.hpp"
+#include "PlayerGraph.hpp"
+#include <sstream>
+
+
+/*******************************************************************************
+ *                            AllowedPayments()
+ * Description: Constructor. Nothing is allowed until read() is called.
+*******************************************************************************/
+AllowedPayments::AllowedPayments(){
+    this->pairCount = 0;
+}
+
+
+/*******************************************************************************
+ *                       internName(const std::string&)
+ * Description: returns the id of a name, giving it the next id if it hasn't
+ *              been seen before
+*******************************************************************************/
+int AllowedPayments::internName(const std::string& name){
+    std::unordered_map<std::string, int>::const_iterator found =
+        this->nameIds.find(name);
+    if(found != this->nameIds.end()){
+        return found->second;
+    }
+    int id = this->names.size();
+    this->names.push_back(name);
+    this->nameIds[name] = id;
+    return id;
+}
+
+
+/*******************************************************************************
+ *                          read(std::istream&)
+ * Description: reads every allowed payment in input. Returns false and sets
+ *              the error if a line isn't two or three fields, or leaves a
+ *              name empty.
+*******************************************************************************/
+bool AllowedPayments::read(std::istream& input){
+    std::string line;
+    int lineNumber = 0;
+    while(std::getline(input, line)){
+        lineNumber++;
+
+        //tolerate files written with windows line endings
+        if(!line.empty() && line[line.size() - 1] == '\r'){
+            line.erase(line.size() - 1);
+        }
+        if(line.empty() || line[0] == '#'){
+            continue;
+        }
+
+        //split on commas
+        std::string fields[3];
+        int fieldCount = 0;
+        size_t start = 0;
+        bool tooMany = false;
+        while(true){
+            size_t comma = line.find(',', start);
+            if(fieldCount == 3){
+                tooMany = true;
+                break;
+            }
+            if(comma == std::string::npos){
+                fields[fieldCount++] = line.substr(start);
+                break;
+            }
+            fields[fieldCount++] = line.substr(start, comma - start);
+            start = comma + 1;
+        }
+
+        bool hasGameId = fieldCount == 3;
+        const std::string& payer = fields[hasGameId ? 1 : 0];
+        const std::string& payee = fields[hasGameId ? 2 : 1];
+        if(tooMany || fieldCount < 2 || payer.empty() || payee.empty()){
+            std::ostringstream message;
+            message << "line " << lineNumber << ": expected "
+                    << "[game_id,]payer_name,payee_name";
+            this->error = message.str();
+            return false;
+        }
+
+        std::vector<int>& pairs = hasGameId ?
+            this->gamePairs[fields[0]] : this->leaguePairs;
+        pairs.push_back(this->internName(payer));
+        pairs.push_back(this->internName(payee));
+        this->pairCount++;
+    }
+    this->indexLeaguePairs();
+    return true;
+}
+
+
+/*******************************************************************************
+ *                           indexLeaguePairs()
+ * Description: sorts the pairs for every game into CSR form by payer, with a
+ *              counting sort that keeps each payer's pairs in file order
+*******************************************************************************/
+void AllowedPayments::indexLeaguePairs(){
+    int nameCount = this->names.size();
+    this->leagueOffsets.assign(nameCount + 1, 0);
+    for(size_t i = 0; i < this->leaguePairs.size(); i += 2){
+        this->leagueOffsets[this->leaguePairs[i] + 1]++;
+    }
+    for(int i = 0; i < nameCount; ++i){
+        this->leagueOffsets[i + 1] += this->leagueOffsets[i];
+    }
+
+    std::vector<int> next(this->leagueOffsets.begin(),
+                          this->leagueOffsets.end() - 1);
+    this->leaguePayees.resize(this->leaguePairs.size() / 2);
+    for(size_t i = 0; i < this->leaguePairs.size(); i += 2){
+        this->leaguePayees[next[this->leaguePairs[i]]++] =
+            this->leaguePairs[i + 1];
+    }
+}
+
+
+/*******************************************************************************
+ *                               getError()
+ * Description: returns why read() failed
+*******************************************************************************/
+const std::string& AllowedPayments::getError() const {
+    return this->error;
+}
+
+
+/*******************************************************************************
+ *                             getPairCount()
+ * Description: returns the number of allowed payments read
+*******************************************************************************/
+long AllowedPayments::getPairCount() const {
+    return this->pairCount;
+}
+
+
+/*******************************************************************************
+ *                             hasGamePairs()
+ * Description: returns true if any allowed payment was for one game only
+*******************************************************************************/
+bool AllowedPayments::hasGamePairs() const {
+    return !this->gamePairs.empty();
+}
+
+
+/*******************************************************************************
+ *       findPairs(const std::string&, const PlayerGraph&, vector<int>&,
+ *                 vector<int>&)
+ * Description: fills payers and payees with the payments allowed in the game
+ *              with the given id, as node indices of the game's graph: the
+ *              pairs for every game, then the game's own. Pairs naming
+ *              someone who isn't playing in the game are left out. If two
+ *              players of the game share a name, the first one gets the pairs.
+ *              Takes time in the number of players and their pairs, not in
+ *              the size of the whole file.
+*******************************************************************************/
+void AllowedPayments::findPairs(const std::string& gameId,
+                                const PlayerGraph& graph,
+                                std::vector<int>& payers,
+                                std::vector<int>& payees) const {
+    payers.clear();
+    payees.clear();
+    int nodeCount = graph.getNodeCount();
+
+    //the name id of each node, and the node of each name id in the game
+    std::vector<int> nodeNames(nodeCount, -1);
+    std::unordered_map<int, int> nodes;
+    nodes.reserve(nodeCount);
+    for(int i = 0; i < nodeCount; ++i){
+        size_t length;
+        const char* name = graph.getPlayerName(i, length);
+        std::unordered_map<std::string, int>::const_iterator found =
+            this->nameIds.find(std::string(name, length));
+        if(found != this->nameIds.end() &&
+           nodes.insert(std::make_pair(found->second, i)).second){
+            nodeNames[i] = found->second;
+        }
+    }
+
+    for(int i = 0; i < nodeCount; ++i){
+        if(nodeNames[i] < 0){
+            continue;
+        }
+        for(int j = this->leagueOffsets[nodeNames[i]];
+            j < this->leagueOffsets[nodeNames[i] + 1]; ++j){
+            std::unordered_map<int, int>::const_iterator payee =
+                nodes.find(this->leaguePayees[j]);
+            if(payee != nodes.end()){
+                payers.push_back(i);
+                payees.push_back(payee->second);
+            }
+        }
+    }
+
+    std::unordered_map<std::string, std::vector<int> >::const_iterator game =
+        this->gamePairs.find(gameId);
+    if(game == this->gamePairs.end()){
+        return;
+    }
+    const std::vector<int>& pairs = game->second;
+    for(size_t i = 0; i < pairs.size(); i += 2){
+        std::unordered_map<int, int>::const_iterator payer =
+            nodes.find(pairs[i]);
+        std::unordered_map<int, int>::const_iterator payee =
+            nodes.find(pairs[i + 1]);
+        if(payer != nodes.end() && payee != nodes.end()){
+            payers.push_back(payer->second);
+            payees.push_back(payee->second);
+        }
+    }
+}
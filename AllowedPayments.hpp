@@ -0,0 +1,57 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Header file for the AllowedPayments class. AllowedPayments
+ *              reads which players are allowed to pay which, for settling
+ *              games where not everyone can pay everyone, such as a league
+ *              whose players can only send money to others on the same
+ *              payment app. Each line of the file allows one payment:
+ *
+ *                  [game_id,]payer_name,payee_name
+ *
+ *              A line without a game id applies to every game, and a line
+ *              with one only to that game. Payments only go the way they're
+ *              listed, so a pair that can pay each other either way is listed
+ *              both ways. Blank lines and lines starting with '#' are
+ *              ignored.
+*******************************************************************************/
+#ifndef ALLOWEDPAYMENTS_HPP
+#define ALLOWEDPAYMENTS_HPP
+
+#include <istream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class PlayerGraph;
+
+class AllowedPayments
+{
+    private:
+        //each name is kept once, and pairs are kept as two name ids. The
+        //pairs for every game are also kept in CSR form by payer, so a game
+        //only looks at the pairs of its own players
+        std::vector<std::string> names;
+        std::unordered_map<std::string, int> nameIds;
+        std::vector<int> leaguePairs;
+        std::vector<int> leagueOffsets;
+        std::vector<int> leaguePayees;
+        std::unordered_map<std::string, std::vector<int> > gamePairs;
+        long pairCount;
+        std::string error;
+
+        int internName(const std::string& name);
+        void indexLeaguePairs();
+
+    public:
+        AllowedPayments();
+        bool read(std::istream& input);
+        const std::string& getError() const;
+        long getPairCount() const;
+        bool hasGamePairs() const;
+        void findPairs(const std::string& gameId, const PlayerGraph& graph,
+                       std::vector<int>& payers,
+                       std::vector<int>& payees) const;
+};
+
+#endif
@@ -0,0 +1,109 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Defines Amount, the type every amount of money (in cents) is
+ *              kept in. Its width is chosen at compile time with
+ *              POKERCALC_AMOUNT_BITS:
+ *
+ *                  32  - fastest, fine for a single night's game
+ *                  64  - the default, good past $92 quadrillion
+ *                  128 - for aggregated ledgers of any size
+ *
+ *              A single player's amounts are bounded by input validation, so
+ *              only running totals can overflow. Those are added with
+ *              addAmounts(), which detects overflow for the widths where it
+ *              can happen and is a plain add for 128 bits, where totals of
+ *              validated amounts can't overflow.
+*******************************************************************************/
+#ifndef AMOUNT_HPP
+#define AMOUNT_HPP
+
+#include <stdint.h>
+#include <ostream>
+#include <string>
+
+#ifndef POKERCALC_AMOUNT_BITS
+#define POKERCALC_AMOUNT_BITS 64
+#endif
+
+template<int Bits> struct AmountOfWidth;
+
+template<> struct AmountOfWidth<32>{
+    typedef int32_t type;
+    static const bool canOverflow = true;
+};
+
+template<> struct AmountOfWidth<64>{
+    typedef int64_t type;
+    static const bool canOverflow = true;
+};
+
+template<> struct AmountOfWidth<128>{
+    typedef __int128 type;
+    static const bool canOverflow = false;
+};
+
+typedef AmountOfWidth<POKERCALC_AMOUNT_BITS>::type Amount;
+
+
+/*******************************************************************************
+ *                    addAmounts(Amount, Amount, Amount&)
+ * Description: sets sum to first + second. Returns false if the sum doesn't
+ *              fit in an Amount.
+*******************************************************************************/
+inline bool addAmounts(Amount first, Amount second, Amount& sum){
+    if(!AmountOfWidth<POKERCALC_AMOUNT_BITS>::canOverflow){
+        sum = first + second;
+        return true;
+    }
+    return !__builtin_add_overflow(first, second, &sum);
+}
+
+
+/*******************************************************************************
+ *                       formatAmount(Amount, char*)
+ * Description: writes the amount out in decimal so that it ends just before
+ *              end, and returns where it starts. AMOUNT_DIGITS characters are
+ *              always enough.
+*******************************************************************************/
+const int AMOUNT_DIGITS = 48;
+
+inline char* formatAmount(Amount amount, char* end){
+    char* position = end;
+    bool negative = amount < 0;
+
+    //work with negative numbers so the most negative amount still works
+    if(!negative){
+        amount = -amount;
+    }
+    do{
+        *--position = '0' - (char)(amount % 10);
+        amount /= 10;
+    }while(amount != 0);
+    if(negative){
+        *--position = '-';
+    }
+
+    return position;
+}
+
+
+/*******************************************************************************
+ *                         amountToString(Amount)
+ * Description: returns the amount written out in decimal
+*******************************************************************************/
+inline std::string amountToString(Amount amount){
+    char digits[AMOUNT_DIGITS];
+    char* end = digits + sizeof(digits);
+    char* start = formatAmount(amount, end);
+    return std::string(start, end - start);
+}
+
+#if POKERCALC_AMOUNT_BITS == 128
+//iostreams have no overload for 128 bit integers
+inline std::ostream& operator<<(std::ostream& out, __int128 amount){
+    return out << amountToString(amount);
+}
+#endif
+
+#endif
@@ -0,0 +1,586 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Implementation of AmountKernels. Each kernel has a plain
+ *              version for every Amount width, and AVX2 and SSE2 versions for
+ *              32 and 64 bit Amounts that are compiled for those instruction
+ *              sets whatever the rest of PokerCalc is built for. Templates
+ *              hand 128 bit Amounts to the plain versions. The vector
+ *              versions do as many players as fit in a vector at a time and
+ *              leave whatever is left over to the plain version.
+ *
+ *              The partition writes every player's index to both lists and
+ *              moves a list's end past it only if the player belongs there,
+ *              so it never branches on a balance. The vector versions do the
+ *              same for a vector of players at a time, looking up which of
+ *              them to keep from a mask of their signs.
+*******************************************************************************/
+#include "AmountKernels.hpp"
+#include "BinaryLedger.hpp"
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define POKERCALC_X86_KERNELS 1
+#include <immintrin.h>
+#else
+#define POKERCALC_X86_KERNELS 0
+#endif
+
+//the vector versions read a record's buy-in and final stack with one load
+static_assert(offsetof(LedgerFileRecord, finalStack) ==
+              offsetof(LedgerFileRecord, buyIn) + sizeof(int64_t),
+              "a record's buy-in and final stack must be next to each other");
+
+
+/*******************************************************************************
+ *             ledgerBalancesScalar(records, count, balances)
+ *                     sumScalar(values, count)
+ *   partitionScalar(balances, start, count, winners, losers, winnerCount,
+ *                   loserCount)
+ * Description: the plain versions of the kernels. partitionScalar() starts at
+ *              player start and adds to lists that already hold winnerCount
+ *              and loserCount players, so the vector versions can finish
+ *              with it.
+*******************************************************************************/
+template<typename T>
+static void ledgerBalancesScalar(const LedgerFileRecord* records, int count,
+                                 T* balances){
+    for(int i = 0; i < count; ++i){
+        balances[i] = records[i].buyIn - records[i].finalStack;
+    }
+}
+
+
+template<typename T>
+static T sumScalar(const T* values, int count){
+    T total = 0;
+    for(int i = 0; i < count; ++i){
+        total += values[i];
+    }
+    return total;
+}
+
+
+template<typename T>
+static void partitionScalar(const T* balances, int start, int count,
+                            int* winners, int* losers, int& winnerCount,
+                            int& loserCount){
+    int w = winnerCount;
+    int l = loserCount;
+    for(int i = start; i < count; ++i){
+        winners[w] = i;
+        w += balances[i] < 0;
+        losers[l] = i;
+        l += balances[i] > 0;
+    }
+    winnerCount = w;
+    loserCount = l;
+}
+
+
+//the widths without vector versions use the plain ones
+template<typename T>
+static void ledgerBalancesSse2(const LedgerFileRecord* records, int count,
+                               T* balances){
+    ledgerBalancesScalar(records, count, balances);
+}
+
+
+template<typename T>
+static void ledgerBalancesAvx2(const LedgerFileRecord* records, int count,
+                               T* balances){
+    ledgerBalancesScalar(records, count, balances);
+}
+
+
+template<typename T>
+static T sumSse2(const T* values, int count){
+    return sumScalar(values, count);
+}
+
+
+template<typename T>
+static T sumAvx2(const T* values, int count){
+    return sumScalar(values, count);
+}
+
+
+template<typename T>
+static void partitionSse2(const T* balances, int count, int* winners,
+                          int* losers, int& winnerCount, int& loserCount){
+    partitionScalar(balances, 0, count, winners, losers, winnerCount,
+                    loserCount);
+}
+
+
+template<typename T>
+static void partitionAvx2(const T* balances, int count, int* winners,
+                          int* losers, int& winnerCount, int& loserCount){
+    partitionScalar(balances, 0, count, winners, losers, winnerCount,
+                    loserCount);
+}
+
+
+#if POKERCALC_X86_KERNELS
+
+#define SSE2_KERNEL __attribute__((target("sse2")))
+#define AVX2_KERNEL __attribute__((target("avx2")))
+
+//row m of PackedLanes::lanes lists the lanes whose bits are set in the 4 bit
+//mask m, packed to the front, and counts[m] is how many of them there are
+struct PackedLanes{
+    int32_t lanes[16][4];
+    int counts[16];
+
+    PackedLanes(){
+        for(int mask = 0; mask < 16; ++mask){
+            int count = 0;
+            for(int lane = 0; lane < 4; ++lane){
+                this->lanes[mask][lane] = 0;
+                if(mask & (1 << lane)){
+                    this->lanes[mask][count++] = lane;
+                }
+            }
+            this->counts[mask] = count;
+        }
+    }
+};
+
+static const PackedLanes PACKED_LANES;
+
+
+/*******************************************************************************
+ *                   packLanes(list, mask, first)
+ * Description: writes the indices of the 4 players from first whose bits are
+ *              set in mask to the end of list, and returns how many there
+ *              were. Always stores 4 indices; the ones past the count are
+ *              written over by the next call.
+*******************************************************************************/
+SSE2_KERNEL
+static inline int packLanes(int* list, int mask, __m128i first){
+    __m128i lanes = _mm_loadu_si128(
+        (const __m128i*)PACKED_LANES.lanes[mask]);
+    _mm_storeu_si128((__m128i*)list, _mm_add_epi32(first, lanes));
+    return PACKED_LANES.counts[mask];
+}
+
+
+/*******************************************************************************
+ *        ledgerBalancesSse2(records, count, balances) - 32 and 64 bit
+ * Description: loads two records' buy-ins and final stacks, regroups them
+ *              into a vector of buy-ins and one of final stacks, and
+ *              subtracts. 32 bit balances are narrowed afterwards; validated
+ *              records' balances always fit.
+*******************************************************************************/
+SSE2_KERNEL
+static void ledgerBalancesSse2(const LedgerFileRecord* records, int count,
+                               int64_t* balances){
+    int i = 0;
+    for(; i + 2 <= count; i += 2){
+        __m128i first = _mm_loadu_si128((const __m128i*)&records[i].buyIn);
+        __m128i second = _mm_loadu_si128(
+            (const __m128i*)&records[i + 1].buyIn);
+        __m128i difference = _mm_sub_epi64(_mm_unpacklo_epi64(first, second),
+                                           _mm_unpackhi_epi64(first, second));
+        _mm_storeu_si128((__m128i*)(balances + i), difference);
+    }
+    ledgerBalancesScalar(records + i, count - i, balances + i);
+}
+
+
+SSE2_KERNEL
+static void ledgerBalancesSse2(const LedgerFileRecord* records, int count,
+                               int32_t* balances){
+    int i = 0;
+    for(; i + 2 <= count; i += 2){
+        __m128i first = _mm_loadu_si128((const __m128i*)&records[i].buyIn);
+        __m128i second = _mm_loadu_si128(
+            (const __m128i*)&records[i + 1].buyIn);
+        __m128i difference = _mm_sub_epi64(_mm_unpacklo_epi64(first, second),
+                                           _mm_unpackhi_epi64(first, second));
+        __m128i narrowed = _mm_shuffle_epi32(difference,
+                                             _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storel_epi64((__m128i*)(balances + i), narrowed);
+    }
+    ledgerBalancesScalar(records + i, count - i, balances + i);
+}
+
+
+/*******************************************************************************
+ *        ledgerBalancesAvx2(records, count, balances) - 32 and 64 bit
+ * Description: the SSE2 version for four records at a time, with records i
+ *              and i + 1 in the low half of each vector and i + 2 and i + 3
+ *              in the high half
+*******************************************************************************/
+AVX2_KERNEL
+static inline __m256i loadRecordPairs(const LedgerFileRecord* records){
+    __m128i low = _mm_loadu_si128((const __m128i*)&records[0].buyIn);
+    __m128i high = _mm_loadu_si128((const __m128i*)&records[2].buyIn);
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+}
+
+
+AVX2_KERNEL
+static inline __m256i recordDifferences(const LedgerFileRecord* records){
+    __m256i first = loadRecordPairs(records);
+    __m256i second = loadRecordPairs(records + 1);
+    return _mm256_sub_epi64(_mm256_unpacklo_epi64(first, second),
+                            _mm256_unpackhi_epi64(first, second));
+}
+
+
+AVX2_KERNEL
+static void ledgerBalancesAvx2(const LedgerFileRecord* records, int count,
+                               int64_t* balances){
+    int i = 0;
+    for(; i + 4 <= count; i += 4){
+        _mm256_storeu_si256((__m256i*)(balances + i),
+                            recordDifferences(records + i));
+    }
+    ledgerBalancesScalar(records + i, count - i, balances + i);
+}
+
+
+AVX2_KERNEL
+static void ledgerBalancesAvx2(const LedgerFileRecord* records, int count,
+                               int32_t* balances){
+    const __m256i lowHalves = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    int i = 0;
+    for(; i + 4 <= count; i += 4){
+        __m256i narrowed = _mm256_permutevar8x32_epi32(
+            recordDifferences(records + i), lowHalves);
+        _mm_storeu_si128((__m128i*)(balances + i),
+                         _mm256_castsi256_si128(narrowed));
+    }
+    ledgerBalancesScalar(records + i, count - i, balances + i);
+}
+
+
+/*******************************************************************************
+ *              sumSse2(values, count) / sumAvx2(values, count)
+ * Description: add up the values in two vectors of running totals, so each
+ *              add doesn't wait on the one before it
+*******************************************************************************/
+SSE2_KERNEL
+static int64_t sumSse2(const int64_t* values, int count){
+    __m128i first = _mm_setzero_si128();
+    __m128i second = _mm_setzero_si128();
+    int i = 0;
+    for(; i + 4 <= count; i += 4){
+        first = _mm_add_epi64(first,
+                              _mm_loadu_si128((const __m128i*)(values + i)));
+        second = _mm_add_epi64(second,
+            _mm_loadu_si128((const __m128i*)(values + i + 2)));
+    }
+    int64_t lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, _mm_add_epi64(first, second));
+    return lanes[0] + lanes[1] + sumScalar(values + i, count - i);
+}
+
+
+SSE2_KERNEL
+static int32_t sumSse2(const int32_t* values, int count){
+    __m128i first = _mm_setzero_si128();
+    __m128i second = _mm_setzero_si128();
+    int i = 0;
+    for(; i + 8 <= count; i += 8){
+        first = _mm_add_epi32(first,
+                              _mm_loadu_si128((const __m128i*)(values + i)));
+        second = _mm_add_epi32(second,
+            _mm_loadu_si128((const __m128i*)(values + i + 4)));
+    }
+    int32_t lanes[4];
+    _mm_storeu_si128((__m128i*)lanes, _mm_add_epi32(first, second));
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+           sumScalar(values + i, count - i);
+}
+
+
+AVX2_KERNEL
+static int64_t sumAvx2(const int64_t* values, int count){
+    __m256i first = _mm256_setzero_si256();
+    __m256i second = _mm256_setzero_si256();
+    int i = 0;
+    for(; i + 8 <= count; i += 8){
+        first = _mm256_add_epi64(first,
+            _mm256_loadu_si256((const __m256i*)(values + i)));
+        second = _mm256_add_epi64(second,
+            _mm256_loadu_si256((const __m256i*)(values + i + 4)));
+    }
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, _mm256_add_epi64(first, second));
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+           sumScalar(values + i, count - i);
+}
+
+
+AVX2_KERNEL
+static int32_t sumAvx2(const int32_t* values, int count){
+    __m256i first = _mm256_setzero_si256();
+    __m256i second = _mm256_setzero_si256();
+    int i = 0;
+    for(; i + 16 <= count; i += 16){
+        first = _mm256_add_epi32(first,
+            _mm256_loadu_si256((const __m256i*)(values + i)));
+        second = _mm256_add_epi32(second,
+            _mm256_loadu_si256((const __m256i*)(values + i + 8)));
+    }
+    int32_t lanes[8];
+    _mm256_storeu_si256((__m256i*)lanes, _mm256_add_epi32(first, second));
+    int32_t total = 0;
+    for(int lane = 0; lane < 8; ++lane){
+        total += lanes[lane];
+    }
+    return total + sumScalar(values + i, count - i);
+}
+
+
+/*******************************************************************************
+ *   partitionSse2(balances, count, winners, losers, winnerCount, loserCount)
+ * Description: sorts four players at a time into winners and losers. SSE2
+ *              has no 64 bit compare, so for 64 bit balances the sign bits
+ *              give the winners, and a balance is zero when both of its
+ *              halves are.
+*******************************************************************************/
+SSE2_KERNEL
+static inline int zeroLanes(__m128i values){
+    __m128i swapped = _mm_shuffle_epi32(values, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128i zero = _mm_cmpeq_epi32(_mm_or_si128(values, swapped),
+                                   _mm_setzero_si128());
+    return _mm_movemask_pd(_mm_castsi128_pd(zero));
+}
+
+
+SSE2_KERNEL
+static void partitionSse2(const int64_t* balances, int count, int* winners,
+                          int* losers, int& winnerCount, int& loserCount){
+    int i = 0;
+    for(; i + 4 <= count; i += 4){
+        __m128i low = _mm_loadu_si128((const __m128i*)(balances + i));
+        __m128i high = _mm_loadu_si128((const __m128i*)(balances + i + 2));
+        int negative = _mm_movemask_pd(_mm_castsi128_pd(low)) |
+                       _mm_movemask_pd(_mm_castsi128_pd(high)) << 2;
+        int zero = zeroLanes(low) | zeroLanes(high) << 2;
+        int positive = ~(negative | zero) & 0xF;
+
+        __m128i first = _mm_set1_epi32(i);
+        winnerCount += packLanes(winners + winnerCount, negative, first);
+        loserCount += packLanes(losers + loserCount, positive, first);
+    }
+    partitionScalar(balances, i, count, winners, losers, winnerCount,
+                    loserCount);
+}
+
+
+SSE2_KERNEL
+static void partitionSse2(const int32_t* balances, int count, int* winners,
+                          int* losers, int& winnerCount, int& loserCount){
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for(; i + 4 <= count; i += 4){
+        __m128i values = _mm_loadu_si128((const __m128i*)(balances + i));
+        int negative = _mm_movemask_ps(_mm_castsi128_ps(values));
+        int positive = _mm_movemask_ps(
+            _mm_castsi128_ps(_mm_cmpgt_epi32(values, zero)));
+
+        __m128i first = _mm_set1_epi32(i);
+        winnerCount += packLanes(winners + winnerCount, negative, first);
+        loserCount += packLanes(losers + loserCount, positive, first);
+    }
+    partitionScalar(balances, i, count, winners, losers, winnerCount,
+                    loserCount);
+}
+
+
+/*******************************************************************************
+ *   partitionAvx2(balances, count, winners, losers, winnerCount, loserCount)
+ * Description: sorts a vector of players at a time into winners and losers,
+ *              four 64 bit balances or eight 32 bit ones, packing four
+ *              players' indices at a time
+*******************************************************************************/
+AVX2_KERNEL
+static void partitionAvx2(const int64_t* balances, int count, int* winners,
+                          int* losers, int& winnerCount, int& loserCount){
+    const __m256i zero = _mm256_setzero_si256();
+    int i = 0;
+    for(; i + 4 <= count; i += 4){
+        __m256i values = _mm256_loadu_si256((const __m256i*)(balances + i));
+        int negative = _mm256_movemask_pd(_mm256_castsi256_pd(values));
+        int positive = _mm256_movemask_pd(
+            _mm256_castsi256_pd(_mm256_cmpgt_epi64(values, zero)));
+
+        __m128i first = _mm_set1_epi32(i);
+        winnerCount += packLanes(winners + winnerCount, negative, first);
+        loserCount += packLanes(losers + loserCount, positive, first);
+    }
+    partitionScalar(balances, i, count, winners, losers, winnerCount,
+                    loserCount);
+}
+
+
+AVX2_KERNEL
+static void partitionAvx2(const int32_t* balances, int count, int* winners,
+                          int* losers, int& winnerCount, int& loserCount){
+    const __m256i zero = _mm256_setzero_si256();
+    const __m128i four = _mm_set1_epi32(4);
+    int i = 0;
+    for(; i + 8 <= count; i += 8){
+        __m256i values = _mm256_loadu_si256((const __m256i*)(balances + i));
+        int negative = _mm256_movemask_ps(_mm256_castsi256_ps(values));
+        int positive = _mm256_movemask_ps(
+            _mm256_castsi256_ps(_mm256_cmpgt_epi32(values, zero)));
+
+        __m128i first = _mm_set1_epi32(i);
+        winnerCount += packLanes(winners + winnerCount, negative & 0xF,
+                                 first);
+        loserCount += packLanes(losers + loserCount, positive & 0xF, first);
+        first = _mm_add_epi32(first, four);
+        winnerCount += packLanes(winners + winnerCount, negative >> 4, first);
+        loserCount += packLanes(losers + loserCount, positive >> 4, first);
+    }
+    partitionScalar(balances, i, count, winners, losers, winnerCount,
+                    loserCount);
+}
+
+#endif
+
+
+/*******************************************************************************
+ *                          getSupportedLevel()
+ * Description: returns the fastest kernels the CPU PokerCalc is running on
+ *              can use
+*******************************************************************************/
+KernelLevel AmountKernels::getSupportedLevel(){
+#if POKERCALC_X86_KERNELS
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")){
+        return AVX2_KERNELS;
+    }
+    if(__builtin_cpu_supports("sse2")){
+        return SSE2_KERNELS;
+    }
+#endif
+    return SCALAR_KERNELS;
+}
+
+
+/*******************************************************************************
+ *                  currentLevel() / getLevel() / setLevel()
+ * Description: the kernels in use, the fastest supported ones unless
+ *              setLevel() picked others. setLevel() is for benchmarks and
+ *              comparing results; it returns false, and changes nothing, if
+ *              the CPU can't run the kernels asked for. It isn't safe to call
+ *              while games are being settled on other threads.
+*******************************************************************************/
+KernelLevel& AmountKernels::currentLevel(){
+    static KernelLevel level = getSupportedLevel();
+    return level;
+}
+
+
+KernelLevel AmountKernels::getLevel(){
+    return currentLevel();
+}
+
+
+bool AmountKernels::setLevel(KernelLevel level){
+    if(level < SCALAR_KERNELS || level > getSupportedLevel()){
+        return false;
+    }
+    currentLevel() = level;
+    return true;
+}
+
+
+/*******************************************************************************
+ *                          getLevelName(KernelLevel)
+ * Description: returns the name of a kernel level, for reports
+*******************************************************************************/
+const char* AmountKernels::getLevelName(KernelLevel level){
+    if(level == AVX2_KERNELS){
+        return "avx2";
+    }
+    if(level == SSE2_KERNELS){
+        return "sse2";
+    }
+    return "scalar";
+}
+
+
+/*******************************************************************************
+ *              ledgerBalances(const LedgerFileRecord*, int, Amount*)
+ * Description: sets each balance to its record's buy-in less its final
+ *              stack. The records must have been validated by BinaryLedger.
+*******************************************************************************/
+void AmountKernels::ledgerBalances(const LedgerFileRecord* records, int count,
+                                   Amount* balances){
+#if POKERCALC_X86_KERNELS
+    if(currentLevel() == AVX2_KERNELS){
+        ledgerBalancesAvx2(records, count, balances);
+        return;
+    }
+    if(currentLevel() == SSE2_KERNELS){
+        ledgerBalancesSse2(records, count, balances);
+        return;
+    }
+#endif
+    ledgerBalancesScalar(records, count, balances);
+}
+
+
+/*******************************************************************************
+ *                     sumAmounts(const Amount*, int)
+ * Description: returns the sum of the values. The sum of their magnitudes
+ *              must fit in an Amount, as it does for the balances of a game
+ *              whose amountsFit(), so no partial sum can overflow whatever
+ *              order they're added in.
+*******************************************************************************/
+Amount AmountKernels::sumAmounts(const Amount* values, int count){
+#if POKERCALC_X86_KERNELS
+    if(currentLevel() == AVX2_KERNELS){
+        return sumAvx2(values, count);
+    }
+    if(currentLevel() == SSE2_KERNELS){
+        return sumSse2(values, count);
+    }
+#endif
+    return sumScalar(values, count);
+}
+
+
+/*******************************************************************************
+ *  partitionBalances(const Amount*, int, vector<int>&, vector<int>&)
+ * Description: replaces winners with the indices of the negative balances
+ *              and losers with the indices of the positive ones, both in
+ *              increasing order. Players who are even are in neither list.
+*******************************************************************************/
+void AmountKernels::partitionBalances(const Amount* balances, int count,
+                                      std::vector<int>& winners,
+                                      std::vector<int>& losers){
+    //the kernels store the indices they look at before deciding whether to
+    //keep them, but never past the player they're on, so a list as long as
+    //count always has room
+    winners.resize(count);
+    losers.resize(count);
+    int winnerCount = 0;
+    int loserCount = 0;
+
+#if POKERCALC_X86_KERNELS
+    if(currentLevel() == AVX2_KERNELS){
+        partitionAvx2(balances, count, winners.data(), losers.data(),
+                      winnerCount, loserCount);
+    }
+    else if(currentLevel() == SSE2_KERNELS){
+        partitionSse2(balances, count, winners.data(), losers.data(),
+                      winnerCount, loserCount);
+    }
+    else
+#endif
+    {
+        partitionScalar(balances, 0, count, winners.data(), losers.data(),
+                        winnerCount, loserCount);
+    }
+
+    winners.resize(winnerCount);
+    losers.resize(loserCount);
+}
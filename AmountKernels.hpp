@@ -0,0 +1,52 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Header file for AmountKernels, the loops a PlayerGraph runs
+ *              over every player before it solves: working out each balance
+ *              from a binary ledger's records, adding the balances up to check
+ *              the game is balanced, and splitting the players into winners
+ *              and losers. For a million player ledger each pass streams
+ *              megabytes of amounts, so each one has an AVX2 and an SSE2
+ *              version as well as a plain one.
+ *
+ *              The version used is chosen when PokerCalc starts, from what the
+ *              CPU it's running on supports, so one build runs anywhere. Every
+ *              version gives exactly the same results. Vectors are used for
+ *              32 and 64 bit Amounts; 128 bit Amounts always use plain loops.
+*******************************************************************************/
+#ifndef AMOUNTKERNELS_HPP
+#define AMOUNTKERNELS_HPP
+
+#include <vector>
+#include "Amount.hpp"
+
+struct LedgerFileRecord;
+
+//the instruction sets the kernels can use, each faster than the last
+enum KernelLevel{
+    SCALAR_KERNELS,     //plain loops, on any CPU
+    SSE2_KERNELS,       //128 bit vectors, on every x86-64 CPU
+    AVX2_KERNELS,       //256 bit vectors, on Haswell and later
+    KERNEL_LEVEL_COUNT
+};
+
+class AmountKernels
+{
+    private:
+        static KernelLevel& currentLevel();
+
+    public:
+        static KernelLevel getSupportedLevel();
+        static KernelLevel getLevel();
+        static bool setLevel(KernelLevel level);
+        static const char* getLevelName(KernelLevel level);
+
+        static void ledgerBalances(const LedgerFileRecord* records, int count,
+                                   Amount* balances);
+        static Amount sumAmounts(const Amount* values, int count);
+        static void partitionBalances(const Amount* balances, int count,
+                                      std::vector<int>& winners,
+                                      std::vector<int>& losers);
+};
+
+#endif
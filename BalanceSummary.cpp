@@ -0,0 +1,651 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Implementation of the BalanceSummary class. A ledger is added
+ *              a game at a time into a table of the players it names, which is
+ *              then sorted by name and merged into the summary. Merging two
+ *              summaries walks both lists of names together, adding up the
+ *              players they share, so it only ever costs the players of the
+ *              two summaries, however many games were behind them.
+ *
+ *              A large ledger file can be summarized by several worker
+ *              processes at once. The file is cut into byte ranges, each moved
+ *              forwards to the start of a game so no game is split, and each
+ *              worker summarizes its range into a part file. The parts are
+ *              then merged in pairs, a round at a time, into the summary.
+*******************************************************************************/
+#include "BalanceSummary.hpp"
+#include "LedgerReader.hpp"
+#include "ParallelSettler.hpp"
+#include "Player.hpp"
+#include "PlayerNames.hpp"
+#include "Validation.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+//the exit status of a worker that couldn't write its part
+const int SUMMARY_WORKER_FAILED = 3;
+
+//the players of a ledger while it's being added, in the order first seen
+struct LedgerTotals{
+    std::vector<const std::string*> names;
+    std::vector<int64_t> buyIns;
+    std::vector<int64_t> finalStacks;
+};
+
+struct TotalsOrder{
+    const LedgerTotals* totals;
+
+    bool operator()(int first, int second) const {
+        return *this->totals->names[first] < *this->totals->names[second];
+    }
+};
+
+
+/*******************************************************************************
+ *               compareNames(const char*, size_t, const char*, size_t)
+ * Description: orders two names the way std::string does: byte by byte, then
+ *              shorter first
+*******************************************************************************/
+static int compareNames(const char* first, size_t firstLength,
+                        const char* second, size_t secondLength){
+    int order = std::memcmp(first, second, std::min(firstLength,
+                                                    secondLength));
+    if(order != 0){
+        return order;
+    }
+    return firstLength < secondLength ? -1 : firstLength > secondLength;
+}
+
+
+/*******************************************************************************
+ *                       addTotal(int64_t&, int64_t)
+ * Description: adds amount to total. Returns false, leaving total alone, if
+ *              the sum doesn't fit in 64 bits.
+*******************************************************************************/
+static bool addTotal(int64_t& total, int64_t amount){
+    int64_t sum;
+    if(__builtin_add_overflow(total, amount, &sum)){
+        return false;
+    }
+    total = sum;
+    return true;
+}
+
+
+/*******************************************************************************
+ *                            BalanceSummary()
+ * Description: Constructor. A new summary has no players and no games.
+*******************************************************************************/
+BalanceSummary::BalanceSummary() {
+    this->clear();
+}
+
+
+/*******************************************************************************
+ *                                 clear()
+ * Description: empties the summary
+*******************************************************************************/
+void BalanceSummary::clear() {
+    this->nameBytes.clear();
+    this->nameOffsets.assign(1, 0);
+    this->buyIns.clear();
+    this->finalStacks.clear();
+    this->gameCount = 0;
+    this->seatCount = 0;
+    this->skippedCount = 0;
+}
+
+
+/*******************************************************************************
+ *            addPlayer(const char*, size_t, int64_t, int64_t)
+ * Description: adds a player after the last one. Their name must come after
+ *              every name already in the summary.
+*******************************************************************************/
+void BalanceSummary::addPlayer(const char* name, size_t length, int64_t buyIn,
+                               int64_t finalStack) {
+    VALIDATE_CHEAP(this->buyIns.empty() ||
+                   compareNames(this->nameBytes.data() +
+                                this->nameOffsets[this->buyIns.size() - 1],
+                                this->nameBytes.size() -
+                                this->nameOffsets[this->buyIns.size() - 1],
+                                name, length) < 0);
+    this->nameBytes.append(name, length);
+    this->nameOffsets.push_back(this->nameBytes.size());
+    this->buyIns.push_back(buyIn);
+    this->finalStacks.push_back(finalStack);
+}
+
+
+/*******************************************************************************
+ *               addLedger(std::istream&, std::ostream&, std::string&)
+ * Description: Adds every game of a text ledger to the summary. A game that
+ *              couldn't be settled on its own is left out and counted as
+ *              skipped, with the reason written to log. Returns false and
+ *              sets error, leaving the summary as it was, if a player's
+ *              totals would overflow.
+*******************************************************************************/
+bool BalanceSummary::addLedger(std::istream& input, std::ostream& log,
+                               std::string& error) {
+    //players are found by their name's id in a flat array, which holds
+    //each one's index in totals plus 1, or 0 if it hasn't been seen yet
+    std::vector<int> indexes;
+    LedgerTotals totals;
+    long games = 0;
+    long seats = 0;
+    long skipped = 0;
+    bool overflow = false;
+
+    LedgerReader reader(input);
+    LedgerGame record;
+    while(reader.nextGame(record)){
+        std::string gameError;
+        if(!ParallelSettler::checkGame(record, gameError)){
+            log << "game " << record.gameId << " skipped: " << gameError
+                << "\n";
+            skipped++;
+            delete record.game;
+            continue;
+        }
+
+        const Game* game = record.game;
+        for(int i = 0; i < game->getPlayerCount(); ++i){
+            const Player* player = game->getPlayer(i);
+            uint32_t nameId = player->getNameId();
+            if(nameId >= indexes.size()){
+                indexes.resize(PlayerNames::getCount(), 0);
+            }
+            if(indexes[nameId] == 0){
+                totals.names.push_back(&player->getName());
+                totals.buyIns.push_back(0);
+                totals.finalStacks.push_back(0);
+                indexes[nameId] = totals.names.size();
+            }
+            int id = indexes[nameId] - 1;
+
+            //a game's amounts fit in an Amount, which may be wider than
+            //the totals
+            int64_t buyIn = (int64_t)player->getBuyIn();
+            int64_t finalStack = (int64_t)player->getFinalStack();
+            overflow = overflow || buyIn != player->getBuyIn() ||
+                       finalStack != player->getFinalStack() ||
+                       !addTotal(totals.buyIns[id], buyIn) ||
+                       !addTotal(totals.finalStacks[id], finalStack);
+        }
+        games++;
+        seats += game->getPlayerCount();
+        delete record.game;
+    }
+    if(overflow){
+        error = "a player's totals overflow 64 bits";
+        return false;
+    }
+
+    std::vector<int> order(totals.names.size());
+    for(int i = 0; i < order.size(); ++i){
+        order[i] = i;
+    }
+    TotalsOrder byName = { &totals };
+    std::sort(order.begin(), order.end(), byName);
+
+    BalanceSummary added;
+    for(int i = 0; i < order.size(); ++i){
+        const std::string& name = *totals.names[order[i]];
+        added.addPlayer(name.data(), name.size(), totals.buyIns[order[i]],
+                        totals.finalStacks[order[i]]);
+    }
+    added.gameCount = games;
+    added.seatCount = seats;
+    added.skippedCount = skipped;
+    return this->merge(added, error);
+}
+
+
+/*******************************************************************************
+ *           addPart(std::string, uint64_t, uint64_t, std::ostream&,
+ *                   std::string&)
+ * Description: adds the games of the ledger file at path that lie in bytes
+ *              first up to last
+*******************************************************************************/
+bool BalanceSummary::addPart(const std::string& path, uint64_t first,
+                             uint64_t last, std::ostream& log,
+                             std::string& error) {
+    std::ifstream file(path.c_str(), std::ios::binary);
+    std::string bytes(last - first, '\0');
+    file.seekg(first);
+    if(!file || !file.read(&bytes[0], bytes.size())){
+        error = "could not read " + path;
+        return false;
+    }
+    std::istringstream input(bytes);
+    return this->addLedger(input, log, error);
+}
+
+
+/*******************************************************************************
+ *                findGameStart(std::ifstream&, uint64_t, uint64_t)
+ * Description: returns where the first game starting at or after offset
+ *              begins, or size if there isn't one. A game doesn't start in
+ *              the middle of a line, or on a row with the same game_id as the
+ *              row before it.
+*******************************************************************************/
+static uint64_t findGameStart(std::ifstream& file, uint64_t offset,
+                              uint64_t size){
+    if(offset == 0){
+        return 0;
+    }
+
+    //skip the rest of the line the byte before offset is on
+    std::string line;
+    file.clear();
+    file.seekg(offset - 1);
+    std::getline(file, line);
+
+    bool haveRow = false;
+    std::string gameId;
+    uint64_t start = file.tellg();
+    while(file && start < size && std::getline(file, line)){
+        if(!line.empty() && line[line.size() - 1] == '\r'){
+            line.erase(line.size() - 1);
+        }
+        if(!line.empty() && line[0] != '#'){
+            std::string rowGameId = line.substr(0, line.find(','));
+            if(haveRow && rowGameId != gameId){
+                return start;
+            }
+            haveRow = true;
+            gameId = rowGameId;
+        }
+        start = file.tellg();
+    }
+    return size;
+}
+
+
+/*******************************************************************************
+ *       addLedgerFile(std::string, int, std::string, std::ostream&,
+ *                     std::string&)
+ * Description: Adds every game of the text ledger file at path to the summary,
+ *              as addLedger() does, on workerCount processes. Worker i writes
+ *              its summary to partPrefix followed by i, which is removed once
+ *              it's merged. With one worker, nothing is forked and path can be
+ *              "-" for stdin. Returns false and sets error if the file can't
+ *              be read, a worker fails or a player's totals overflow.
+*******************************************************************************/
+bool BalanceSummary::addLedgerFile(const std::string& path, int workerCount,
+                                   const std::string& partPrefix,
+                                   std::ostream& log, std::string& error) {
+    if(path == "-"){
+        return this->addLedger(std::cin, log, error);
+    }
+
+    std::ifstream file(path.c_str(), std::ios::binary);
+    struct stat status;
+    if(!file || stat(path.c_str(), &status) != 0){
+        error = "could not open " + path;
+        return false;
+    }
+    if(workerCount <= 1){
+        return this->addLedger(file, log, error);
+    }
+
+    //each worker takes an even share of the bytes, moved to a game's start
+    uint64_t size = status.st_size;
+    std::vector<uint64_t> starts(workerCount + 1);
+    for(int i = 0; i < workerCount; ++i){
+        starts[i] = findGameStart(file, size * i / workerCount, size);
+    }
+    starts[workerCount] = size;
+    file.close();
+
+    //the log is flushed first so the workers don't write it out again
+    log.flush();
+    std::vector<pid_t> workers(workerCount, -1);
+    for(int i = 0; i < workerCount; ++i){
+        if(starts[i] >= starts[i + 1]){
+            continue;
+        }
+        workers[i] = fork();
+        if(workers[i] == 0){
+            BalanceSummary part;
+            std::string partError;
+            bool written = part.addPart(path, starts[i], starts[i + 1], log,
+                                        partError) &&
+                           part.write(partPrefix + std::to_string(i),
+                                      partError);
+            if(!written){
+                log << partError << "\n";
+            }
+            log.flush();
+            _exit(written ? 0 : SUMMARY_WORKER_FAILED);
+        }
+        if(workers[i] < 0){
+            error = "could not start a worker";
+        }
+    }
+
+    std::vector<BalanceSummary> parts(workerCount);
+    for(int i = 0; i < workerCount; ++i){
+        if(workers[i] <= 0){
+            continue;
+        }
+        int workerStatus;
+        std::string partPath = partPrefix + std::to_string(i);
+        if(waitpid(workers[i], &workerStatus, 0) != workers[i] ||
+           !WIFEXITED(workerStatus) || WEXITSTATUS(workerStatus) != 0){
+            error = "worker " + std::to_string(i) + " failed";
+        }
+        else if(error.empty()){
+            parts[i].read(partPath, error);
+        }
+        std::remove(partPath.c_str());
+    }
+    if(!error.empty()){
+        return false;
+    }
+
+    //merged in pairs, so each round merges half as many summaries
+    for(int step = 1; step < workerCount; step *= 2){
+        for(int i = 0; i + step < workerCount; i += 2 * step){
+            if(!parts[i].merge(parts[i + step], error)){
+                return false;
+            }
+            parts[i + step].clear();
+        }
+    }
+    return this->merge(parts[0], error);
+}
+
+
+/*******************************************************************************
+ *                  merge(const BalanceSummary&, std::string&)
+ * Description: Adds another summary into this one. Merging is associative and
+ *              commutative, so summaries merged in any order make the same
+ *              summary. Returns false and sets error, leaving this summary as
+ *              it was, if a player's totals would overflow.
+*******************************************************************************/
+bool BalanceSummary::merge(const BalanceSummary& other, std::string& error) {
+    BalanceSummary merged;
+    merged.nameBytes.reserve(this->nameBytes.size() + other.nameBytes.size());
+    merged.nameOffsets.reserve(this->nameOffsets.size() +
+                               other.nameOffsets.size());
+    merged.buyIns.reserve(this->buyIns.size() + other.buyIns.size());
+    merged.finalStacks.reserve(this->finalStacks.size() +
+                               other.finalStacks.size());
+
+    int i = 0;
+    int j = 0;
+    int count = this->getPlayerCount();
+    int otherCount = other.getPlayerCount();
+    while(i < count || j < otherCount){
+        size_t length = 0;
+        size_t otherLength = 0;
+        const char* name = i < count ? this->getName(i, length) : NULL;
+        const char* otherName = j < otherCount ?
+                                other.getName(j, otherLength) : NULL;
+        int order = name == NULL ? 1 : otherName == NULL ? -1 :
+                    compareNames(name, length, otherName, otherLength);
+
+        if(order < 0){
+            merged.addPlayer(name, length, this->buyIns[i],
+                             this->finalStacks[i]);
+            ++i;
+        }
+        else if(order > 0){
+            merged.addPlayer(otherName, otherLength, other.buyIns[j],
+                             other.finalStacks[j]);
+            ++j;
+        }
+        else{
+            int64_t buyIn = this->buyIns[i];
+            int64_t finalStack = this->finalStacks[i];
+            if(!addTotal(buyIn, other.buyIns[j]) ||
+               !addTotal(finalStack, other.finalStacks[j])){
+                error = "the totals of " + std::string(name, length) +
+                        " overflow 64 bits";
+                return false;
+            }
+            merged.addPlayer(name, length, buyIn, finalStack);
+            ++i;
+            ++j;
+        }
+    }
+
+    merged.gameCount = this->gameCount + other.gameCount;
+    merged.seatCount = this->seatCount + other.seatCount;
+    merged.skippedCount = this->skippedCount + other.skippedCount;
+    std::swap(*this, merged);
+    return true;
+}
+
+
+/*******************************************************************************
+ *                       read(std::string, std::string&)
+ * Description: Replaces the summary with the one saved at path. Returns false
+ *              and sets error, leaving the summary empty, if the file can't be
+ *              read or isn't a valid summary.
+*******************************************************************************/
+bool BalanceSummary::read(const std::string& path, std::string& error) {
+    this->clear();
+    std::ifstream input(path.c_str(), std::ios::binary);
+    if(!input){
+        error = "could not open " + path;
+        return false;
+    }
+    std::string bytes((std::istreambuf_iterator<char>(input)),
+                      std::istreambuf_iterator<char>());
+    if(bytes.size() < sizeof(SummaryFileHeader)){
+        error = path + " is too short to be a summary";
+        return false;
+    }
+
+    SummaryFileHeader fileHeader;
+    std::memcpy(&fileHeader, bytes.data(), sizeof(fileHeader));
+    if(std::memcmp(fileHeader.magic, SUMMARY_FILE_MAGIC,
+                   sizeof(SUMMARY_FILE_MAGIC)) != 0){
+        error = path + " is not a summary";
+        return false;
+    }
+    if(fileHeader.byteOrder != LEDGER_FILE_BYTE_ORDER){
+        error = path + " was written with a different byte order";
+        return false;
+    }
+    if(fileHeader.version != SUMMARY_FILE_VERSION){
+        error = path + " has an unsupported summary version";
+        return false;
+    }
+    if(fileHeader.fileSize != bytes.size()){
+        error = path + " is truncated";
+        return false;
+    }
+
+    //players are indexed with ints. With at most INT_MAX of them, the
+    //sizes can't overflow
+    uint64_t playerCount = fileHeader.playerCount;
+    uint64_t tableSize = sizeof(SummaryFileHeader) +
+                         playerCount * sizeof(SummaryFileRecord) +
+                         (playerCount + 1) * sizeof(uint64_t);
+    if(playerCount > INT_MAX || tableSize > bytes.size() ||
+       fileHeader.gameCount > LONG_MAX || fileHeader.seatCount > LONG_MAX ||
+       fileHeader.skippedCount > LONG_MAX){
+        error = path + " is corrupt";
+        return false;
+    }
+
+    const char* records = bytes.data() + sizeof(SummaryFileHeader);
+    const char* offsets = records + playerCount * sizeof(SummaryFileRecord);
+    const char* names = bytes.data() + tableSize;
+    uint64_t nameSize = bytes.size() - tableSize;
+    std::vector<uint64_t> nameEnds(playerCount + 1);
+    std::memcpy(nameEnds.data(), offsets, nameEnds.size() * sizeof(uint64_t));
+
+    //names must run forwards, in order, to the end of the file, and every
+    //total must be one a ledger could have made
+    if(nameEnds[0] != 0 || nameEnds[playerCount] != nameSize){
+        error = path + " has a corrupt string table";
+        return false;
+    }
+    for(uint64_t i = 0; i < playerCount; ++i){
+        SummaryFileRecord record;
+        std::memcpy(&record, records + i * sizeof(record), sizeof(record));
+        if(nameEnds[i + 1] <= nameEnds[i] ||
+           (i > 0 && compareNames(names + nameEnds[i - 1],
+                                  nameEnds[i] - nameEnds[i - 1],
+                                  names + nameEnds[i],
+                                  nameEnds[i + 1] - nameEnds[i]) >= 0)){
+            this->clear();
+            error = path + " has a corrupt string table";
+            return false;
+        }
+        if(record.buyIn < 0 || record.finalStack < 0){
+            this->clear();
+            error = "player " + std::to_string(i) + " of " + path +
+                    " has invalid totals";
+            return false;
+        }
+        this->buyIns.push_back(record.buyIn);
+        this->finalStacks.push_back(record.finalStack);
+    }
+    this->nameBytes.assign(names, nameSize);
+    this->nameOffsets.swap(nameEnds);
+    this->gameCount = fileHeader.gameCount;
+    this->seatCount = fileHeader.seatCount;
+    this->skippedCount = fileHeader.skippedCount;
+    return true;
+}
+
+
+/*******************************************************************************
+ *                     write(std::string, std::string&) const
+ * Description: Saves the summary to path. Returns false and sets error if the
+ *              file can't be written.
+*******************************************************************************/
+bool BalanceSummary::write(const std::string& path, std::string& error) const {
+    std::ofstream output(path.c_str(), std::ios::binary | std::ios::trunc);
+    if(!output){
+        error = "could not open " + path;
+        return false;
+    }
+
+    int playerCount = this->getPlayerCount();
+    SummaryFileHeader fileHeader;
+    std::memset(&fileHeader, 0, sizeof(fileHeader));
+    std::memcpy(fileHeader.magic, SUMMARY_FILE_MAGIC,
+                sizeof(SUMMARY_FILE_MAGIC));
+    fileHeader.version = SUMMARY_FILE_VERSION;
+    fileHeader.byteOrder = LEDGER_FILE_BYTE_ORDER;
+    fileHeader.playerCount = playerCount;
+    fileHeader.gameCount = this->gameCount;
+    fileHeader.seatCount = this->seatCount;
+    fileHeader.skippedCount = this->skippedCount;
+    fileHeader.fileSize = sizeof(SummaryFileHeader) +
+                          playerCount * sizeof(SummaryFileRecord) +
+                          this->nameOffsets.size() * sizeof(uint64_t) +
+                          this->nameBytes.size();
+    output.write((const char*)&fileHeader, sizeof(fileHeader));
+
+    for(int i = 0; i < playerCount; ++i){
+        SummaryFileRecord record;
+        record.buyIn = this->buyIns[i];
+        record.finalStack = this->finalStacks[i];
+        output.write((const char*)&record, sizeof(record));
+    }
+    output.write((const char*)this->nameOffsets.data(),
+                 this->nameOffsets.size() * sizeof(uint64_t));
+    output.write(this->nameBytes.data(), this->nameBytes.size());
+
+    output.flush();
+    if(!output){
+        error = "could not write " + path;
+        return false;
+    }
+    return true;
+}
+
+
+/*******************************************************************************
+ *                     makeGame(Game&, std::string&) const
+ * Description: Adds the summary's players to game, with their totals as their
+ *              buy-ins and final stacks, so it can be settled like any game.
+ *              Returns false and sets error if the totals don't fit in an
+ *              Amount, or PlayerNames has no room for the players' names.
+*******************************************************************************/
+bool BalanceSummary::makeGame(Game& game, std::string& error) const {
+    for(int i = 0; i < this->getPlayerCount(); ++i){
+        Amount buyIn = this->buyIns[i];
+        Amount finalStack = this->finalStacks[i];
+        if(buyIn != this->buyIns[i] || finalStack != this->finalStacks[i]){
+            error = "amounts overflow the " +
+                    std::to_string(POKERCALC_AMOUNT_BITS) +
+                    " bit amount type";
+            return false;
+        }
+        size_t length;
+        const char* name = this->getName(i, length);
+        uint32_t nameId = PlayerNames::intern(name, length);
+        if(nameId == PLAYER_NAME_NONE){
+            error = "too many distinct player names, the limit is " +
+                    std::to_string(PlayerNames::getLimit());
+            return false;
+        }
+        game.addPlayer(nameId, buyIn, finalStack);
+    }
+    if(!game.amountsFit()){
+        error = "amounts overflow the " +
+                std::to_string(POKERCALC_AMOUNT_BITS) + " bit amount type";
+        return false;
+    }
+    return true;
+}
+
+
+/*******************************************************************************
+ *             getPlayerCount() / getName(int, size_t&) / getBuyIn(int)
+ *           getFinalStack(int) / getGameCount() / getSeatCount()
+ *                           getSkippedCount()
+ * Description: return the summary's players, in order of name, and what they
+ *              add up. getName() points into the summary; the name is not
+ *              null terminated.
+*******************************************************************************/
+int BalanceSummary::getPlayerCount() const {
+    return this->buyIns.size();
+}
+
+
+const char* BalanceSummary::getName(int player, size_t& length) const {
+    length = this->nameOffsets[player + 1] - this->nameOffsets[player];
+    return this->nameBytes.data() + this->nameOffsets[player];
+}
+
+
+int64_t BalanceSummary::getBuyIn(int player) const {
+    return this->buyIns[player];
+}
+
+
+int64_t BalanceSummary::getFinalStack(int player) const {
+    return this->finalStacks[player];
+}
+
+
+long BalanceSummary::getGameCount() const {
+    return this->gameCount;
+}
+
+
+long BalanceSummary::getSeatCount() const {
+    return this->seatCount;
+}
+
+
+long BalanceSummary::getSkippedCount() const {
+    return this->skippedCount;
+}
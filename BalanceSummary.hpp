@@ -0,0 +1,99 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Header file for the BalanceSummary class. A BalanceSummary is
+ *              what a part of a league's ledger adds up to: for every player
+ *              named in it, their buy-ins and final stacks over every game,
+ *              along with how many games and seats it covers. Summaries of
+ *              different parts can be made apart, by different processes or
+ *              machines, and merged in any order and any grouping into the
+ *              summary of the whole ledger, which is then settled as one
+ *              game. Only the summaries, one record per player, ever need to
+ *              be moved between them.
+ *
+ *              Players are kept in order of name, so a merge is one pass over
+ *              both summaries and the same players in any order always make
+ *              the same summary. A summary is saved as:
+ *
+ *                  header       - SummaryFileHeader
+ *                  records      - playerCount SummaryFileRecords
+ *                  string table - playerCount + 1 uint64 offsets into the
+ *                                 name bytes, then the name bytes themselves
+ *
+ *              Numbers are stored in the byte order of the machine that wrote
+ *              them, which is checked when the file is read.
+*******************************************************************************/
+#ifndef BALANCESUMMARY_HPP
+#define BALANCESUMMARY_HPP
+
+#include <stdint.h>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "BinaryLedger.hpp"
+#include "Game.hpp"
+
+const char SUMMARY_FILE_MAGIC[8] = {'P', 'K', 'R', 'S', 'U', 'M', 'M', 'Y'};
+const uint32_t SUMMARY_FILE_VERSION = 1;
+
+struct SummaryFileHeader{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;     //LEDGER_FILE_BYTE_ORDER as the writer saw it
+    uint64_t playerCount;
+    uint64_t gameCount;
+    uint64_t seatCount;
+    uint64_t skippedCount;  //games left out because they couldn't be settled
+    uint64_t fileSize;
+};
+
+struct SummaryFileRecord{
+    int64_t buyIn;
+    int64_t finalStack;
+};
+
+static_assert(sizeof(SummaryFileHeader) == 56, "unexpected header padding");
+static_assert(sizeof(SummaryFileRecord) == 16, "unexpected record padding");
+
+class BalanceSummary
+{
+    private:
+        //player i's name is nameBytes[nameOffsets[i]] up to
+        //nameOffsets[i + 1]. Names are in increasing order
+        std::string nameBytes;
+        std::vector<uint64_t> nameOffsets;
+        std::vector<int64_t> buyIns;
+        std::vector<int64_t> finalStacks;
+        long gameCount;
+        long seatCount;
+        long skippedCount;
+
+        void addPlayer(const char* name, size_t length, int64_t buyIn,
+                       int64_t finalStack);
+        bool addPart(const std::string& path, uint64_t first, uint64_t last,
+                     std::ostream& log, std::string& error);
+
+    public:
+        BalanceSummary();
+        void clear();
+        bool addLedger(std::istream& input, std::ostream& log,
+                       std::string& error);
+        bool addLedgerFile(const std::string& path, int workerCount,
+                           const std::string& partPrefix, std::ostream& log,
+                           std::string& error);
+        bool merge(const BalanceSummary& other, std::string& error);
+        bool read(const std::string& path, std::string& error);
+        bool write(const std::string& path, std::string& error) const;
+        bool makeGame(Game& game, std::string& error) const;
+
+        int getPlayerCount() const;
+        const char* getName(int player, size_t& length) const;
+        int64_t getBuyIn(int player) const;
+        int64_t getFinalStack(int player) const;
+        long getGameCount() const;
+        long getSeatCount() const;
+        long getSkippedCount() const;
+};
+
+#endif
@@ -0,0 +1,180 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Implementation of the BatchSettler class. Each game is checked
+ *              to make sure it is balanced, solved with the same PlayerGraph
+ *              used by Game::endGame(), and its payments are written with a
+ *              SettlementWriter, by default as CSV rows:
+ *
+ *                  game_id,payer,payee,amount
+ *
+ *              Problems with a game are reported on the log stream and the
+ *              game is skipped. At most BATCH_CHUNK_GAMES games are in memory
+ *              at once.
+*******************************************************************************/
+#include "BatchSettler.hpp"
+#include "Metrics.hpp"
+#include <chrono>
+#include <vector>
+
+
+/*******************************************************************************
+ *                  BatchSettler(std::istream&, std::ostream&,
+ *                               std::ostream&, SolverType, int, OutputFormat)
+ * Description: Constructor. Takes the stream the ledger is read from, the
+ *              stream the payments are written to, the stream errors and
+ *              statistics are reported on, the algorithm games are solved
+ *              with, the number of threads to solve them on, and the format
+ *              the payments are written in.
+*******************************************************************************/
+BatchSettler::BatchSettler(std::istream& input, std::ostream& output,
+                           std::ostream& log, SolverType solver,
+                           int threadCount, OutputFormat format) 
+    : input(input), output(output), log(log), solver(solver),
+      threadCount(threadCount), format(format) {
+    this->allowed = NULL;
+    this->objective = FEWEST_PAYMENTS;
+    this->maxPayments = 0;
+    this->cache = NULL;
+    this->gamesSettled = 0;
+    this->gamesSkipped = 0;
+    this->playersSettled = 0;
+    this->paymentsWritten = 0;
+    this->elapsedSeconds = 0.0;
+}
+
+
+/*******************************************************************************
+ *          setAllowedPayments(const AllowedPayments*, SettlementObjective)
+ * Description: settles the games with only the allowed payments, keeping the
+ *              objective down, instead of with the solver
+*******************************************************************************/
+void BatchSettler::setAllowedPayments(const AllowedPayments* allowed,
+                                      SettlementObjective objective) {
+    this->allowed = allowed;
+    this->objective = objective;
+}
+
+
+/*******************************************************************************
+ *                           setMaxPayments(int)
+ * Description: settles the games so that no player makes and receives more
+ *              than maxPayments payments, instead of with the solver. 0 lifts
+ *              the limit.
+*******************************************************************************/
+void BatchSettler::setMaxPayments(int maxPayments) {
+    this->maxPayments = maxPayments;
+}
+
+
+/*******************************************************************************
+ *                        setCache(SettlementCache*)
+ * Description: settles the games the solver would through the cache, which
+ *              must outlive the run. NULL solves every game afresh.
+*******************************************************************************/
+void BatchSettler::setCache(SettlementCache* cache) {
+    this->cache = cache;
+}
+
+
+/*******************************************************************************
+ *                                 run()
+ * Description: Settles every game in the ledger. Games are read a chunk at a
+ *              time, the chunk is settled in parallel, and its payments are
+ *              written in input order before the next chunk is read. Returns
+ *              0 if every game was settled and 1 if any game had to be
+ *              skipped.
+*******************************************************************************/
+int BatchSettler::run() {
+    LedgerReader reader(this->input);
+    ParallelSettler settler(this->threadCount, this->solver);
+    settler.setAllowedPayments(this->allowed, this->objective);
+    settler.setMaxPayments(this->maxPayments);
+    settler.setCache(this->cache);
+    SettlementWriter writer(this->output, this->format);
+    std::vector<LedgerGame> games;
+    std::vector<GameSettlement> results;
+    LedgerGame record;
+    bool moreGames = true;
+
+    std::chrono::steady_clock::time_point start = 
+        std::chrono::steady_clock::now();
+
+    games.reserve(BATCH_CHUNK_GAMES);
+    while(moreGames){
+        games.clear();
+        while(games.size() < BATCH_CHUNK_GAMES && 
+              (moreGames = reader.nextGame(record))){
+            games.push_back(record);
+        }
+
+        settler.settleGames(games, results);
+
+        for(int i = 0; i < games.size(); ++i){
+            this->writeSettlement(writer, games.at(i), results.at(i));
+            delete games.at(i).game;
+        }
+    }
+    writer.finish();
+
+    std::chrono::duration<double> elapsed = 
+        std::chrono::steady_clock::now() - start;
+    this->elapsedSeconds = elapsed.count();
+
+    if(this->gamesSkipped > 0){
+        return 1;
+    }
+    return 0;
+}
+
+
+/*******************************************************************************
+ *                   writeSettlement(SettlementWriter&, const LedgerGame&,
+ *                                   const GameSettlement&)
+ * Description: Writes a settled game's payments with the writer, or reports
+ *              why it was skipped on the log stream.
+*******************************************************************************/
+void BatchSettler::writeSettlement(SettlementWriter& writer,
+                                   const LedgerGame& record,
+                                   const GameSettlement& result) {
+    if(!result.error.empty()){
+        this->log << "game " << record.gameId << " skipped: "
+                  << result.error << "\n";
+        this->gamesSkipped++;
+        return;
+    }
+
+    METRICS_TIME_PHASE(WRITE_PAYMENTS_PHASE);
+    writer.writeGame(record.gameId, result.payments);
+
+    this->gamesSettled++;
+    this->playersSettled += record.game->getPlayerCount();
+    this->paymentsWritten += result.payments.size();
+}
+
+
+/*******************************************************************************
+ *                               printStats()
+ * Description: Reports how many games were settled and how quickly on the log
+ *              stream.
+*******************************************************************************/
+void BatchSettler::printStats() const {
+    double gamesPerSecond = 0.0;
+    if(this->elapsedSeconds > 0.0){
+        gamesPerSecond = this->gamesSettled / this->elapsedSeconds;
+    }
+
+    this->log << "settled " << this->gamesSettled << " games ("
+              << this->playersSettled << " players, "
+              << this->paymentsWritten << " payments), skipped "
+              << this->gamesSkipped << " games in "
+              << this->elapsedSeconds << " s on " << this->threadCount 
+              << " threads: " << gamesPerSecond << " games/sec" << std::endl;
+    if(this->cache != NULL){
+        this->log << "settlement cache: " << this->cache->getHits()
+                  << " hits, " << this->cache->getMisses() << " misses, "
+                  << this->cache->getEvictions() << " evictions, "
+                  << this->cache->getEntryCount() << " shapes in "
+                  << this->cache->getBytesUsed() << " bytes" << std::endl;
+    }
+}
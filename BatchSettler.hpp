@@ -0,0 +1,60 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Header file for the BatchSettler class. A BatchSettler settles
+ *              every game in a ledger without any user interaction. Games are
+ *              read a chunk at a time, solved with a ParallelSettler, and
+ *              written out in the order they were read, and the number of
+ *              games settled per second is reported when the run is finished.
+*******************************************************************************/
+#ifndef BATCHSETTLER_HPP
+#define BATCHSETTLER_HPP
+
+#include <istream>
+#include <ostream>
+#include "AllowedPayments.hpp"
+#include "LedgerReader.hpp"
+#include "ParallelSettler.hpp"
+#include "SettlementWriter.hpp"
+#include "Structs.hpp"
+
+//most games held in memory at once
+const int BATCH_CHUNK_GAMES = 4096;
+
+class BatchSettler
+{
+    private:
+        std::istream& input;
+        std::ostream& output;
+        std::ostream& log;
+        SolverType solver;
+        int threadCount;
+        OutputFormat format;
+        const AllowedPayments* allowed;
+        SettlementObjective objective;
+        int maxPayments;
+        SettlementCache* cache;
+        long gamesSettled;
+        long gamesSkipped;
+        long playersSettled;
+        long paymentsWritten;
+        double elapsedSeconds;
+
+        void writeSettlement(SettlementWriter& writer,
+                             const LedgerGame& record,
+                             const GameSettlement& result);
+
+    public:
+        BatchSettler(std::istream& input, std::ostream& output,
+                     std::ostream& log, SolverType solver = GREEDY_SOLVER,
+                     int threadCount = 1,
+                     OutputFormat format = CSV_FORMAT);
+        void setAllowedPayments(const AllowedPayments* allowed,
+                                SettlementObjective objective);
+        void setMaxPayments(int maxPayments);
+        void setCache(SettlementCache* cache);
+        int run();
+        void printStats() const;
+};
+
+#endif
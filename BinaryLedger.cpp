@@ -0,0 +1,389 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Implementation of the BinaryLedger class. Opening a ledger maps
+ *              the whole file read-only and checks that every section fits
+ *              inside it, every record names a real string and every amount is
+ *              within the limits the text ledger enforces. After that the
+ *              records and names are read straight out of the mapping.
+*******************************************************************************/
+#include "BinaryLedger.hpp"
+#include "PlayerGraph.hpp"
+#include "Player.hpp"
+#include "helperFunctions.hpp"
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+/*******************************************************************************
+ *                              BinaryLedger()
+ * Description: Constructor. No file is open until open() is called.
+*******************************************************************************/
+BinaryLedger::BinaryLedger() {
+    this->data = NULL;
+    this->size = 0;
+    this->header = NULL;
+    this->records = NULL;
+    this->payments = NULL;
+    this->nameOffsets = NULL;
+    this->names = NULL;
+    this->totalBuyIns = 0;
+    this->totalFinalStacks = 0;
+}
+
+
+/*******************************************************************************
+ *                              ~BinaryLedger()
+ * Description: Destructor. Unmaps the file if one is open.
+*******************************************************************************/
+BinaryLedger::~BinaryLedger() {
+    this->close();
+}
+
+
+/*******************************************************************************
+ *                                 close()
+ * Description: Unmaps the open file, if there is one. Anything read from it,
+ *              including a PlayerGraph built from it, is no longer valid.
+*******************************************************************************/
+void BinaryLedger::close() {
+    if(this->data != NULL){
+        munmap((void*)this->data, this->size);
+    }
+    this->data = NULL;
+    this->size = 0;
+    this->header = NULL;
+    this->records = NULL;
+    this->payments = NULL;
+    this->nameOffsets = NULL;
+    this->names = NULL;
+    this->totalBuyIns = 0;
+    this->totalFinalStacks = 0;
+}
+
+
+/*******************************************************************************
+ *                           fail(std::string)
+ * Description: records why the ledger couldn't be opened, closes it, and
+ *              returns false
+*******************************************************************************/
+bool BinaryLedger::fail(const std::string& message) {
+    this->error = message;
+    this->close();
+    return false;
+}
+
+
+/*******************************************************************************
+ *                          open(std::string)
+ * Description: Maps the ledger at path and validates it. Returns false and
+ *              sets the error if the file can't be read or isn't a valid
+ *              ledger.
+*******************************************************************************/
+bool BinaryLedger::open(const std::string& path) {
+    this->close();
+    this->error.clear();
+
+    //opened through stdio, since unistd.h's pause() clashes with the one in
+    //helperFunctions.hpp
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if(file == NULL){
+        return this->fail("could not open " + path);
+    }
+
+    struct stat status;
+    if(fstat(fileno(file), &status) != 0 ||
+       status.st_size < sizeof(LedgerFileHeader)){
+        std::fclose(file);
+        return this->fail(path + " is too short to be a binary ledger");
+    }
+
+    void* mapping = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE,
+                         fileno(file), 0);
+    std::fclose(file);
+    if(mapping == MAP_FAILED){
+        return this->fail("could not map " + path);
+    }
+
+    //the records are read front to back
+    madvise(mapping, status.st_size, MADV_SEQUENTIAL);
+    this->data = (const char*)mapping;
+    this->size = status.st_size;
+    return this->validate();
+}
+
+
+/*******************************************************************************
+ *                               validate()
+ * Description: Checks the header, the layout of the sections and every record
+ *              and payment, and sets up the section pointers. Returns false
+ *              and sets the error on the first problem found.
+*******************************************************************************/
+bool BinaryLedger::validate() {
+    const LedgerFileHeader* fileHeader = (const LedgerFileHeader*)this->data;
+    if(std::memcmp(fileHeader->magic, LEDGER_FILE_MAGIC,
+                   sizeof(LEDGER_FILE_MAGIC)) != 0){
+        return this->fail("not a binary ledger");
+    }
+    if(fileHeader->byteOrder != LEDGER_FILE_BYTE_ORDER){
+        return this->fail("ledger was written with a different byte order");
+    }
+    if(fileHeader->version != LEDGER_FILE_VERSION){
+        return this->fail("unsupported ledger version");
+    }
+    if(fileHeader->fileSize != this->size){
+        return this->fail("ledger is truncated");
+    }
+
+    //the graph indexes players with ints
+    uint64_t recordCount = fileHeader->recordCount;
+    uint64_t paymentCount = fileHeader->paymentCount;
+    uint64_t nameCount = fileHeader->nameCount;
+    if(recordCount > INT_MAX || paymentCount > INT_MAX || nameCount > INT_MAX){
+        return this->fail("ledger has too many players");
+    }
+
+    //each section must be aligned for its type and inside the file. The
+    //counts are at most INT_MAX, so none of the sizes can overflow
+    if(fileHeader->recordsOffset % 8 != 0 ||
+       fileHeader->recordsOffset > this->size ||
+       recordCount * sizeof(LedgerFileRecord) >
+       this->size - fileHeader->recordsOffset){
+        return this->fail("ledger records are out of bounds");
+    }
+    if(fileHeader->paymentsOffset % 8 != 0 ||
+       fileHeader->paymentsOffset > this->size ||
+       paymentCount * sizeof(LedgerFilePayment) >
+       this->size - fileHeader->paymentsOffset){
+        return this->fail("ledger payments are out of bounds");
+    }
+    if(fileHeader->namesOffset % 8 != 0 ||
+       fileHeader->namesOffset > this->size ||
+       (nameCount + 1) * sizeof(uint64_t) >
+       this->size - fileHeader->namesOffset){
+        return this->fail("ledger string table is out of bounds");
+    }
+
+    this->header = fileHeader;
+    this->records = (const LedgerFileRecord*)
+                    (this->data + fileHeader->recordsOffset);
+    this->payments = (const LedgerFilePayment*)
+                     (this->data + fileHeader->paymentsOffset);
+    this->nameOffsets = (const uint64_t*)(this->data + fileHeader->namesOffset);
+    this->names = (const char*)(this->nameOffsets + nameCount + 1);
+
+    //name offsets must run forwards and stay inside the file
+    uint64_t nameBytes = this->size - (this->names - this->data);
+    if(this->nameOffsets[0] != 0){
+        return this->fail("ledger string table is corrupt");
+    }
+    for(uint64_t i = 0; i < nameCount; ++i){
+        if(this->nameOffsets[i + 1] < this->nameOffsets[i] ||
+           this->nameOffsets[i + 1] > nameBytes){
+            return this->fail("ledger string table is corrupt");
+        }
+    }
+
+    //the same limits the text ledger puts on each row. The totals are
+    //tallied on the way, since the records are being read anyway; with at
+    //most INT_MAX records of at most INT_MAX each, they can't overflow
+    int64_t buyIns = 0;
+    int64_t finalStacks = 0;
+    for(uint64_t i = 0; i < recordCount; ++i){
+        const LedgerFileRecord& record = this->records[i];
+        if(record.id >= nameCount){
+            return this->fail("record " + std::to_string(i) +
+                              " names a player that isn't in the ledger");
+        }
+        uint64_t nameLength = this->nameOffsets[record.id + 1] -
+                              this->nameOffsets[record.id];
+        if(nameLength <= MIN_NAME_LENGTH || nameLength >= MAX_NAME_LENGTH){
+            return this->fail("record " + std::to_string(i) +
+                              " has an invalid player name");
+        }
+        if(record.buyIn < MIN_STACK || record.buyIn > INT_MAX){
+            return this->fail("record " + std::to_string(i) +
+                              " has an invalid buy-in");
+        }
+        if(record.finalStack < MIN_STACK || record.finalStack > MAX_STACK){
+            return this->fail("record " + std::to_string(i) +
+                              " has an invalid final stack");
+        }
+        buyIns += record.buyIn;
+        finalStacks += record.finalStack;
+    }
+    this->totalBuyIns = buyIns;
+    this->totalFinalStacks = finalStacks;
+    for(uint64_t i = 0; i < paymentCount; ++i){
+        const LedgerFilePayment& payment = this->payments[i];
+        if(payment.payer >= recordCount || payment.payee >= recordCount ||
+           payment.amount <= 0){
+            return this->fail("payment " + std::to_string(i) + " is invalid");
+        }
+    }
+
+    return true;
+}
+
+
+/*******************************************************************************
+ *                               getError()
+ * Description: returns why the last call to open() failed
+*******************************************************************************/
+const std::string& BinaryLedger::getError() const {
+    return this->error;
+}
+
+
+/*******************************************************************************
+ *          getRecordCount() / getRecord(int) / getRecords()
+ *                  getPaymentCount() / getPayment(int)
+ * Description: return the ledger's records and payments, read in place.
+ *              getRecords() points at the first of the records, which are
+ *              contiguous.
+*******************************************************************************/
+int BinaryLedger::getRecordCount() const {
+    return this->header == NULL ? 0 : this->header->recordCount;
+}
+
+
+const LedgerFileRecord& BinaryLedger::getRecord(int record) const {
+    return this->records[record];
+}
+
+
+const LedgerFileRecord* BinaryLedger::getRecords() const {
+    return this->records;
+}
+
+
+int BinaryLedger::getPaymentCount() const {
+    return this->header == NULL ? 0 : this->header->paymentCount;
+}
+
+
+const LedgerFilePayment& BinaryLedger::getPayment(int payment) const {
+    return this->payments[payment];
+}
+
+
+/*******************************************************************************
+ *              getTotalBuyIns() / getTotalFinalStacks()
+ * Description: return the sums of the records' buy-ins and final stacks,
+ *              tallied when the ledger was opened
+*******************************************************************************/
+int64_t BinaryLedger::getTotalBuyIns() const {
+    return this->totalBuyIns;
+}
+
+
+int64_t BinaryLedger::getTotalFinalStacks() const {
+    return this->totalFinalStacks;
+}
+
+
+/*******************************************************************************
+ *                         getName(uint32_t, size_t&)
+ *                         getName(uint32_t)
+ * Description: return the name with the given id. The first version points
+ *              into the mapping itself; the name is not null terminated.
+*******************************************************************************/
+const char* BinaryLedger::getName(uint32_t id, size_t& length) const {
+    length = this->nameOffsets[id + 1] - this->nameOffsets[id];
+    return this->names + this->nameOffsets[id];
+}
+
+
+std::string BinaryLedger::getName(uint32_t id) const {
+    size_t length;
+    const char* name = this->getName(id, length);
+    return std::string(name, length);
+}
+
+
+/*******************************************************************************
+ *             write(std::string, const PlayerGraph&, std::string&)
+ * Description: Writes a binary ledger of the graph's players to path, along
+ *              with the graph's payments if it has been solved. Record i is
+ *              node i of the graph and names string i. Returns false and sets
+ *              error if the file can't be written.
+*******************************************************************************/
+bool BinaryLedger::write(const std::string& path, const PlayerGraph& graph,
+                         std::string& error) {
+    std::ofstream output(path.c_str(), std::ios::binary | std::ios::trunc);
+    if(!output){
+        error = "could not open " + path;
+        return false;
+    }
+
+    int nodeCount = graph.getNodeCount();
+    int edgeCount = graph.getEdgeCount();
+
+    LedgerFileHeader fileHeader;
+    std::memset(&fileHeader, 0, sizeof(fileHeader));
+    std::memcpy(fileHeader.magic, LEDGER_FILE_MAGIC, sizeof(LEDGER_FILE_MAGIC));
+    fileHeader.version = LEDGER_FILE_VERSION;
+    fileHeader.byteOrder = LEDGER_FILE_BYTE_ORDER;
+    fileHeader.recordCount = nodeCount;
+    fileHeader.paymentCount = edgeCount;
+    fileHeader.nameCount = nodeCount;
+    fileHeader.recordsOffset = sizeof(LedgerFileHeader);
+    fileHeader.paymentsOffset = fileHeader.recordsOffset +
+                                nodeCount * sizeof(LedgerFileRecord);
+    fileHeader.namesOffset = fileHeader.paymentsOffset +
+                             edgeCount * sizeof(LedgerFilePayment);
+
+    //the string table's offsets are known before any name is written
+    std::vector<uint64_t> nameOffsets(nodeCount + 1);
+    nameOffsets[0] = 0;
+    size_t nameLength;
+    for(int i = 0; i < nodeCount; ++i){
+        graph.getPlayerName(i, nameLength);
+        nameOffsets[i + 1] = nameOffsets[i] + nameLength;
+    }
+    fileHeader.fileSize = fileHeader.namesOffset +
+                          nameOffsets.size() * sizeof(uint64_t) +
+                          nameOffsets[nodeCount];
+    output.write((const char*)&fileHeader, sizeof(fileHeader));
+
+    for(int i = 0; i < nodeCount; ++i){
+        LedgerFileRecord record;
+        record.id = i;
+        record.reserved = 0;
+        record.buyIn = graph.getPlayerBuyIn(i);
+        record.finalStack = graph.getPlayerFinalStack(i);
+        output.write((const char*)&record, sizeof(record));
+    }
+
+    const std::vector<int>& offsets = graph.getEdgeOffsets();
+    const std::vector<int>& payees = graph.getEdgePayees();
+    const std::vector<Amount>& amounts = graph.getEdgeAmounts();
+    for(int i = 0; i < nodeCount; ++i){
+        for(int j = offsets[i]; j < offsets[i + 1]; ++j){
+            LedgerFilePayment payment;
+            payment.payer = i;
+            payment.payee = payees[j];
+            payment.amount = amounts[j];
+            output.write((const char*)&payment, sizeof(payment));
+        }
+    }
+
+    output.write((const char*)nameOffsets.data(),
+                 nameOffsets.size() * sizeof(uint64_t));
+    for(int i = 0; i < nodeCount; ++i){
+        const char* name = graph.getPlayerName(i, nameLength);
+        output.write(name, nameLength);
+    }
+
+    output.flush();
+    if(!output){
+        error = "could not write " + path;
+        return false;
+    }
+    return true;
+}
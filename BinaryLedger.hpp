@@ -0,0 +1,103 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Header file for the BinaryLedger class. A binary ledger holds
+ *              one game, possibly with millions of players, in a form that can
+ *              be memory mapped and read in place, without parsing a line or
+ *              allocating a Player. A file is laid out as:
+ *
+ *                  header       - LedgerFileHeader
+ *                  records      - recordCount LedgerFileRecords
+ *                  payments     - paymentCount LedgerFilePayments
+ *                  string table - nameCount + 1 uint64 offsets into the
+ *                                 name bytes, then the name bytes themselves
+ *
+ *              A record's id is the index of its player's name in the string
+ *              table. Payments refer to records by index, and are only there
+ *              when the ledger was written from a settled PlayerGraph. Numbers
+ *              are stored in the byte order of the machine that wrote them,
+ *              which is checked when the file is opened.
+*******************************************************************************/
+#ifndef BINARYLEDGER_HPP
+#define BINARYLEDGER_HPP
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+#include "Amount.hpp"
+
+class PlayerGraph;
+
+const char LEDGER_FILE_MAGIC[8] = {'P', 'K', 'R', 'L', 'E', 'D', 'G', 'R'};
+const uint32_t LEDGER_FILE_VERSION = 1;
+const uint32_t LEDGER_FILE_BYTE_ORDER = 0x01020304;
+
+struct LedgerFileHeader{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t recordCount;
+    uint64_t paymentCount;
+    uint64_t nameCount;
+    uint64_t recordsOffset;
+    uint64_t paymentsOffset;
+    uint64_t namesOffset;
+    uint64_t fileSize;
+};
+
+struct LedgerFileRecord{
+    uint32_t id;
+    uint32_t reserved;      //always 0, keeps the amounts 8 byte aligned
+    int64_t buyIn;
+    int64_t finalStack;
+};
+
+struct LedgerFilePayment{
+    uint32_t payer;
+    uint32_t payee;
+    int64_t amount;
+};
+
+static_assert(sizeof(LedgerFileHeader) == 72, "unexpected header padding");
+static_assert(sizeof(LedgerFileRecord) == 24, "unexpected record padding");
+static_assert(sizeof(LedgerFilePayment) == 16, "unexpected payment padding");
+
+class BinaryLedger
+{
+    private:
+        const char* data;       //the mapped file, NULL if none is open
+        size_t size;
+        const LedgerFileHeader* header;
+        const LedgerFileRecord* records;
+        const LedgerFilePayment* payments;
+        const uint64_t* nameOffsets;
+        const char* names;
+        int64_t totalBuyIns;        //tallied while the records are validated
+        int64_t totalFinalStacks;
+        std::string error;
+
+        bool fail(const std::string& message);
+        bool validate();
+
+    public:
+        BinaryLedger();
+        ~BinaryLedger();
+        bool open(const std::string& path);
+        void close();
+        const std::string& getError() const;
+
+        int getRecordCount() const;
+        const LedgerFileRecord& getRecord(int record) const;
+        const LedgerFileRecord* getRecords() const;
+        int64_t getTotalBuyIns() const;
+        int64_t getTotalFinalStacks() const;
+        int getPaymentCount() const;
+        const LedgerFilePayment& getPayment(int payment) const;
+        const char* getName(uint32_t id, size_t& length) const;
+        std::string getName(uint32_t id) const;
+
+        static bool write(const std::string& path, const PlayerGraph& graph,
+                          std::string& error);
+};
+
+#endif
@@ -0,0 +1,367 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Implementation of the ClubSettler class. Settling is done in
+ *              three passes over the seats:
+ *
+ *              1. the tables are split into ranges, and each range's tables
+ *                 are checked and their seats sorted into shards by the hash
+ *                 of the player's name
+ *              2. each shard's seats are gathered by name id into players,
+ *                 adding up their buy-ins and final stacks
+ *              3. the shards' players are numbered one after another and made
+ *                 the club game's players, and each seat is filed under its
+ *                 player for the drill-down
+ *
+ *              The first two passes are tasks on the ThreadPool. A range only
+ *              writes its own seat lists and a shard only its own totals, so
+ *              nothing is locked. The seats of a shard are gathered range by
+ *              range, so players are numbered the same way, and the club is
+ *              settled the same way, for any thread count.
+*******************************************************************************/
+#include "ClubSettler.hpp"
+#include "PlayerNames.hpp"
+#include <algorithm>
+#include <functional>
+
+//tasks per worker thread the tables are split into
+const int CLUB_TASKS_PER_THREAD = 8;
+
+
+/*******************************************************************************
+ *                       ClubSettler(int, SolverType)
+ * Description: Constructor. Takes the number of threads to gather the tables
+ *              on and the algorithm to settle the club game with. With one
+ *              thread, everything is done on the calling thread.
+*******************************************************************************/
+ClubSettler::ClubSettler(int threadCount, SolverType solver) {
+    this->solver = solver;
+    this->allowed = NULL;
+    this->objective = FEWEST_PAYMENTS;
+    this->maxPayments = 0;
+    this->seatCount = 0;
+    this->pool = NULL;
+    if(threadCount > 1){
+        this->pool = new ThreadPool(threadCount);
+    }
+}
+
+
+/*******************************************************************************
+ *                              ~ClubSettler()
+ * Description: Destructor. Stops the thread pool and frees the tables.
+*******************************************************************************/
+ClubSettler::~ClubSettler() {
+    delete this->pool;
+    for(int i = 0; i < this->tables.size(); ++i){
+        delete this->tables[i].game;
+    }
+}
+
+
+/*******************************************************************************
+ *          setAllowedPayments(const AllowedPayments*, SettlementObjective)
+ *                           setMaxPayments(int)
+ * Description: settle the club game with only the allowed payments, or with
+ *              no member making and receiving more than maxPayments payments,
+ *              as ParallelSettler does for a game of a batch
+*******************************************************************************/
+void ClubSettler::setAllowedPayments(const AllowedPayments* allowed,
+                                     SettlementObjective objective) {
+    this->allowed = allowed;
+    this->objective = objective;
+}
+
+
+void ClubSettler::setMaxPayments(int maxPayments) {
+    this->maxPayments = maxPayments;
+}
+
+
+/*******************************************************************************
+ *                       addTable(const LedgerGame&)
+ * Description: adds a table to the club. The ClubSettler takes ownership of
+ *              the table's game.
+*******************************************************************************/
+void ClubSettler::addTable(const LedgerGame& table) {
+    this->tables.push_back(table);
+}
+
+
+/*******************************************************************************
+ *          runTasks(int, void (ClubSettler::*)(int, int), int)
+ * Description: calls task(i, argument) for every i less than taskCount, on
+ *              the pool if there is one, and returns once they're all done
+*******************************************************************************/
+void ClubSettler::runTasks(int taskCount,
+                           void (ClubSettler::*task)(int, int),
+                           int argument) {
+    if(this->pool == NULL){
+        for(int i = 0; i < taskCount; ++i){
+            (this->*task)(i, argument);
+        }
+        return;
+    }
+
+    for(int i = 0; i < taskCount; ++i){
+        this->pool->submit(std::bind(task, this, i, argument));
+    }
+    this->pool->wait();
+}
+
+
+/*******************************************************************************
+ *                        gatherRange(int, int)
+ * Description: the first pass for one range of the tables. A table that
+ *              can't be settled on its own is left out of the club, with the
+ *              reason kept as its error.
+*******************************************************************************/
+void ClubSettler::gatherRange(int range, int rangeCount) {
+    int tableCount = this->tables.size();
+    int first = (long)tableCount * range / rangeCount;
+    int last = (long)tableCount * (range + 1) / rangeCount;
+    std::vector<ClubSeat>* seats = &this->rangeSeats[range * CLUB_SHARDS];
+    std::hash<std::string> hashName;
+
+    for(int t = first; t < last; ++t){
+        if(!ParallelSettler::checkGame(this->tables[t],
+                                       this->tableErrors[t])){
+            continue;
+        }
+
+        const Game* game = this->tables[t].game;
+        for(int i = 0; i < game->getPlayerCount(); ++i){
+            ClubSeat seat = { t, i };
+            int shard = hashName(game->getPlayer(i)->getName()) % CLUB_SHARDS;
+            seats[shard].push_back(seat);
+        }
+    }
+}
+
+
+/*******************************************************************************
+ *                          totalShard(int, int)
+ * Description: the second pass for one shard: gathers its seats by name id,
+ *              range by range, adding up each player's buy-ins and final
+ *              stacks over every table they sat at
+*******************************************************************************/
+void ClubSettler::totalShard(int shardIndex, int rangeCount) {
+    Shard& shard = this->shards[shardIndex];
+    shard.overflow = false;
+
+    for(int r = 0; r < rangeCount; ++r){
+        const std::vector<ClubSeat>& seats =
+            this->rangeSeats[r * CLUB_SHARDS + shardIndex];
+        for(int i = 0; i < seats.size(); ++i){
+            const Player* player =
+                this->tables[seats[i].table].game->getPlayer(seats[i].player);
+            int& member = this->shardMembers[player->getNameId()];
+            if(member < 0){
+                member = shard.nameIds.size();
+                shard.nameIds.push_back(player->getNameId());
+                shard.buyIns.push_back(0);
+                shard.finalStacks.push_back(0);
+            }
+            if(!addAmounts(shard.buyIns[member], player->getBuyIn(),
+                           shard.buyIns[member]) ||
+               !addAmounts(shard.finalStacks[member], player->getFinalStack(),
+                           shard.finalStacks[member])){
+                shard.overflow = true;
+            }
+            shard.seatMembers.push_back(member);
+        }
+    }
+}
+
+
+/*******************************************************************************
+ *                          makeClub(std::string&)
+ * Description: the third pass: numbers the shards' players one shard after
+ *              another, adds them to the club game, and files every seat
+ *              under its player. Returns false and sets error if the club's
+ *              totals don't fit in an Amount.
+*******************************************************************************/
+bool ClubSettler::makeClub(std::string& error) {
+    bool overflow = false;
+    std::vector<int> shardFirsts(CLUB_SHARDS + 1, 0);
+    for(int s = 0; s < CLUB_SHARDS; ++s){
+        const Shard& shard = this->shards[s];
+        shardFirsts[s + 1] = shardFirsts[s] + shard.nameIds.size();
+        for(int m = 0; m < shard.nameIds.size(); ++m){
+            this->club.addPlayer(shard.nameIds[m], shard.buyIns[m],
+                                 shard.finalStacks[m]);
+        }
+        overflow = overflow || shard.overflow;
+    }
+    int memberCount = shardFirsts[CLUB_SHARDS];
+    if(overflow || !this->club.amountsFit()){
+        error = "the club's amounts overflow the " +
+                std::to_string(POKERCALC_AMOUNT_BITS) + " bit amount type";
+        return false;
+    }
+
+    //a counting sort of the seats by member. Each shard's seats are in table
+    //order, so each member's are too
+    this->memberSeatOffsets.assign(memberCount + 1, 0);
+    for(int s = 0; s < CLUB_SHARDS; ++s){
+        const std::vector<int>& seatMembers = this->shards[s].seatMembers;
+        for(int i = 0; i < seatMembers.size(); ++i){
+            this->memberSeatOffsets[shardFirsts[s] + seatMembers[i] + 1]++;
+        }
+    }
+    for(int m = 0; m < memberCount; ++m){
+        this->memberSeatOffsets[m + 1] += this->memberSeatOffsets[m];
+    }
+    this->seatCount = this->memberSeatOffsets[memberCount];
+
+    std::vector<int> next(this->memberSeatOffsets.begin(),
+                          this->memberSeatOffsets.end() - 1);
+    this->memberSeats.resize(this->seatCount);
+    for(int s = 0; s < CLUB_SHARDS; ++s){
+        const std::vector<int>& seatMembers = this->shards[s].seatMembers;
+        int seat = 0;
+        for(int r = 0; r * CLUB_SHARDS < this->rangeSeats.size(); ++r){
+            const std::vector<ClubSeat>& seats =
+                this->rangeSeats[r * CLUB_SHARDS + s];
+            for(int i = 0; i < seats.size(); ++i){
+                int member = shardFirsts[s] + seatMembers[seat++];
+                this->memberSeats[next[member]++] = seats[i];
+            }
+        }
+    }
+    return true;
+}
+
+
+/*******************************************************************************
+ *                    settle(const std::string&, std::string&)
+ * Description: nets every player over the tables they sat at and settles the
+ *              club game, which is given the id clubId. Tables that can't be
+ *              settled on their own are left out; getTableError() says why.
+ *              Returns false and sets error if the club game can't be
+ *              settled. Called once, after every table has been added.
+*******************************************************************************/
+bool ClubSettler::settle(const std::string& clubId, std::string& error) {
+    int tableCount = this->tables.size();
+    int rangeCount = 1;
+    if(this->pool != NULL){
+        rangeCount = this->pool->getThreadCount() * CLUB_TASKS_PER_THREAD;
+        rangeCount = std::max(1, std::min(rangeCount, tableCount));
+    }
+
+    this->tableErrors.assign(tableCount, std::string());
+    this->rangeSeats.assign(rangeCount * CLUB_SHARDS,
+                            std::vector<ClubSeat>());
+    this->runTasks(rangeCount, &ClubSettler::gatherRange, rangeCount);
+    this->shards.assign(CLUB_SHARDS, Shard());
+    this->shardMembers.assign(PlayerNames::getCount(), -1);
+    this->runTasks(CLUB_SHARDS, &ClubSettler::totalShard, rangeCount);
+    bool made = this->makeClub(error);
+
+    //the scratch of the passes isn't needed once the seats are filed
+    std::vector<std::vector<ClubSeat> >().swap(this->rangeSeats);
+    std::vector<Shard>().swap(this->shards);
+    std::vector<int>().swap(this->shardMembers);
+    if(!made){
+        return false;
+    }
+
+    LedgerGame record;
+    record.gameId = clubId;
+    record.game = &this->club;
+    record.firstLine = 0;
+    ParallelSettler::settleGame(record, this->solver, this->settlement,
+                                this->allowed, this->objective,
+                                this->maxPayments);
+    if(!this->settlement.error.empty()){
+        //the club game isn't on any one line of the ledger
+        error = this->settlement.error;
+        size_t lineEnd = error.find(": ");
+        if(error.compare(0, 5, "line ") == 0 && lineEnd != std::string::npos){
+            error.erase(0, lineEnd + 2);
+        }
+        return false;
+    }
+    return true;
+}
+
+
+/*******************************************************************************
+ *        getTableCount() / getTable(int) / getTableError(int)
+ * Description: return the club's tables, in the order they were added, and
+ *              why a table was left out of the club, which is empty if it
+ *              wasn't
+*******************************************************************************/
+int ClubSettler::getTableCount() const {
+    return this->tables.size();
+}
+
+
+const LedgerGame& ClubSettler::getTable(int table) const {
+    return this->tables[table];
+}
+
+
+const std::string& ClubSettler::getTableError(int table) const {
+    return this->tableErrors[table];
+}
+
+
+/*******************************************************************************
+ *                   getSeatCount() / getClub()
+ * Description: return the number of seats at the tables that were netted,
+ *              and the club game, which has a player for each name, with
+ *              their buy-ins and final stacks over every table
+*******************************************************************************/
+long ClubSettler::getSeatCount() const {
+    return this->seatCount;
+}
+
+
+const Game& ClubSettler::getClub() const {
+    return this->club;
+}
+
+
+/*******************************************************************************
+ *         getMemberSeats(int, const ClubSeat*&, const ClubSeat*&)
+ * Description: points first and last at the seats the club game's player
+ *              member sat in, in table order, last being one past the end
+*******************************************************************************/
+void ClubSettler::getMemberSeats(int member, const ClubSeat*& first,
+                                 const ClubSeat*& last) const {
+    first = this->memberSeats.data() + this->memberSeatOffsets[member];
+    last = this->memberSeats.data() + this->memberSeatOffsets[member + 1];
+}
+
+
+/*******************************************************************************
+ *                             getPayments()
+ * Description: returns the club's settlement. The payers and payees are the
+ *              club game's players.
+*******************************************************************************/
+const std::vector<Payment>& ClubSettler::getPayments() const {
+    return this->settlement.payments;
+}
+
+
+/*******************************************************************************
+ *                        writeDrillDown(std::ostream&)
+ * Description: writes how each player's club balance is made up, one row per
+ *              seat as player_name,game_id,net, where net is what the player
+ *              lost at that table (negative if they won). Rows are grouped by
+ *              player, in the order of the club game, then by table.
+*******************************************************************************/
+void ClubSettler::writeDrillDown(std::ostream& output) const {
+    for(int m = 0; m < this->club.getPlayerCount(); ++m){
+        const std::string& name = this->club.getPlayer(m)->getName();
+        for(int i = this->memberSeatOffsets[m];
+            i < this->memberSeatOffsets[m + 1]; ++i){
+            const ClubSeat& seat = this->memberSeats[i];
+            const Player* player =
+                this->tables[seat.table].game->getPlayer(seat.player);
+            output << name << "," << this->tables[seat.table].gameId << ","
+                   << player->getBuyIn() - player->getFinalStack() << "\n";
+        }
+    }
+}
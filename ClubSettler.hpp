@@ -0,0 +1,109 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Header file for the ClubSettler class. A ClubSettler settles a
+ *              club's night of many tables at once. Each table is a game of
+ *              its own, but a player who sat at several tables is netted
+ *              across all of them first, by name id, so the club makes one
+ *              settlement between its players instead of one per table.
+ *
+ *              The tables are checked and their seats gathered by player on a
+ *              ThreadPool, a table range at a time and then a shard of the
+ *              players at a time, so the work grows with the number of seats
+ *              however the players are spread over the tables. The netted
+ *              players then make one game, the club game, which is settled
+ *              like any game of a batch. Which tables each player sat at, and
+ *              how much they won or lost at each one, is kept so a player's
+ *              club balance can be broken down by table.
+*******************************************************************************/
+#ifndef CLUBSETTLER_HPP
+#define CLUBSETTLER_HPP
+
+#include <stdint.h>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "AllowedPayments.hpp"
+#include "Game.hpp"
+#include "LedgerReader.hpp"
+#include "ParallelSettler.hpp"
+#include "Structs.hpp"
+#include "ThreadPool.hpp"
+
+//the players are gathered in this many shards, by the hash of their names.
+//It doesn't depend on the thread count, so neither does the settlement
+const int CLUB_SHARDS = 64;
+
+//one player's seat at one table of the club
+struct ClubSeat{
+    int table;      //index of the table in the club
+    int player;     //index of the player in the table's game
+};
+
+class ClubSettler
+{
+    private:
+        //the players whose names hash to one shard, with their totals over
+        //every table, in the order they were first seen
+        struct Shard{
+            std::vector<uint32_t> nameIds;
+            std::vector<Amount> buyIns;
+            std::vector<Amount> finalStacks;
+            std::vector<int> seatMembers;   //the shard's player of each seat
+            bool overflow;
+        };
+
+        ThreadPool* pool;   //NULL when settling on the calling thread
+        SolverType solver;
+        const AllowedPayments* allowed;
+        SettlementObjective objective;
+        int maxPayments;
+
+        std::vector<LedgerGame> tables;     //the games are owned here
+        std::vector<std::string> tableErrors;
+        long seatCount;
+
+        //the seats of table range r whose player hashes to shard s are
+        //rangeSeats[r * CLUB_SHARDS + s], in table order
+        std::vector<std::vector<ClubSeat> > rangeSeats;
+        std::vector<Shard> shards;
+
+        //each name id's player in its shard, or -1. A name is in only one
+        //shard, so the shards fill it in at once without locking
+        std::vector<int> shardMembers;
+
+        //the club game has one player, or member, per name. The seats of
+        //member m are memberSeats[memberSeatOffsets[m]] up to
+        //memberSeatOffsets[m + 1], in table order
+        Game club;
+        std::vector<int> memberSeatOffsets;
+        std::vector<ClubSeat> memberSeats;
+        GameSettlement settlement;
+
+        void runTasks(int taskCount, void (ClubSettler::*task)(int, int),
+                      int argument);
+        void gatherRange(int range, int rangeCount);
+        void totalShard(int shard, int rangeCount);
+        bool makeClub(std::string& error);
+
+    public:
+        ClubSettler(int threadCount, SolverType solver = GREEDY_SOLVER);
+        ~ClubSettler();
+        void setAllowedPayments(const AllowedPayments* allowed,
+                                SettlementObjective objective);
+        void setMaxPayments(int maxPayments);
+        void addTable(const LedgerGame& table);
+        bool settle(const std::string& clubId, std::string& error);
+
+        int getTableCount() const;
+        const LedgerGame& getTable(int table) const;
+        const std::string& getTableError(int table) const;
+        long getSeatCount() const;
+        const Game& getClub() const;
+        void getMemberSeats(int member, const ClubSeat*& first,
+                            const ClubSeat*& last) const;
+        const std::vector<Payment>& getPayments() const;
+        void writeDrillDown(std::ostream& output) const;
+};
+
+#endif
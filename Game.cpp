@@ -10,9 +10,15 @@
 
 #include <iostream>
 #include <iomanip>
-#include <cassert>
+#include <utility>
 #include "Game.hpp"
+#include "PlayerNames.hpp"
 #include "PlayerGraph.hpp"
+#include "LiveSettlement.hpp"
+#include "SessionLog.hpp"
+#include "SettlementWriter.hpp"
+#include "Metrics.hpp"
+#include "Validation.hpp"
 #include "helperFunctions.hpp"
 
 /*******************************************************************************
@@ -21,60 +27,98 @@
 *******************************************************************************/
 Game::Game() {
     this->totalPurse = 0;
+    this->totalStacks = 0;
+    this->amountOverflow = false;
+    this->liveSettlement = NULL;
+    this->sessionLog = NULL;
 }
 
 
 /*******************************************************************************
  *                               ~Game()
- * Description: Deconstructor. Deallocates dynamically allocated memory in 
- *              vector of players.
+ * Description: Deconstructor. The players are owned by the vector of players
+ *              and are freed with it.
 *******************************************************************************/
 Game::~Game() {
-    //deallocate all of the dynamically allocated Player objects
-    for(int i = 0; i < this->players.size(); i++) {
-        delete players.at(i);
-    }
-    //empty the vector of players
-    this->players.clear();
+    delete this->liveSettlement;
+    delete this->sessionLog;
 }
 
 
 /*******************************************************************************
- *                        void addPlayer(Player* p)
- * Description: takes a pointer to a Player object and appends it to the Game's
- *              vector of Players and updates the game's total purse with the
- *              player's buy-in amount
+ *                void addPlayer(std::string, Amount, Amount)
+ *                  void addPlayer(uint32_t, Amount, Amount)
+ * Description: makes a Player with the given name, or name id from
+ *              PlayerNames, buy-in and final stack, appends it to the Game's
+ *              vector of Players and updates the game's total purse and stacks
+ *              with the player's amounts. A final stack of -1 means it hasn't
+ *              been entered yet.
 *******************************************************************************/
-void Game::addPlayer(Player* p) {
-    this->players.push_back(p);
-    this->totalPurse += p->getBuyIn();
+void Game::addPlayer(const std::string& name, Amount buyIn,
+                     Amount finalStack) {
+    this->addPlayer(PlayerNames::intern(name), buyIn, finalStack);
+}
+
+
+void Game::addPlayer(uint32_t nameId, Amount buyIn, Amount finalStack) {
+    std::unique_ptr<Player> player(new Player(nameId, buyIn));
+    player->setFinalStack(finalStack);
+    this->players.push_back(std::move(player));
+    if(!addAmounts(this->totalPurse, buyIn, this->totalPurse)){
+        this->amountOverflow = true;
+    }
+    this->changeTotalStacks(0, finalStack);
+
+    if(this->liveSettlement != NULL){
+        this->liveSettlement->updatePlayer(this->players.size() - 1);
+    }
+    if(this->sessionLog != NULL){
+        this->sessionLog->logAddPlayer(this->players.back()->getName(),
+                                       buyIn, finalStack);
+    }
 }
 
 
 /*******************************************************************************
- *                   vector<Player*> getPlayers()
- * Description: returns a reference to the vector of player objects
+ *                             getPlayers()
+ * Description: returns a reference to the vector of player objects, which
+ *              stays owned by the game
 *******************************************************************************/
-std::vector<Player*> Game::getPlayers() const {
+const std::vector<std::unique_ptr<Player> >& Game::getPlayers() const {
     return this->players;
 }
 
 
 /*******************************************************************************
- *                       int getTotalPurse()
+ *                    Player* getPlayer(int) / int getPlayerCount()
+ * Description: return one player without copying the vector of players, and
+ *              the number of players in the game
+*******************************************************************************/
+Player* Game::getPlayer(int player) const {
+    return this->players.at(player).get();
+}
+
+
+int Game::getPlayerCount() const {
+    return this->players.size();
+}
+
+
+/*******************************************************************************
+ *                       Amount getTotalPurse()
  * Description: returns the Game's total purse
 *******************************************************************************/
-int Game::getTotalPurse() const {
+Amount Game::getTotalPurse() const {
 
-    //--------------------------------------------------------
-    //This can be removed once the totalPurse is known to keep track
-    //correctly
-    int purse = 0;
+    //recomputing the purse makes every call O(n), so it's only checked when
+    //validation is paranoid
+#if POKERCALC_VALIDATION >= 2
+    Amount purse = 0;
     for(int i = 0; i < this->players.size(); i++) {
         purse += this->players.at(i)->getBuyIn();
     }
-    assert(this->totalPurse == purse);
-    //----------------------------------------------------------
+    VALIDATE_PARANOID(this->amountOverflow || this->totalPurse == purse);
+#endif
 
     return this->totalPurse;
 }
@@ -84,12 +128,48 @@ int Game::getTotalPurse() const {
 ** Description: Returns the current total of the player's final stack counts
 ** this function is for ending the game and making sure everything adds up right
 *******************************************************************************/
-int Game::getTotalStacks() const{
-    int totalStacks = 0;
+Amount Game::getTotalStacks() const{
+
+    //like the purse, the total is kept as stacks change and only recomputed
+    //when validation is paranoid
+#if POKERCALC_VALIDATION >= 2
+    Amount stacks = 0;
     for(int i = 0; i < this->players.size(); ++i){
-        totalStacks += this->players.at(i)->getFinalStack();
+        stacks += this->players.at(i)->getFinalStack();
+    }
+    VALIDATE_PARANOID(this->amountOverflow || this->totalStacks == stacks);
+#endif
+
+    return this->totalStacks;
+}
+
+
+/*******************************************************************************
+**                  changeTotalStacks(Amount, Amount)
+** Description: Updates the total of the stacks when a player's stack changes
+** from oldStack to newStack, noting if it no longer fits in an Amount
+*******************************************************************************/
+void Game::changeTotalStacks(Amount oldStack, Amount newStack){
+    if(!addAmounts(this->totalStacks, -oldStack, this->totalStacks) ||
+       !addAmounts(this->totalStacks, newStack, this->totalStacks)){
+        this->amountOverflow = true;
     }
-    return totalStacks;
+}
+
+
+/*******************************************************************************
+**                              amountsFit()
+** Description: Returns true if the game's purse and stacks, and the two added
+** together, fit in an Amount. Once this holds, every other total the game or
+** its PlayerGraph adds up fits as well, so they can use plain additions.
+*******************************************************************************/
+bool Game::amountsFit() const{
+    if(this->amountOverflow){
+        return false;
+    }
+
+    Amount everything;
+    return addAmounts(this->totalStacks, this->totalPurse, everything);
 }
 
 
@@ -112,7 +192,7 @@ void Game::showPlayers(bool withStacks) const {
 
     //print each row of table
     for(int i = 0; i < this->players.size(); i++) {
-        currPlayer = this->players.at(i);
+        currPlayer = this->players.at(i).get();
         
         std::cout << std::setw(2) << i+1 
                   << std::setw(18) << currPlayer->getName() 
@@ -140,42 +220,34 @@ void Game::endGame(){
     //get the final stack for each player and make sure it's right
     inputFinalStacks();
     checkStacks();
+    METRICS_TIME_PHASE(END_GAME_PHASE);
     //generate a graph of the players such that each node represents a player
     //and the value of each node is equal to how much that player is owed 
     //(negative value) or how much that player owes (positive value)
     PlayerGraph graph(this);
-    graph.solveGraph();
-    std::vector<Node*> graphSolution = graph.getAdjList();
-    printResults(graphSolution);
+    graph.solve(GREEDY_SOLVER);
+    printResults(graph);
     return;
 }
 
 
 /*******************************************************************************
  *                              printResults()
- * Description: Prints the results of the graph solution to the console window
+ * Description: Prints the results of the graph solution to the console window,
+ *              one "payer owes payee amount." line per payment
 *******************************************************************************/
-void Game::printResults(std::vector<Node*> graphSolution) const {
+void Game::printResults(const PlayerGraph& graphSolution) const {
+    METRICS_TIME_PHASE(PRINT_RESULTS_PHASE);
     clearTheScreen();
 
     std::cout << "---------------------FINAL RESULTS---------------------------"
               << "\n" << std::endl;
  
-    //for each node in the adjacencey list, print each adjacent node and the 
-    //edge weight associated with it. Each edge represents a payment from a
-    //the node to each of its adjacent nodes
-    for(int i = 0; i < graphSolution.size(); ++i) {
-        struct Node* currNode = graphSolution.at(i);
-
-        //iterate through each adjacent node, printing name and weight of edge
-        for(int j = 0; j < currNode->adjacentNodes.size(); ++j) {
-            std::cout << currNode->player->getName() 
-                      << " owes " 
-                      << currNode->adjacentNodes.at(j)->node->player->getName()
-                      << " " << currNode->adjacentNodes.at(j)->edgeWeight
-                      << "." << std::endl;
-        }
-    }
+    //the payments are buffered and written in one go, rather than flushing
+    //the console after every line
+    SettlementWriter writer(std::cout, TEXT_FORMAT);
+    writer.writeGraph(graphSolution);
+    writer.finish();
 }
 
 /*******************************************************************************
@@ -186,7 +258,7 @@ void Game::printResults(std::vector<Node*> graphSolution) const {
 *******************************************************************************/
 void Game::checkStacks(){
      //make sure it adds up, let user adjust players' chip counts until it does
-    int totalStacks = this->getTotalStacks();
+    Amount totalStacks = this->getTotalStacks();
     while(totalStacks != this->getTotalPurse()){
         clearTheScreen();
         std::cout << "The player's stacks don't add up to the " <<
@@ -204,7 +276,7 @@ void Game::checkStacks(){
                   << "'s chip count.\n"
                   << "New final stack ->";
 
-        this->players.at(choice -1)->setFinalStack(getIntFromUser(0,1000000));
+        this->setFinalStack(choice - 1, getIntFromUser(0,1000000));
         totalStacks = this->getTotalStacks();
     }   
 }
@@ -220,24 +292,110 @@ void Game::inputFinalStacks() {
         std::cout << "Enter the final chip count for " 
                   << this->players.at(i)->getName()
                   << "\n-->" << std::flush;
-        this->players.at(i)->setFinalStack(getIntFromUser(0,1000000));
+        this->setFinalStack(i, getIntFromUser(0,1000000));
     }
     
 }
 
 
 /*******************************************************************************
- *                        addBuyInToPlayer(int, int)
+ *                        addBuyInToPlayer(int, Amount)
  * Description: adds a buy-in amount to an existing Player object.
 *******************************************************************************/
-void Game::addBuyInToPlayer(int playerNumber, int amount){
-    //assert that the playerNumber is valid
-    assert(playerNumber < this->players.size());
-    Player* player = players.at(playerNumber);
+void Game::addBuyInToPlayer(int playerNumber, Amount amount){
+    //make sure that the playerNumber is valid
+    VALIDATE_CHEAP(playerNumber < this->players.size());
+    Player* player = this->players.at(playerNumber).get();
 
     //add amount to player's buy-in and to game's purse
-    int currentStack = player->getBuyIn();
-    player->setBuyIn(currentStack + amount);
-    this->totalPurse += amount;
+    Amount currentStack = player->getBuyIn();
+    Amount newStack;
+    if(!addAmounts(currentStack, amount, newStack) ||
+       !addAmounts(this->totalPurse, amount, this->totalPurse)){
+        this->amountOverflow = true;
+    }
+    player->setBuyIn(newStack);
+
+    if(this->liveSettlement != NULL){
+        this->liveSettlement->updatePlayer(playerNumber);
+    }
+    if(this->sessionLog != NULL){
+        this->sessionLog->logBuyIn(playerNumber, amount);
+    }
 }
 
+
+/*******************************************************************************
+ *                        setFinalStack(int, Amount)
+ * Description: sets an existing Player object's final stack. Stacks should be
+ *              set through the Game rather than the Player so that a live
+ *              settlement and session log, if there are any, see the change.
+*******************************************************************************/
+void Game::setFinalStack(int playerNumber, Amount cents){
+    VALIDATE_CHEAP(playerNumber < this->players.size());
+    Player* player = this->players.at(playerNumber).get();
+    this->changeTotalStacks(player->getFinalStack(), cents);
+    player->setFinalStack(cents);
+
+    if(this->liveSettlement != NULL){
+        this->liveSettlement->updatePlayer(playerNumber);
+    }
+    if(this->sessionLog != NULL){
+        this->sessionLog->logFinalStack(playerNumber, cents);
+    }
+}
+
+
+/*******************************************************************************
+ *                          startLiveSettlement()
+ * Description: starts keeping a LiveSettlement of the game up to date as
+ *              players, buy-ins and stacks change. Its payments are a
+ *              preview of the settlement if the game ended right now.
+*******************************************************************************/
+void Game::startLiveSettlement(){
+    if(this->liveSettlement == NULL){
+        this->liveSettlement = new LiveSettlement(this);
+    }
+}
+
+
+/*******************************************************************************
+ *                          getLiveSettlement()
+ * Description: returns the game's LiveSettlement, or NULL if
+ *              startLiveSettlement() hasn't been called
+*******************************************************************************/
+LiveSettlement* Game::getLiveSettlement() const {
+    return this->liveSettlement;
+}
+
+
+/*******************************************************************************
+ *                 startSessionLog(const std::string&, std::string&)
+ * Description: starts logging every change to the game to the session log at
+ *              path. If the log is from a game that never finished, that game
+ *              is rebuilt first, so this should be called on a new Game.
+ *              Returns false and sets error if the log can't be used.
+*******************************************************************************/
+bool Game::startSessionLog(const std::string& path, std::string& error){
+    VALIDATE_CHEAP(this->sessionLog == NULL && this->players.empty());
+
+    //the recovered changes are already in the log, so they aren't logged
+    //again while they're replayed
+    SessionLog* log = new SessionLog(this, path);
+    if(!log->recover(this, error)){
+        delete log;
+        return false;
+    }
+    this->sessionLog = log;
+    return true;
+}
+
+
+/*******************************************************************************
+ *                            getSessionLog()
+ * Description: returns the game's SessionLog, or NULL if startSessionLog()
+ *              hasn't been called
+*******************************************************************************/
+SessionLog* Game::getSessionLog() const {
+    return this->sessionLog;
+}
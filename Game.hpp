@@ -12,19 +12,29 @@
 #ifndef GAME_HPP
 #define GAME_HPP
 
+#include <memory>
+#include <string>
 #include <vector>
 #include "Player.hpp"
-#include "Structs.hpp"
+
+class PlayerGraph;
+class LiveSettlement;
+class SessionLog;
 
 
 class Game {
     private:
-        std::vector<Player*> players;
-        int totalPurse;
+        std::vector<std::unique_ptr<Player> > players;
+        Amount totalPurse;
+        Amount totalStacks;     //kept up to date as stacks change
+        bool amountOverflow;    //an amount pushed a total past Amount's range
+        LiveSettlement* liveSettlement;     //NULL unless previews are on
+        SessionLog* sessionLog;             //NULL unless changes are logged
         //helper functions
         void inputFinalStacks();
         void checkStacks();
-        void printResults(std::vector<Node*>) const;
+        void changeTotalStacks(Amount oldStack, Amount newStack);
+        void printResults(const PlayerGraph&) const;
         
     public:
         //constructor/destructor
@@ -32,17 +42,27 @@ class Game {
         ~Game();
 
         //getters/setters
-        std::vector<Player*> getPlayers() const;
-        int getTotalPurse() const;
+        const std::vector<std::unique_ptr<Player> >& getPlayers() const;
+        Player* getPlayer(int player) const;
+        int getPlayerCount() const;
+        Amount getTotalPurse() const;
         int getPlayersStacks() const;
         
 
         //other functions
         void showPlayers(bool) const;
-        void addPlayer(Player*);
+        void addPlayer(const std::string& name, Amount buyIn,
+                       Amount finalStack = -1);
+        void addPlayer(uint32_t nameId, Amount buyIn, Amount finalStack = -1);
         void endGame();
-        int getTotalStacks() const;
-        void addBuyInToPlayer(int player, int amount);
+        Amount getTotalStacks() const;
+        bool amountsFit() const;
+        void addBuyInToPlayer(int player, Amount amount);
+        void setFinalStack(int player, Amount cents);
+        void startLiveSettlement();
+        LiveSettlement* getLiveSettlement() const;
+        bool startSessionLog(const std::string& path, std::string& error);
+        SessionLog* getSessionLog() const;
 };
 
 #endif
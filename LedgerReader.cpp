@@ -0,0 +1,282 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Implementation of the LedgerReader class. Games are read one at
+ *              a time from an input stream, so only the game currently being
+ *              settled is ever held in memory no matter how large the ledger
+ *              is. Rows are validated with the same limits used by the
+ *              interactive menus.
+ *
+ *              The stream is read into a buffer a block at a time, and lines
+ *              and fields are found in it with memchr(), which looks at many
+ *              bytes per instruction. Each field is checked where it lies in
+ *              the buffer, in a single pass.
+*******************************************************************************/
+#include "LedgerReader.hpp"
+#include "PlayerNames.hpp"
+#include "helperFunctions.hpp"
+#include <climits>
+#include <cstring>
+#include <sstream>
+
+//how much of the stream is read at a time. A line longer than this grows the
+//buffer to fit it
+const size_t LEDGER_READ_BLOCK = 1 << 16;
+
+
+/*******************************************************************************
+ *                         LedgerReader(std::istream&)
+ * Description: Constructor. Takes the stream the ledger will be read from.
+*******************************************************************************/
+LedgerReader::LedgerReader(std::istream& input) : input(input) {
+    this->buffer.resize(LEDGER_READ_BLOCK);
+    this->position = 0;
+    this->filled = 0;
+    this->inputDone = false;
+    this->lineNumber = 0;
+    this->havePending = false;
+    this->pendingRow = NULL;
+    this->pendingLength = 0;
+    this->pendingLineNumber = 0;
+}
+
+
+/*******************************************************************************
+ *                                  fill()
+ * Description: moves the part of a line left at the end of the buffer to its
+ *              start and reads the next block of input after it. Returns false
+ *              if there was no more input.
+*******************************************************************************/
+bool LedgerReader::fill() {
+    if(this->inputDone){
+        return false;
+    }
+
+    size_t left = this->filled - this->position;
+    if(left > 0 && this->position > 0){
+        std::memmove(&this->buffer[0], &this->buffer[this->position], left);
+    }
+    this->position = 0;
+    this->filled = left;
+    if(this->filled == this->buffer.size()){
+        this->buffer.resize(this->buffer.size() * 2);
+    }
+
+    this->input.read(&this->buffer[this->filled],
+                     this->buffer.size() - this->filled);
+    size_t count = this->input.gcount();
+    if(count == 0){
+        this->inputDone = true;
+        return false;
+    }
+    this->filled += count;
+    return true;
+}
+
+
+/*******************************************************************************
+ *                   nextRow(const char*&, size_t&, int&)
+ * Description: Finds the next non-blank, non-comment line of the ledger along
+ *              with its line number. The row is left in the buffer, where it
+ *              stays until the next call. A line that was read ahead by the
+ *              previous call to nextGame() is returned first. Returns false at
+ *              the end of the input.
+*******************************************************************************/
+bool LedgerReader::nextRow(const char*& row, size_t& length, int& rowLine) {
+    if(this->havePending){
+        row = this->pendingRow;
+        length = this->pendingLength;
+        rowLine = this->pendingLineNumber;
+        this->havePending = false;
+        return true;
+    }
+
+    while(true){
+        const char* start = &this->buffer[0] + this->position;
+        size_t available = this->filled - this->position;
+        const char* newline = (const char*)std::memchr(start, '\n',
+                                                       available);
+        if(newline == NULL){
+            if(this->fill()){
+                continue;
+            }
+            //the last line doesn't have to end in a newline
+            if(available == 0){
+                return false;
+            }
+            newline = start + available;
+            this->position = this->filled;
+        }
+        else{
+            this->position += newline - start + 1;
+        }
+        this->lineNumber++;
+
+        //tolerate ledgers written with windows line endings
+        length = newline - start;
+        if(length > 0 && start[length - 1] == '\r'){
+            length--;
+        }
+        if(length == 0 || start[0] == '#'){
+            continue;
+        }
+
+        row = start;
+        rowLine = this->lineNumber;
+        return true;
+    }
+}
+
+
+/*******************************************************************************
+ *                              parseRow()
+ * Description: Splits a ledger row into its four fields and validates them.
+ *              The game id is filled in even when the rest of the row is bad
+ *              so that the row can still be attributed to its game. Returns
+ *              false and sets error, and the column the problem is found at,
+ *              if the row is invalid.
+*******************************************************************************/
+bool LedgerReader::parseRow(const char* row, size_t length, LedgerRow& fields,
+                            int& column, std::string& error) const {
+    const char* end = row + length;
+    const char* starts[4];
+    const char* stops[4];
+    const char* field = row;
+
+    //split on commas. The game id is set as soon as it's split off, so a
+    //row with too few fields still goes to its game
+    for(int i = 0; i < 4; ++i){
+        const char* stop = end;
+        if(i < 3){
+            stop = (const char*)std::memchr(field, ',', end - field);
+        }
+        if(stop == NULL){
+            if(i == 0){
+                fields.gameId = row;
+                fields.gameIdLength = length;
+            }
+            column = length + 1;
+            error = "expected 4 fields: game_id,player_name,buy_in,"
+                    "final_stack";
+            return false;
+        }
+        starts[i] = field;
+        stops[i] = stop;
+        field = stop + 1;
+        if(i == 0){
+            fields.gameId = starts[0];
+            fields.gameIdLength = stops[0] - starts[0];
+        }
+    }
+
+    const char* extra = (const char*)std::memchr(starts[3], ',',
+                                                 end - starts[3]);
+    if(extra != NULL){
+        column = extra - row + 1;
+        error = "expected 4 fields: game_id,player_name,buy_in,final_stack";
+        return false;
+    }
+
+    //same length limits as getStringFromUser()
+    fields.name = starts[1];
+    fields.nameLength = stops[1] - starts[1];
+    if(fields.nameLength <= (size_t)MIN_NAME_LENGTH ||
+       fields.nameLength >= (size_t)MAX_NAME_LENGTH){
+        column = starts[1] - row + 1;
+        error = "player name must be between " +
+                std::to_string(MIN_NAME_LENGTH + 1) + " and " +
+                std::to_string(MAX_NAME_LENGTH - 1) + " characters";
+        return false;
+    }
+
+    //a player's total buy-in may be several buy-ins, so only the lower bound
+    //applies to it
+    if(!convertCharsToInt(starts[2], stops[2], fields.buyIn, MIN_STACK,
+                          INT_MAX)){
+        column = starts[2] - row + 1;
+        error = "invalid buy-in '" + std::string(starts[2], stops[2]) + "'";
+        return false;
+    }
+    if(!convertCharsToInt(starts[3], stops[3], fields.finalStack, MIN_STACK,
+                          MAX_STACK)){
+        column = starts[3] - row + 1;
+        error = "invalid final stack '" + std::string(starts[3], stops[3]) +
+                "'";
+        return false;
+    }
+    return true;
+}
+
+
+/*******************************************************************************
+ *                         nextGame(LedgerGame&)
+ * Description: Reads every row of the next game in the ledger into a newly
+ *              allocated Game object. The caller takes ownership of the Game.
+ *              If any row of the game is invalid, record.error describes the
+ *              first problem found, and the game should not be settled. A row
+ *              whose name PlayerNames has no room for is a problem too.
+ *              Returns false when there are no more games.
+*******************************************************************************/
+bool LedgerReader::nextGame(LedgerGame& record) {
+    const char* row;
+    size_t length;
+    int rowLine;
+
+    if(!this->nextRow(row, length, rowLine)){
+        return false;
+    }
+
+    record.game = new Game;
+    record.firstLine = rowLine;
+    record.error.clear();
+    bool first = true;
+
+    do{
+        LedgerRow fields;
+        std::string rowError;
+        int column = 0;
+        bool goodRow = this->parseRow(row, length, fields, column, rowError);
+
+        //a new game id starts the next game. Save the row for later
+        if(first){
+            record.gameId.assign(fields.gameId, fields.gameIdLength);
+            first = false;
+        }
+        else if(fields.gameIdLength != record.gameId.size() ||
+                std::memcmp(fields.gameId, record.gameId.data(),
+                            fields.gameIdLength) != 0){
+            this->pendingRow = row;
+            this->pendingLength = length;
+            this->pendingLineNumber = rowLine;
+            this->havePending = true;
+            break;
+        }
+
+        //a server's table of names is capped
+        uint32_t nameId = PLAYER_NAME_NONE;
+        if(goodRow){
+            nameId = PlayerNames::intern(fields.name, fields.nameLength);
+            if(nameId == PLAYER_NAME_NONE){
+                goodRow = false;
+                column = fields.name - row + 1;
+                rowError = "too many distinct player names, the limit is " +
+                           std::to_string(PlayerNames::getLimit());
+            }
+        }
+
+        if(!goodRow){
+            if(record.error.empty()){
+                std::ostringstream message;
+                message << "line " << rowLine << ", column " << column << ": "
+                        << rowError;
+                record.error = message.str();
+            }
+            continue;
+        }
+
+        record.game->addPlayer(nameId, fields.buyIn, fields.finalStack);
+
+    }while(this->nextRow(row, length, rowLine));
+
+    return true;
+}
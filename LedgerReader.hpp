@@ -0,0 +1,69 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Header file for the LedgerReader class. A LedgerReader streams
+ *              finished games out of a text ledger one game at a time so that
+ *              they can be settled without any user interaction. Each line of
+ *              the ledger describes one player:
+ *
+ *                  game_id,player_name,buy_in,final_stack
+ *
+ *              Consecutive lines that share a game_id make up one game. Blank
+ *              lines and lines starting with '#' are ignored.
+ *
+ *              The input is read a block at a time and rows are parsed in
+ *              place, so nothing is copied but the names and game ids of the
+ *              rows that are kept. Errors give the line and the column of the
+ *              field that's wrong.
+*******************************************************************************/
+#ifndef LEDGERREADER_HPP
+#define LEDGERREADER_HPP
+
+#include <stddef.h>
+#include <istream>
+#include <string>
+#include <vector>
+#include "Game.hpp"
+
+struct LedgerGame{
+    std::string gameId;
+    Game* game;          //owned by the caller once returned
+    int firstLine;       //line number of the game's first row
+    std::string error;   //empty if every row of the game was valid
+};
+
+class LedgerReader
+{
+    private:
+        //a row's fields, pointing into the buffer
+        struct LedgerRow{
+            const char* gameId;
+            size_t gameIdLength;
+            const char* name;
+            size_t nameLength;
+            int buyIn;
+            int finalStack;
+        };
+
+        std::istream& input;
+        std::vector<char> buffer;
+        size_t position;        //where the next line starts in the buffer
+        size_t filled;          //how much of the buffer holds input
+        bool inputDone;
+        int lineNumber;
+        bool havePending;
+        const char* pendingRow; //in the buffer until it's next filled
+        size_t pendingLength;
+        int pendingLineNumber;
+
+        bool fill();
+        bool nextRow(const char*& row, size_t& length, int& rowLine);
+        bool parseRow(const char* row, size_t length, LedgerRow& fields,
+                      int& column, std::string& error) const;
+
+    public:
+        LedgerReader(std::istream& input);
+        bool nextGame(LedgerGame& record);
+};
+
+#endif
@@ -0,0 +1,310 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Implementation of the LiveSettlement class. Payments always run
+ *              from players who only pay to players who are only paid. A
+ *              repair first gives back payments that are now too large - a
+ *              payer who owes less pays out less, a winner who is owed less
+ *              receives less - which moves the difference onto the players on
+ *              the other end of those payments. Then everyone who is still
+ *              off is settled greedily, largest first, topping up existing
+ *              payments where possible. When repairs have left noticeably more
+ *              payments than a fresh solve would, the settlement is rebuilt
+ *              from scratch.
+*******************************************************************************/
+#include "LiveSettlement.hpp"
+#include "Game.hpp"
+#include <algorithm>
+
+//rebuild once repairs have added this many payments for every 8 players with
+//a non-zero balance (plus a few, so tiny games don't rebuild constantly)
+const int LIVE_REBUILD_SLACK_PER_8 = 1;
+const int LIVE_REBUILD_SLACK_MIN = 8;
+
+
+/*******************************************************************************
+ *                        LiveSettlement(const Game*)
+ * Description: Constructor. Indexes every player already in the game. Nothing
+ *              is solved until the first call to repair().
+*******************************************************************************/
+LiveSettlement::LiveSettlement(const Game* game) : game(game) {
+    this->paymentCount = 0;
+    this->unevenCount = 0;
+    this->freshPaymentCount = -1;
+
+    for(int i = 0; i < this->game->getPlayerCount(); ++i){
+        this->updatePlayer(i);
+    }
+}
+
+
+/*******************************************************************************
+ *                              getResidual(int)
+ * Description: returns how much more the player has to pay (positive) or be
+ *              paid (negative) on top of their current payments
+*******************************************************************************/
+Amount LiveSettlement::getResidual(int player) const {
+    return this->balances[player] - this->covered[player];
+}
+
+
+/*******************************************************************************
+ *                         unindex(int) / index(int)
+ * Description: take a player out of, and put them back into, the residual
+ *              index. Called around every change to a balance or payment.
+*******************************************************************************/
+void LiveSettlement::unindex(int player) {
+    Amount residual = this->getResidual(player);
+    if(residual > 0){
+        this->underPaying.erase(std::make_pair(residual, player));
+    }
+    else if(residual < 0){
+        this->underPaid.erase(std::make_pair(-residual, player));
+    }
+}
+
+
+void LiveSettlement::index(int player) {
+    Amount residual = this->getResidual(player);
+    if(residual > 0){
+        this->underPaying.insert(std::make_pair(residual, player));
+    }
+    else if(residual < 0){
+        this->underPaid.insert(std::make_pair(-residual, player));
+    }
+}
+
+
+/*******************************************************************************
+ *                            updatePlayer(int)
+ * Description: Re-reads a player's buy-in and final stack from the game. A
+ *              final stack that hasn't been entered yet counts as 0. Takes
+ *              O(log n) time; the payments are not touched until repair().
+*******************************************************************************/
+void LiveSettlement::updatePlayer(int player) {
+    if(player >= this->balances.size()){
+        this->balances.resize(player + 1, 0);
+        this->covered.resize(player + 1, 0);
+        this->paymentsFrom.resize(player + 1);
+        this->paymentsTo.resize(player + 1);
+        this->amountsFrom.resize(player + 1);
+        this->amountsTo.resize(player + 1);
+    }
+
+    Player* currPlayer = this->game->getPlayer(player);
+    Amount finalStack = currPlayer->getFinalStack();
+    if(finalStack < 0){
+        finalStack = 0;
+    }
+    Amount balance = currPlayer->getBuyIn() - finalStack;
+
+    if(this->balances[player] != 0){
+        this->unevenCount--;
+    }
+    if(balance != 0){
+        this->unevenCount++;
+    }
+
+    this->unindex(player);
+    this->balances[player] = balance;
+    this->index(player);
+}
+
+
+/*******************************************************************************
+ *                     changePayment(int, int, Amount)
+ * Description: Adds change to the payment from payer to payee, creating or
+ *              removing the payment as needed. O(log n).
+*******************************************************************************/
+void LiveSettlement::changePayment(int payer, int payee, Amount change) {
+    this->unindex(payer);
+    this->unindex(payee);
+
+    Amount& amount = this->paymentsFrom[payer][payee];
+    if(amount == 0){
+        this->paymentCount++;
+    }
+    else{
+        this->amountsFrom[payer].erase(std::make_pair(amount, -payee));
+        this->amountsTo[payee].erase(std::make_pair(amount, -payer));
+    }
+    amount += change;
+    this->paymentsTo[payee][payer] = amount;
+
+    if(amount == 0){
+        this->paymentsFrom[payer].erase(payee);
+        this->paymentsTo[payee].erase(payer);
+        this->paymentCount--;
+    }
+    else{
+        this->amountsFrom[payer].insert(std::make_pair(amount, -payee));
+        this->amountsTo[payee].insert(std::make_pair(amount, -payer));
+    }
+
+    this->covered[payer] += change;
+    this->covered[payee] -= change;
+    this->index(payer);
+    this->index(payee);
+}
+
+
+/*******************************************************************************
+ *                   releasePayments(int, Amount, bool)
+ * Description: Cuts up to amount from a player's incoming (or outgoing)
+ *              payments, largest payment first, so as few players on the
+ *              other end as possible are affected. O(log n) per payment cut.
+*******************************************************************************/
+void LiveSettlement::releasePayments(int player, Amount amount, bool incoming) {
+    while(amount > 0){
+        std::set<std::pair<Amount, int> >& payments =
+            incoming ? this->amountsTo[player] : this->amountsFrom[player];
+        if(payments.empty()){
+            return;
+        }
+
+        int other = -payments.rbegin()->second;
+        Amount cut = std::min(amount, payments.rbegin()->first);
+        if(incoming){
+            this->changePayment(other, player, -cut);
+        }
+        else{
+            this->changePayment(player, other, -cut);
+        }
+        amount -= cut;
+    }
+}
+
+
+/*******************************************************************************
+ *                                rebuild()
+ * Description: Drops every payment, so the next settle pass solves the whole
+ *              game from scratch.
+*******************************************************************************/
+void LiveSettlement::rebuild() {
+    int playerCount = this->balances.size();
+    this->underPaying.clear();
+    this->underPaid.clear();
+    this->paymentCount = 0;
+
+    for(int i = 0; i < playerCount; ++i){
+        this->paymentsFrom[i].clear();
+        this->paymentsTo[i].clear();
+        this->amountsFrom[i].clear();
+        this->amountsTo[i].clear();
+        this->covered[i] = 0;
+        this->index(i);
+    }
+}
+
+
+/*******************************************************************************
+ *                                 repair()
+ * Description: Brings the payments back in line with the players' balances.
+ *              Payments that are now too large are cut back first, then the
+ *              players who are still off are settled largest first. Takes
+ *              O(k log n) time for k payments that had to change.
+ *              If repairs have drifted too far above what a full solve gave,
+ *              the whole game is solved again instead.
+*******************************************************************************/
+void LiveSettlement::repair() {
+    int slack = this->unevenCount / 8 * LIVE_REBUILD_SLACK_PER_8;
+    if(slack < LIVE_REBUILD_SLACK_MIN){
+        slack = LIVE_REBUILD_SLACK_MIN;
+    }
+
+    //a full solve never needs more than n - 1 payments
+    int limit = std::min(this->freshPaymentCount, this->unevenCount - 1);
+    bool fullSolve = this->freshPaymentCount < 0;
+    if(!fullSolve && this->paymentCount > limit + slack){
+        this->rebuild();
+        fullSolve = true;
+    }
+
+    //players who now owe more but are being paid: they get paid less
+    std::vector<int> releasing;
+    std::set<std::pair<Amount, int> >::iterator it;
+    for(it = this->underPaying.begin(); it != this->underPaying.end(); ++it){
+        if(!this->paymentsTo[it->second].empty()){
+            releasing.push_back(it->second);
+        }
+    }
+    for(int i = 0; i < releasing.size(); ++i){
+        int player = releasing[i];
+        this->releasePayments(player, this->getResidual(player), true);
+    }
+
+    //players who are now owed more but are paying: they pay less
+    releasing.clear();
+    for(it = this->underPaid.begin(); it != this->underPaid.end(); ++it){
+        if(!this->paymentsFrom[it->second].empty()){
+            releasing.push_back(it->second);
+        }
+    }
+    for(int i = 0; i < releasing.size(); ++i){
+        int player = releasing[i];
+        this->releasePayments(player, -this->getResidual(player), false);
+    }
+
+    //settle what's left, the largest loser paying the largest winner
+    while(!this->underPaying.empty() && !this->underPaid.empty()){
+        int loser = this->underPaying.rbegin()->second;
+        int winner = this->underPaid.rbegin()->second;
+        Amount transfer = std::min(this->getResidual(loser),
+                                -this->getResidual(winner));
+        this->changePayment(loser, winner, transfer);
+    }
+
+    if(fullSolve){
+        this->freshPaymentCount = this->paymentCount;
+    }
+}
+
+
+/*******************************************************************************
+ *                     getPayments(std::vector<Payment>&)
+ * Description: Repairs the settlement and fills payments with it, ordered by
+ *              payer and then payee.
+*******************************************************************************/
+void LiveSettlement::getPayments(std::vector<Payment>& payments) {
+    this->repair();
+
+    payments.clear();
+    payments.reserve(this->paymentCount);
+    for(int payer = 0; payer < this->paymentsFrom.size(); ++payer){
+        std::map<int, Amount>::const_iterator it;
+        for(it = this->paymentsFrom[payer].begin(); 
+            it != this->paymentsFrom[payer].end(); ++it){
+            Payment payment;
+            payment.payer = this->game->getPlayer(payer);
+            payment.payee = this->game->getPlayer(it->first);
+            payment.amount = it->second;
+            payments.push_back(payment);
+        }
+    }
+}
+
+
+/*******************************************************************************
+ *                            getPaymentCount()
+ * Description: returns the number of payments in the settlement as of the
+ *              last repair
+*******************************************************************************/
+int LiveSettlement::getPaymentCount() const {
+    return this->paymentCount;
+}
+
+
+/*******************************************************************************
+ *                           getUnsettledAmount()
+ * Description: returns how much of what the losers owe could not be matched
+ *              to a winner at the last repair. This is 0 whenever the stacks
+ *              add up to the game's purse.
+*******************************************************************************/
+Amount LiveSettlement::getUnsettledAmount() const {
+    Amount unsettled = 0;
+    std::set<std::pair<Amount, int> >::const_iterator it;
+    for(it = this->underPaying.begin(); it != this->underPaying.end(); ++it){
+        unsettled += it->first;
+    }
+    return unsettled;
+}
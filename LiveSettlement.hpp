@@ -0,0 +1,71 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Header file for the LiveSettlement class. A LiveSettlement
+ *              keeps a settlement of a running Game up to date as buy-ins and
+ *              stacks change, so "what if we stopped now" previews don't have
+ *              to build and solve a new PlayerGraph every time.
+ *
+ *              Each player's residual is what they owe minus what the current
+ *              payments already cover. A change to one player only changes
+ *              that player's residual, which is re-indexed in O(log n). When a
+ *              preview is asked for, only the payments touching players with
+ *              a residual are repaired, and the residuals are settled among
+ *              themselves largest first, the same way solveGraph() works.
+*******************************************************************************/
+#ifndef LIVESETTLEMENT_HPP
+#define LIVESETTLEMENT_HPP
+
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+#include "Structs.hpp"
+
+class Game;
+
+class LiveSettlement
+{
+    private:
+        const Game* game;
+
+        //per player: what they owe (negative if owed), and what the current
+        //payments cover (paid out minus paid in)
+        std::vector<Amount> balances;
+        std::vector<Amount> covered;
+
+        //current payments, indexed from both ends
+        std::vector<std::map<int, Amount> > paymentsFrom;  //payer -> payee
+        std::vector<std::map<int, Amount> > paymentsTo;    //payee -> payer
+
+        //the same payments ordered by amount, so a player's largest is found
+        //in O(log d). (amount, -other player), so of two equal payments the
+        //one to the lower numbered player comes last
+        std::vector<std::set<std::pair<Amount, int> > > amountsFrom;
+        std::vector<std::set<std::pair<Amount, int> > > amountsTo;
+        int paymentCount;
+        int unevenCount;        //players with a non-zero balance
+        int freshPaymentCount;  //payments right after the last full solve
+
+        //players whose payments don't cover their balance, ordered by how
+        //far off they are. (amount, player)
+        std::set<std::pair<Amount, int> > underPaying;
+        std::set<std::pair<Amount, int> > underPaid;
+
+        Amount getResidual(int player) const;
+        void unindex(int player);
+        void index(int player);
+        void changePayment(int payer, int payee, Amount change);
+        void releasePayments(int player, Amount amount, bool incoming);
+        void rebuild();
+
+    public:
+        LiveSettlement(const Game* game);
+        void updatePlayer(int player);
+        void repair();
+        void getPayments(std::vector<Payment>& payments);
+        int getPaymentCount() const;
+        Amount getUnsettledAmount() const;
+};
+
+#endif
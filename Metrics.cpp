@@ -0,0 +1,280 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Implementation of the Metrics class. Every counter and
+ *              histogram bucket is a relaxed atomic, since they are only ever
+ *              added to and nothing is ordered by them.
+ *
+ *              In a metrics build, allocations are counted by replacing the
+ *              global operator new. The benchmark replaces it itself to count
+ *              its own allocations, so it's left alone there.
+*******************************************************************************/
+#include "Metrics.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+
+const char* const PHASE_NAMES[METRIC_PHASE_COUNT] = {
+    "end_game", "build_graph", "solve", "print_results", "write_payments"
+};
+
+const char* const COUNTER_NAMES[METRIC_COUNTER_COUNT] = {
+    "heap_operations", "edges_stored", "allocations", "bytes_printed",
+    "graphs_solved", "flow_phases"
+};
+
+const char* const COUNTER_HELP[METRIC_COUNTER_COUNT] = {
+    "Heap pushes and pops made by the solvers.",
+    "Payments stored in solved graphs.",
+    "Calls to operator new.",
+    "Bytes of payments printed or written.",
+    "Graphs solved.",
+    "Shortest path phases run settling over allowed payments."
+};
+
+static std::atomic<long> counters[METRIC_COUNTER_COUNT];
+static std::atomic<long> phaseCounts[METRIC_PHASE_COUNT];
+static std::atomic<long> phaseNanoseconds[METRIC_PHASE_COUNT];
+static std::atomic<long>
+    histograms[METRIC_PHASE_COUNT][METRICS_HISTOGRAM_BUCKETS];
+
+//where writeOnExit() writes the metrics. Never freed, so that it's still there
+//while static objects are being destroyed
+static std::string* exitPath = NULL;
+
+
+#if POKERCALC_METRICS && !defined(POKERCALC_BENCH)
+void* operator new(size_t size){
+    counters[ALLOCATIONS].fetch_add(1, std::memory_order_relaxed);
+    void* memory = std::malloc(size);
+    if(memory == NULL){
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
+#endif
+
+
+/*******************************************************************************
+ *                               isEnabled()
+ * Description: returns true if PokerCalc was built to collect metrics
+*******************************************************************************/
+bool Metrics::isEnabled() {
+    return POKERCALC_METRICS != 0;
+}
+
+
+/*******************************************************************************
+ *                        add(MetricCounter, long)
+ * Description: adds amount to a counter
+*******************************************************************************/
+void Metrics::add(MetricCounter counter, long amount) {
+    counters[counter].fetch_add(amount, std::memory_order_relaxed);
+}
+
+
+/*******************************************************************************
+ *                          record(MetricPhase, long)
+ * Description: records that a phase took the given number of nanoseconds
+*******************************************************************************/
+void Metrics::record(MetricPhase phase, long nanoseconds) {
+    //smallest b with nanoseconds <= 2^b
+    int bucket = 0;
+    while(bucket < METRICS_HISTOGRAM_BUCKETS - 1 &&
+          (1L << bucket) < nanoseconds){
+        bucket++;
+    }
+    histograms[phase][bucket].fetch_add(1, std::memory_order_relaxed);
+    phaseCounts[phase].fetch_add(1, std::memory_order_relaxed);
+    phaseNanoseconds[phase].fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+
+/*******************************************************************************
+ *                        getCount(MetricCounter)
+ * Description: returns a counter's current value
+*******************************************************************************/
+long Metrics::getCount(MetricCounter counter) {
+    return counters[counter].load(std::memory_order_relaxed);
+}
+
+
+/*******************************************************************************
+ *                     write(std::ostream&, MetricsFormat)
+ * Description: writes every counter and phase histogram in the given format
+*******************************************************************************/
+void Metrics::write(std::ostream& output, MetricsFormat format) {
+    if(format == METRICS_PROMETHEUS){
+        writePrometheus(output);
+    }
+    else{
+        writeJson(output);
+    }
+}
+
+
+/*******************************************************************************
+ *                          writeJson(std::ostream&)
+ * Description: Writes the metrics as one JSON object. Each phase gets its
+ *              count, total time, p50 and p99, and the buckets of its
+ *              histogram that aren't empty. The percentiles are the upper
+ *              bound of the bucket they fall in.
+*******************************************************************************/
+void Metrics::writeJson(std::ostream& output) {
+    output << "{\n  \"enabled\": " << (isEnabled() ? "true" : "false")
+           << ",\n  \"counters\": {";
+    for(int i = 0; i < METRIC_COUNTER_COUNT; ++i){
+        output << (i == 0 ? "\n" : ",\n") << "    \"" << COUNTER_NAMES[i]
+               << "\": " << counters[i].load(std::memory_order_relaxed);
+    }
+    output << "\n  },\n  \"phases\": {";
+
+    for(int i = 0; i < METRIC_PHASE_COUNT; ++i){
+        long count = phaseCounts[i].load(std::memory_order_relaxed);
+        long buckets[METRICS_HISTOGRAM_BUCKETS];
+        for(int b = 0; b < METRICS_HISTOGRAM_BUCKETS; ++b){
+            buckets[b] = histograms[i][b].load(std::memory_order_relaxed);
+        }
+
+        //upper bounds of the buckets holding the 50th and 99th percentiles
+        long p50 = 0;
+        long p99 = 0;
+        long seen = 0;
+        for(int b = 0; b < METRICS_HISTOGRAM_BUCKETS && count > 0; ++b){
+            seen += buckets[b];
+            if(p50 == 0 && seen * 100 >= count * 50){
+                p50 = 1L << b;
+            }
+            if(p99 == 0 && seen * 100 >= count * 99){
+                p99 = 1L << b;
+            }
+        }
+
+        output << (i == 0 ? "\n" : ",\n") << "    \"" << PHASE_NAMES[i]
+               << "\": {\"count\": " << count << ", \"total_ns\": "
+               << phaseNanoseconds[i].load(std::memory_order_relaxed)
+               << ", \"p50_ns\": " << p50 << ", \"p99_ns\": " << p99
+               << ", \"buckets\": {";
+        bool first = true;
+        for(int b = 0; b < METRICS_HISTOGRAM_BUCKETS; ++b){
+            if(buckets[b] != 0){
+                output << (first ? "" : ", ") << "\"" << (1L << b) << "\": "
+                       << buckets[b];
+                first = false;
+            }
+        }
+        output << "}}";
+    }
+    output << "\n  }\n}\n";
+}
+
+
+/*******************************************************************************
+ *                       writePrometheus(std::ostream&)
+ * Description: Writes the metrics in the Prometheus text exposition format.
+ *              The counters are pokercalc_<name>_total, and the phases are
+ *              one histogram, pokercalc_phase_seconds, labelled by phase.
+*******************************************************************************/
+void Metrics::writePrometheus(std::ostream& output) {
+    for(int i = 0; i < METRIC_COUNTER_COUNT; ++i){
+        output << "# HELP pokercalc_" << COUNTER_NAMES[i] << "_total "
+               << COUNTER_HELP[i] << "\n"
+               << "# TYPE pokercalc_" << COUNTER_NAMES[i] << "_total counter\n"
+               << "pokercalc_" << COUNTER_NAMES[i] << "_total "
+               << counters[i].load(std::memory_order_relaxed) << "\n";
+    }
+
+    output << "# HELP pokercalc_phase_seconds Time spent in each phase of "
+           << "settling a game.\n"
+           << "# TYPE pokercalc_phase_seconds histogram\n";
+    char bound[32];
+    for(int i = 0; i < METRIC_PHASE_COUNT; ++i){
+        long cumulative = 0;
+        for(int b = 0; b < METRICS_HISTOGRAM_BUCKETS - 1; ++b){
+            cumulative += histograms[i][b].load(std::memory_order_relaxed);
+            std::snprintf(bound, sizeof(bound), "%.9g", (1L << b) * 1e-9);
+            output << "pokercalc_phase_seconds_bucket{phase=\""
+                   << PHASE_NAMES[i] << "\",le=\"" << bound << "\"} "
+                   << cumulative << "\n";
+        }
+
+        long count = phaseCounts[i].load(std::memory_order_relaxed);
+        std::snprintf(bound, sizeof(bound), "%.9g",
+                      phaseNanoseconds[i].load(std::memory_order_relaxed) *
+                      1e-9);
+        output << "pokercalc_phase_seconds_bucket{phase=\"" << PHASE_NAMES[i]
+               << "\",le=\"+Inf\"} " << count << "\n"
+               << "pokercalc_phase_seconds_sum{phase=\"" << PHASE_NAMES[i]
+               << "\"} " << bound << "\n"
+               << "pokercalc_phase_seconds_count{phase=\"" << PHASE_NAMES[i]
+               << "\"} " << count << "\n";
+    }
+}
+
+
+/*******************************************************************************
+ *                   writeFile(std::string, std::string&)
+ * Description: Writes the metrics to path, in the Prometheus format if path
+ *              ends in ".prom" and as JSON otherwise. Returns false and sets
+ *              error if the file can't be written.
+*******************************************************************************/
+bool Metrics::writeFile(const std::string& path, std::string& error) {
+    const std::string prometheusSuffix = ".prom";
+    MetricsFormat format = METRICS_JSON;
+    if(path.size() >= prometheusSuffix.size() &&
+       path.compare(path.size() - prometheusSuffix.size(),
+                    prometheusSuffix.size(), prometheusSuffix) == 0){
+        format = METRICS_PROMETHEUS;
+    }
+
+    std::ofstream output(path.c_str(), std::ios::trunc);
+    if(!output){
+        error = "could not open " + path;
+        return false;
+    }
+    write(output, format);
+    output.flush();
+    if(!output){
+        error = "could not write " + path;
+        return false;
+    }
+    return true;
+}
+
+
+/*******************************************************************************
+ *                      writeFileAtExit(std::string)
+ * Description: arranges for the metrics to be written to path when the
+ *              program exits
+*******************************************************************************/
+void Metrics::writeFileAtExit(const std::string& path) {
+    if(exitPath == NULL){
+        exitPath = new std::string(path);
+        std::atexit(writeOnExit);
+    }
+    else{
+        *exitPath = path;
+    }
+}
+
+
+/*******************************************************************************
+ *                              writeOnExit()
+ * Description: writes the metrics to the file given to writeFileAtExit()
+*******************************************************************************/
+void Metrics::writeOnExit() {
+    std::string error;
+    if(!writeFile(*exitPath, error)){
+        std::fprintf(stderr, "%s\n", error.c_str());
+    }
+}
@@ -0,0 +1,117 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Header file for the Metrics class. Metrics counts what the
+ *              settlement pipeline does - heap operations made by the solvers,
+ *              edges stored, allocations, bytes of payments printed and games
+ *              solved - and keeps a latency histogram for each phase of
+ *              settling a game. They can be written out as JSON or in the
+ *              Prometheus text format, on demand or when PokerCalc exits.
+ *
+ *              Metrics are only collected when PokerCalc is built with
+ *              POKERCALC_METRICS set to 1 (make METRICS=1). Otherwise the
+ *              METRICS_ macros used by the pipeline compile to nothing, their
+ *              arguments aren't evaluated, and every count stays at zero.
+ *
+ *              Counters and histograms are atomic, so games settled on any
+ *              number of threads are all counted. The solvers add up their
+ *              heap operations locally and count them once per solve.
+*******************************************************************************/
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include "Amount.hpp"
+
+#ifndef POKERCALC_METRICS
+#define POKERCALC_METRICS 0
+#endif
+
+//the phases of settling a game that are timed
+enum MetricPhase{
+    END_GAME_PHASE,         //Game::endGame() once the stacks are in
+    BUILD_GRAPH_PHASE,      //building a PlayerGraph
+    SOLVE_PHASE,            //PlayerGraph::solve()
+    PRINT_RESULTS_PHASE,    //Game::printResults()
+    WRITE_PAYMENTS_PHASE,   //writing one batch game's payment rows
+    METRIC_PHASE_COUNT
+};
+
+//the things that are counted
+enum MetricCounter{
+    HEAP_OPERATIONS,
+    EDGES_STORED,
+    ALLOCATIONS,
+    BYTES_PRINTED,
+    GRAPHS_SOLVED,
+    FLOW_PHASES,
+    METRIC_COUNTER_COUNT
+};
+
+enum MetricsFormat{
+    METRICS_JSON,
+    METRICS_PROMETHEUS
+};
+
+//bucket b of a phase's histogram counts the times that took at most 2^b ns.
+//The last bucket also counts everything slower
+const int METRICS_HISTOGRAM_BUCKETS = 40;
+
+class Metrics
+{
+    private:
+        static void writeJson(std::ostream& output);
+        static void writePrometheus(std::ostream& output);
+        static void writeOnExit();
+
+    public:
+        static bool isEnabled();
+        static void add(MetricCounter counter, long amount);
+        static void record(MetricPhase phase, long nanoseconds);
+        static long getCount(MetricCounter counter);
+        static void write(std::ostream& output, MetricsFormat format);
+        static bool writeFile(const std::string& path, std::string& error);
+        static void writeFileAtExit(const std::string& path);
+};
+
+
+//times the scope it's declared in and records it against a phase
+class PhaseTimer
+{
+    private:
+        MetricPhase phase;
+        std::chrono::steady_clock::time_point start;
+
+    public:
+        PhaseTimer(MetricPhase phase)
+            : phase(phase), start(std::chrono::steady_clock::now()) {}
+        ~PhaseTimer(){
+            std::chrono::nanoseconds elapsed =
+                std::chrono::steady_clock::now() - this->start;
+            Metrics::record(this->phase, (long)elapsed.count());
+        }
+};
+
+
+//number of characters amount takes up when printed in decimal
+inline long decimalWidth(Amount amount){
+    long width = amount < 0 ? 2 : 1;
+    while(amount >= 10 || amount <= -10){
+        amount /= 10;
+        width++;
+    }
+    return width;
+}
+
+
+#if POKERCALC_METRICS
+#define METRICS_TIME_PHASE(phase) PhaseTimer metricsPhaseTimer(phase)
+#define METRICS_ADD(counter, amount) Metrics::add(counter, amount)
+#else
+#define METRICS_TIME_PHASE(phase)
+#define METRICS_ADD(counter, amount)
+#endif
+
+#endif
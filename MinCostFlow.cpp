@@ -0,0 +1,553 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Implementation of the MinCostFlow class. Potentials are kept
+ *              on the nodes so that no arc with room left has a negative
+ *              reduced cost, which lets Dijkstra's algorithm find the shortest
+ *              paths even though sending money back along an arc earns its
+ *              cost back. After a phase's shortest paths are found, the
+ *              potentials are raised by each node's distance, which leaves
+ *              exactly the arcs on shortest paths with a reduced cost of 0.
+ *              The blocking flows only use those arcs, so every unit sent in
+ *              a phase takes a shortest path, and the flow is the cheapest
+ *              when every supply has been sent.
+ *
+ *              A cheapest flow has no cycle with a cost in either direction,
+ *              so the flow can be pushed around any cycle of arcs it uses
+ *              without changing its cost. makeForest() does that until an
+ *              arc on each cycle runs dry, which leaves a forest.
+*******************************************************************************/
+#include "MinCostFlow.hpp"
+#include "Metrics.hpp"
+#include <climits>
+#include <functional>
+#include <queue>
+#include <utility>
+
+
+/*******************************************************************************
+ *                     MinCostFlow(const vector<Amount>&)
+ * Description: Constructor. Takes the supply of every node, negative for a
+ *              demand. The supplies must sum to 0.
+*******************************************************************************/
+MinCostFlow::MinCostFlow(const std::vector<Amount>& supplies)
+    : excesses(supplies) {
+    this->nodeCount = supplies.size();
+    this->arcCount = 0;
+    this->phaseCount = 0;
+}
+
+
+/*******************************************************************************
+ *                            reserveArcs(int)
+ * Description: makes room for count arcs, so adding them doesn't reallocate
+*******************************************************************************/
+void MinCostFlow::reserveArcs(int count){
+    this->sources.reserve(count);
+    this->targets.reserve(count);
+    this->costs.reserve(count);
+}
+
+
+/*******************************************************************************
+ *                       addArc(int, int, long long)
+ * Description: adds an arc that can carry any amount from source to target
+ *              at cost per unit, and returns its index. Costs must not be
+ *              negative. Arcs must all be added before solve() is called.
+*******************************************************************************/
+int MinCostFlow::addArc(int source, int target, long long cost){
+    this->sources.push_back(source);
+    this->targets.push_back(target);
+    this->costs.push_back(cost);
+    return this->arcCount++;
+}
+
+
+/*******************************************************************************
+ *                            buildResiduals()
+ * Description: lists each node's residual arcs in CSR form, with a counting
+ *              sort over the arcs' ends
+*******************************************************************************/
+void MinCostFlow::buildResiduals(){
+    int nodeCount = this->nodeCount;
+    this->residualOffsets.assign(nodeCount + 1, 0);
+    for(int arc = 0; arc < this->arcCount; ++arc){
+        this->residualOffsets[this->sources[arc] + 1]++;
+        this->residualOffsets[this->targets[arc] + 1]++;
+    }
+    for(int i = 0; i < nodeCount; ++i){
+        this->residualOffsets[i + 1] += this->residualOffsets[i];
+    }
+
+    std::vector<int> next(this->residualOffsets.begin(),
+                          this->residualOffsets.end() - 1);
+    this->residuals.resize(2 * (size_t)this->arcCount);
+    for(int arc = 0; arc < this->arcCount; ++arc){
+        this->residuals[next[this->sources[arc]]++] = 2 * arc;
+        this->residuals[next[this->targets[arc]]++] = 2 * arc + 1;
+    }
+}
+
+
+/*******************************************************************************
+ *                          findShortestPaths()
+ * Description: runs Dijkstra's algorithm on reduced costs from every node
+ *              with supply left, stopping at the first node with demand left.
+ *              Each node's potential is raised by its distance, or by that
+ *              node's distance if it's further, so no reduced cost goes
+ *              negative and the arcs on shortest paths to the demand are left
+ *              with reduced costs of 0. Returns false if no demand can be
+ *              reached.
+*******************************************************************************/
+bool MinCostFlow::findShortestPaths(){
+    typedef std::pair<long long, int> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > heap;
+    std::vector<long long>& distances = this->distances;
+    const long long* potentials = this->potentials.data();
+
+    distances.assign(this->nodeCount, LLONG_MAX);
+    for(int i = 0; i < this->nodeCount; ++i){
+        if(this->excesses[i] > 0){
+            distances[i] = 0;
+            heap.push(Entry(0, i));
+        }
+    }
+
+    //path holds the nodes whose distance is final
+    long long shortest = LLONG_MAX;
+    this->path.clear();
+    while(!heap.empty()){
+        Entry top = heap.top();
+        heap.pop();
+        long long distance = top.first;
+        int node = top.second;
+        if(distance > distances[node]){
+            continue;
+        }
+        if(this->excesses[node] < 0){
+            shortest = distance;
+            break;
+        }
+        this->path.push_back(node);
+
+        for(int i = this->residualOffsets[node];
+            i < this->residualOffsets[node + 1]; ++i){
+            int residual = this->residuals[i];
+            int arc = residual >> 1;
+            int next;
+            long long cost;
+            if(residual & 1){
+                if(this->flows[arc] == 0){
+                    continue;
+                }
+                next = this->sources[arc];
+                cost = -this->costs[arc];
+            }
+            else{
+                next = this->targets[arc];
+                cost = this->costs[arc];
+            }
+
+            long long reached = distance + cost + potentials[node] -
+                                potentials[next];
+            if(reached < distances[next]){
+                distances[next] = reached;
+                heap.push(Entry(reached, next));
+            }
+        }
+    }
+    if(shortest == LLONG_MAX){
+        return false;
+    }
+
+    for(int i = 0; i < this->nodeCount; ++i){
+        this->potentials[i] += shortest;
+    }
+    for(int i = 0; i < this->path.size(); ++i){
+        int node = this->path[i];
+        this->potentials[node] -= shortest - distances[node];
+    }
+    return true;
+}
+
+
+/*******************************************************************************
+ *                              findLevels()
+ * Description: breadth first search from every node with supply left over
+ *              the residual arcs with room and a reduced cost of 0, labelling
+ *              each node with the number of arcs it's reached in. Stops at the
+ *              level of the first node with demand left. Returns false if no
+ *              demand can be reached.
+*******************************************************************************/
+bool MinCostFlow::findLevels(){
+    std::vector<int>& levels = this->levels;
+    std::vector<int>& queue = this->path;
+    const long long* potentials = this->potentials.data();
+
+    levels.assign(this->nodeCount, -1);
+    queue.clear();
+    for(int i = 0; i < this->nodeCount; ++i){
+        if(this->excesses[i] > 0){
+            levels[i] = 0;
+            queue.push_back(i);
+        }
+    }
+
+    int demandLevel = -1;
+    for(int head = 0; head < queue.size(); ++head){
+        int node = queue[head];
+        if(demandLevel >= 0 && levels[node] >= demandLevel){
+            break;
+        }
+
+        for(int i = this->residualOffsets[node];
+            i < this->residualOffsets[node + 1]; ++i){
+            int residual = this->residuals[i];
+            int arc = residual >> 1;
+            int next;
+            long long cost;
+            if(residual & 1){
+                if(this->flows[arc] == 0){
+                    continue;
+                }
+                next = this->sources[arc];
+                cost = -this->costs[arc];
+            }
+            else{
+                next = this->targets[arc];
+                cost = this->costs[arc];
+            }
+
+            if(levels[next] < 0 &&
+               cost + potentials[node] - potentials[next] == 0){
+                levels[next] = levels[node] + 1;
+                queue.push_back(next);
+                if(this->excesses[next] < 0){
+                    demandLevel = levels[next];
+                }
+            }
+        }
+    }
+    return demandLevel >= 0;
+}
+
+
+/*******************************************************************************
+ *                           sendBlockingFlow()
+ * Description: sends flow from the nodes with supply left to nodes with
+ *              demand left along paths that go up one level per arc, until
+ *              every such path has an arc or a node that can't take more.
+ *              Paths are found by depth first search with an explicit stack,
+ *              and each node remembers which of its arcs it tried last, so no
+ *              arc is tried again once it has led nowhere.
+*******************************************************************************/
+void MinCostFlow::sendBlockingFlow(){
+    std::vector<int>& levels = this->levels;
+    std::vector<int>& currentArcs = this->currentArcs;
+    std::vector<int>& path = this->path;
+    const long long* potentials = this->potentials.data();
+    currentArcs.assign(this->residualOffsets.begin(),
+                       this->residualOffsets.end() - 1);
+
+    for(int start = 0; start < this->nodeCount; ++start){
+        while(levels[start] == 0 && this->excesses[start] > 0){
+            //find a path to a node with demand
+            path.clear();
+            int node = start;
+            while(node >= 0 && this->excesses[node] >= 0){
+                bool advanced = false;
+                for(; currentArcs[node] < this->residualOffsets[node + 1];
+                    ++currentArcs[node]){
+                    int residual = this->residuals[currentArcs[node]];
+                    int arc = residual >> 1;
+                    int next;
+                    long long cost;
+                    if(residual & 1){
+                        if(this->flows[arc] == 0){
+                            continue;
+                        }
+                        next = this->sources[arc];
+                        cost = -this->costs[arc];
+                    }
+                    else{
+                        next = this->targets[arc];
+                        cost = this->costs[arc];
+                    }
+
+                    if(levels[next] == levels[node] + 1 &&
+                       cost + potentials[node] - potentials[next] == 0){
+                        path.push_back(residual);
+                        node = next;
+                        advanced = true;
+                        break;
+                    }
+                }
+                if(advanced){
+                    continue;
+                }
+
+                //a dead end. Nothing will get through it this round
+                levels[node] = -1;
+                if(path.empty()){
+                    node = -1;
+                    break;
+                }
+                int residual = path.back();
+                path.pop_back();
+                int arc = residual >> 1;
+                node = (residual & 1) ? this->targets[arc] : this->sources[arc];
+                currentArcs[node]++;
+            }
+            if(node < 0){
+                break;
+            }
+
+            //send as much as the supply, the demand and the flows that can
+            //be given back allow
+            Amount amount = this->excesses[start];
+            if(-this->excesses[node] < amount){
+                amount = -this->excesses[node];
+            }
+            for(int i = 0; i < path.size(); ++i){
+                int arc = path[i] >> 1;
+                if((path[i] & 1) && this->flows[arc] < amount){
+                    amount = this->flows[arc];
+                }
+            }
+            for(int i = 0; i < path.size(); ++i){
+                int arc = path[i] >> 1;
+                if(path[i] & 1){
+                    this->flows[arc] -= amount;
+                }
+                else{
+                    this->flows[arc] += amount;
+                }
+            }
+            this->excesses[start] -= amount;
+            this->excesses[node] += amount;
+        }
+    }
+}
+
+
+/*******************************************************************************
+ *                              makeForest()
+ * Description: takes the arcs with flow one at a time, keeping a forest of
+ *              the ones taken so far. An arc that joins two trees joins them,
+ *              the smaller tree hanging from it. An arc whose ends are in the
+ *              same tree closes a cycle, and flow is pushed around the cycle
+ *              against the arc until the arc or one of the tree's arcs runs
+ *              dry. The arc that ran dry leaves, and if it's in the tree, the
+ *              new arc takes its place. Pushing around the cycle costs
+ *              nothing, since the flow is already the cheapest.
+*******************************************************************************/
+void MinCostFlow::makeForest(){
+    int nodeCount = this->nodeCount;
+    std::vector<int> parents(nodeCount, -1);
+    std::vector<int> parentArcs(nodeCount, -1);
+    std::vector<int> sizes(nodeCount, 1);
+    std::vector<int> marks(nodeCount, -1);
+
+    for(int arc = 0; arc < this->arcCount; ++arc){
+        if(this->flows[arc] == 0){
+            continue;
+        }
+        int source = this->sources[arc];
+        int target = this->targets[arc];
+
+        //mark the path from source up to its root, then climb from target
+        //until the path or target's own root is reached
+        int sourceRoot = source;
+        marks[source] = arc;
+        while(parents[sourceRoot] >= 0){
+            sourceRoot = parents[sourceRoot];
+            marks[sourceRoot] = arc;
+        }
+        int join = target;
+        while(marks[join] != arc && parents[join] >= 0){
+            join = parents[join];
+        }
+
+        //hang the smaller tree from the arc, rooted at its end of the arc
+        int hung = -1;
+        int hungTop = -1;
+        int hangFrom = -1;
+        if(marks[join] != arc){
+            if(sizes[sourceRoot] < sizes[join]){
+                hung = source;
+                hungTop = sourceRoot;
+                hangFrom = target;
+                sizes[join] += sizes[sourceRoot];
+            }
+            else{
+                hung = target;
+                hungTop = join;
+                hangFrom = source;
+                sizes[sourceRoot] += sizes[join];
+            }
+        }
+        else{
+            //going around the cycle against the arc, the arc loses flow, as
+            //do the tree arcs pointing up from target and down to source
+            Amount amount = this->flows[arc];
+            int cut = -1;
+            for(int node = target; node != join; node = parents[node]){
+                int treeArc = parentArcs[node];
+                if(this->sources[treeArc] == node &&
+                   this->flows[treeArc] < amount){
+                    amount = this->flows[treeArc];
+                    cut = node;
+                }
+            }
+            bool cutOnTargetSide = cut >= 0;
+            for(int node = source; node != join; node = parents[node]){
+                int treeArc = parentArcs[node];
+                if(this->targets[treeArc] == node &&
+                   this->flows[treeArc] < amount){
+                    amount = this->flows[treeArc];
+                    cut = node;
+                    cutOnTargetSide = false;
+                }
+            }
+
+            this->flows[arc] -= amount;
+            for(int node = target; node != join; node = parents[node]){
+                int treeArc = parentArcs[node];
+                if(this->sources[treeArc] == node){
+                    this->flows[treeArc] -= amount;
+                }
+                else{
+                    this->flows[treeArc] += amount;
+                }
+            }
+            for(int node = source; node != join; node = parents[node]){
+                int treeArc = parentArcs[node];
+                if(this->targets[treeArc] == node){
+                    this->flows[treeArc] -= amount;
+                }
+                else{
+                    this->flows[treeArc] += amount;
+                }
+            }
+
+            //the arc ran dry and stays out of the forest
+            if(cut < 0){
+                continue;
+            }
+
+            //the tree arc above cut ran dry. What was under it hangs from
+            //the new arc instead
+            hung = cutOnTargetSide ? target : source;
+            hungTop = cut;
+            hangFrom = cutOnTargetSide ? source : target;
+        }
+
+        //reverse the path from hung up to hungTop, so hung is on top, and
+        //hang it from the arc
+        int node = hung;
+        int parent = hangFrom;
+        int parentArc = arc;
+        while(true){
+            int oldParent = parents[node];
+            int oldArc = parentArcs[node];
+            parents[node] = parent;
+            parentArcs[node] = parentArc;
+            if(node == hungTop){
+                break;
+            }
+            parent = node;
+            parentArc = oldArc;
+            node = oldParent;
+        }
+    }
+}
+
+
+/*******************************************************************************
+ *                                 solve()
+ * Description: finds the cheapest flow that meets every node's supply and
+ *              demand, using at most one arc fewer than there are nodes.
+ *              Returns false if the arcs can't meet them all.
+*******************************************************************************/
+bool MinCostFlow::solve(){
+    this->buildResiduals();
+    this->flows.assign(this->arcCount, 0);
+    this->potentials.assign(this->nodeCount, 0);
+    this->phaseCount = 0;
+
+    while(true){
+        bool supplyLeft = false;
+        for(int i = 0; i < this->nodeCount && !supplyLeft; ++i){
+            supplyLeft = this->excesses[i] > 0;
+        }
+        if(!supplyLeft || !this->findShortestPaths()){
+            break;
+        }
+        this->phaseCount++;
+        while(this->findLevels()){
+            this->sendBlockingFlow();
+        }
+    }
+    METRICS_ADD(FLOW_PHASES, this->phaseCount);
+
+    for(int i = 0; i < this->nodeCount; ++i){
+        if(this->excesses[i] != 0){
+            return false;
+        }
+    }
+    this->makeForest();
+    return true;
+}
+
+
+/*******************************************************************************
+ *                              getArcCount()
+ * Description: returns the number of arcs added with addArc()
+*******************************************************************************/
+int MinCostFlow::getArcCount() const {
+    return this->arcCount;
+}
+
+
+/*******************************************************************************
+ *                  getArcSource(int) / getArcTarget(int)
+ * Description: return the node an arc starts at and the node it ends at
+*******************************************************************************/
+int MinCostFlow::getArcSource(int arc) const {
+    return this->sources[arc];
+}
+
+
+int MinCostFlow::getArcTarget(int arc) const {
+    return this->targets[arc];
+}
+
+
+/*******************************************************************************
+ *                               getFlow(int)
+ * Description: returns the flow solve() sent along an arc
+*******************************************************************************/
+Amount MinCostFlow::getFlow(int arc) const {
+    return this->flows[arc];
+}
+
+
+/*******************************************************************************
+ *                              getShortfall(int)
+ * Description: returns how much of a node's supply (positive) or demand
+ *              (negative) the arcs couldn't carry after solve(). It's 0 for
+ *              every node when solve() returns true.
+*******************************************************************************/
+Amount MinCostFlow::getShortfall(int node) const {
+    return this->excesses[node];
+}
+
+
+/*******************************************************************************
+ *                             getPhaseCount()
+ * Description: returns the number of shortest path phases the last solve()
+ *              ran
+*******************************************************************************/
+long MinCostFlow::getPhaseCount() const {
+    return this->phaseCount;
+}
@@ -0,0 +1,79 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Header file for the MinCostFlow class. A MinCostFlow finds a
+ *              cheapest flow through a directed network: each node has a
+ *              supply (positive) or a demand (negative) of money, each arc
+ *              carries any amount of money from its source to its target at
+ *              a cost per unit, and the flow must take every node's supply to
+ *              the nodes with demand as cheaply as possible.
+ *
+ *              It is the primal-dual method: each phase finds the shortest
+ *              paths left from the supplies to the demands with Dijkstra's
+ *              algorithm, then sends as much as it can along paths of exactly
+ *              that length with a blocking flow, the way Dinic's algorithm
+ *              does. Each phase's paths are longer than the last phase's, so
+ *              with small costs, like the unit costs of allowed payments,
+ *              there are only as many phases as the network is wide. The
+ *              cheapest flow found is then made a forest, so it never uses
+ *              more arcs than there are nodes less one.
+*******************************************************************************/
+#ifndef MINCOSTFLOW_HPP
+#define MINCOSTFLOW_HPP
+
+#include <vector>
+#include "Amount.hpp"
+
+class MinCostFlow
+{
+    private:
+        int nodeCount;
+        int arcCount;
+
+        //what each node still has to send (positive) or to be sent
+        //(negative), and its potential. Reduced costs, cost + potential of
+        //the source - potential of the target, never go negative
+        std::vector<Amount> excesses;
+        std::vector<long long> potentials;
+
+        //arc data
+        std::vector<int> sources;
+        std::vector<int> targets;
+        std::vector<long long> costs;
+        std::vector<Amount> flows;
+
+        //the residual network in CSR form. Node i's residual arcs are
+        //residuals[residualOffsets[i]] up to residualOffsets[i + 1]: 2 * arc
+        //for an arc leaving i, which can always take more, and 2 * arc + 1
+        //for an arc entering i, which can give back its flow
+        std::vector<int> residualOffsets;
+        std::vector<int> residuals;
+
+        //scratch space for the phases
+        std::vector<long long> distances;
+        std::vector<int> levels;
+        std::vector<int> currentArcs;
+        std::vector<int> path;
+
+        long phaseCount;
+
+        void buildResiduals();
+        bool findShortestPaths();
+        bool findLevels();
+        void sendBlockingFlow();
+        void makeForest();
+
+    public:
+        MinCostFlow(const std::vector<Amount>& supplies);
+        void reserveArcs(int count);
+        int addArc(int source, int target, long long cost);
+        bool solve();
+        int getArcCount() const;
+        int getArcSource(int arc) const;
+        int getArcTarget(int arc) const;
+        Amount getFlow(int arc) const;
+        Amount getShortfall(int node) const;
+        long getPhaseCount() const;
+};
+
+#endif
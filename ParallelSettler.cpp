@@ -0,0 +1,236 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Implementation of the ParallelSettler class. Games are split
+ *              into small ranges and each range is a task on the ThreadPool.
+ *              Ranges are small enough that workers which finish early can
+ *              steal from workers that drew larger games.
+*******************************************************************************/
+#include "ParallelSettler.hpp"
+#include "PlayerGraph.hpp"
+#include <algorithm>
+#include <sstream>
+
+//tasks per worker thread each call to settleGames() is split into
+const int TASKS_PER_THREAD = 8;
+
+
+/*******************************************************************************
+ *                       ParallelSettler(int, SolverType)
+ * Description: Constructor. Takes the number of threads to settle games on
+ *              and the algorithm to solve them with. With one thread, games
+ *              are settled on the calling thread and no pool is started.
+*******************************************************************************/
+ParallelSettler::ParallelSettler(int threadCount, SolverType solver) {
+    this->solver = solver;
+    this->allowed = NULL;
+    this->objective = FEWEST_PAYMENTS;
+    this->maxPayments = 0;
+    this->cache = NULL;
+    this->pool = NULL;
+    if(threadCount > 1){
+        this->pool = new ThreadPool(threadCount);
+    }
+}
+
+
+/*******************************************************************************
+ *                            ~ParallelSettler()
+ * Description: Destructor. Stops the thread pool.
+*******************************************************************************/
+ParallelSettler::~ParallelSettler() {
+    delete this->pool;
+}
+
+
+/*******************************************************************************
+ *                            getThreadCount()
+ * Description: returns the number of threads games are settled on
+*******************************************************************************/
+int ParallelSettler::getThreadCount() const {
+    if(this->pool == NULL){
+        return 1;
+    }
+    return this->pool->getThreadCount();
+}
+
+
+/*******************************************************************************
+ *          setAllowedPayments(const AllowedPayments*, SettlementObjective)
+ * Description: settles every game from now on with only the allowed
+ *              payments, keeping the objective down, instead of with the
+ *              solver. NULL goes back to letting anyone pay anyone. The
+ *              AllowedPayments must outlive the settling.
+*******************************************************************************/
+void ParallelSettler::setAllowedPayments(const AllowedPayments* allowed,
+                                         SettlementObjective objective) {
+    this->allowed = allowed;
+    this->objective = objective;
+}
+
+
+/*******************************************************************************
+ *                           setMaxPayments(int)
+ * Description: settles every game from now on so that no player makes and
+ *              receives more than maxPayments payments, which must be at least
+ *              2, instead of with the solver. 0 lifts the limit.
+*******************************************************************************/
+void ParallelSettler::setMaxPayments(int maxPayments) {
+    this->maxPayments = maxPayments;
+}
+
+
+/*******************************************************************************
+ *                        setCache(SettlementCache*)
+ * Description: settles every game the solver would from now on through the
+ *              cache, which must outlive the settling. NULL solves every game
+ *              afresh.
+*******************************************************************************/
+void ParallelSettler::setCache(SettlementCache* cache) {
+    this->cache = cache;
+}
+
+
+/*******************************************************************************
+ *                  settleGames(const vector<LedgerGame>&,
+ *                              vector<GameSettlement>&)
+ * Description: Settles every game and stores game i's result in results[i].
+ *              Returns once every game has been settled.
+*******************************************************************************/
+void ParallelSettler::settleGames(const std::vector<LedgerGame>& games,
+                                  std::vector<GameSettlement>& results) {
+    int gameCount = games.size();
+    results.resize(gameCount);
+
+    if(this->pool == NULL){
+        this->settleRange(&games, &results, 0, gameCount);
+        return;
+    }
+
+    int taskCount = this->pool->getThreadCount() * TASKS_PER_THREAD;
+    int rangeSize = (gameCount + taskCount - 1) / taskCount;
+    if(rangeSize < 1){
+        rangeSize = 1;
+    }
+
+    for(int first = 0; first < gameCount; first += rangeSize){
+        int last = std::min(first + rangeSize, gameCount);
+        this->pool->submit(std::bind(&ParallelSettler::settleRange, this,
+                                     &games, &results, first, last));
+    }
+    this->pool->wait();
+}
+
+
+/*******************************************************************************
+ *                              settleRange()
+ * Description: Settles games first up to, but not including, last.
+*******************************************************************************/
+void ParallelSettler::settleRange(const std::vector<LedgerGame>* games,
+                                  std::vector<GameSettlement>* results,
+                                  int first, int last) const {
+    for(int i = first; i < last; ++i){
+        settleGame(games->at(i), this->solver, results->at(i), this->allowed,
+                   this->objective, this->maxPayments, this->cache);
+    }
+}
+
+
+/*******************************************************************************
+ *            settleGame(const LedgerGame&, SolverType, GameSettlement&,
+ *                       const AllowedPayments*, SettlementObjective, int,
+ *                       SettlementCache*)
+ * Description: Solves a single game, with the solver, or with only the
+ *              allowed payments if allowed isn't NULL, or with no player
+ *              making and receiving more than maxPayments payments if
+ *              maxPayments isn't 0. A game settled with the solver goes
+ *              through the cache if there is one. If the game can't be
+ *              settled, the reason is stored in result.error and there are no
+ *              payments. Only touches the game itself and result, besides the
+ *              cache, which is locked, so any number of games can be settled
+ *              at once.
+*******************************************************************************/
+void ParallelSettler::settleGame(const LedgerGame& record, SolverType solver,
+                                 GameSettlement& result,
+                                 const AllowedPayments* allowed,
+                                 SettlementObjective objective,
+                                 int maxPayments,
+                                 SettlementCache* cache) {
+    Game* game = record.game;
+    result.payments.clear();
+    if(!checkGame(record, result.error)){
+        return;
+    }
+
+    PlayerGraph graph(game);
+    if(allowed == NULL && maxPayments > 0){
+        graph.solveGraphBounded(maxPayments);
+    }
+    else if(allowed == NULL && cache != NULL){
+        graph.solveCached(solver, *cache);
+    }
+    else if(allowed == NULL){
+        graph.solve(solver);
+    }
+    else{
+        std::vector<int> payers;
+        std::vector<int> payees;
+        allowed->findPairs(record.gameId, graph, payers, payees);
+        int stranded;
+        if(!graph.solveConstrained(payers, payees, objective, stranded)){
+            std::ostringstream message;
+            message << "line " << record.firstLine << ": the allowed "
+                    << "payments can't settle "
+                    << graph.getPlayerName(stranded);
+            result.error = message.str();
+            return;
+        }
+    }
+    const std::vector<int>& offsets = graph.getEdgeOffsets();
+    const std::vector<int>& payees = graph.getEdgePayees();
+    const std::vector<Amount>& amounts = graph.getEdgeAmounts();
+
+    result.payments.resize(graph.getEdgeCount());
+    for(int i = 0; i < graph.getNodeCount(); ++i){
+        for(int j = offsets[i]; j < offsets[i + 1]; ++j){
+            result.payments[j].payer = graph.getPlayer(i);
+            result.payments[j].payee = graph.getPlayer(payees[j]);
+            result.payments[j].amount = amounts[j];
+        }
+    }
+}
+
+
+/*******************************************************************************
+ *                 checkGame(const LedgerGame&, std::string&)
+ * Description: Returns true if a game read from a ledger can be settled: its
+ *              rows were valid, its totals fit in an Amount and its stacks add
+ *              up to its purse. Otherwise sets error to why not.
+*******************************************************************************/
+bool ParallelSettler::checkGame(const LedgerGame& record, std::string& error) {
+    Game* game = record.game;
+    error = record.error;
+    if(!error.empty()){
+        return false;
+    }
+
+    //totals that don't fit in an Amount can't be compared or settled
+    if(!game->amountsFit()){
+        std::ostringstream message;
+        message << "line " << record.firstLine << ": amounts overflow the "
+                << POKERCALC_AMOUNT_BITS << " bit amount type";
+        error = message.str();
+        return false;
+    }
+
+    //the same precondition Game::checkStacks() enforces interactively
+    if(game->getTotalStacks() != game->getTotalPurse()){
+        std::ostringstream message;
+        message << "line " << record.firstLine << ": stacks total "
+                << game->getTotalStacks() << " but the purse is "
+                << game->getTotalPurse();
+        error = message.str();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,61 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Header file for the ParallelSettler class. A ParallelSettler
+ *              settles many independent games at once on a work-stealing
+ *              ThreadPool. Every game gets its own PlayerGraph, so nothing is
+ *              shared between the threads while they solve, and each game's
+ *              result is stored at the game's own position, so results come
+ *              back in input order and are the same for any thread count.
+*******************************************************************************/
+#ifndef PARALLELSETTLER_HPP
+#define PARALLELSETTLER_HPP
+
+#include <string>
+#include <vector>
+#include "AllowedPayments.hpp"
+#include "LedgerReader.hpp"
+#include "SettlementCache.hpp"
+#include "Structs.hpp"
+#include "ThreadPool.hpp"
+
+struct GameSettlement{
+    std::vector<Payment> payments;  //in the order Game::printResults() uses
+    std::string error;              //empty if the game was settled
+};
+
+class ParallelSettler
+{
+    private:
+        ThreadPool* pool;   //NULL when settling on the calling thread
+        SolverType solver;
+        const AllowedPayments* allowed;     //NULL if anyone can pay anyone
+        SettlementObjective objective;
+        int maxPayments;    //0 if players can make any number of payments
+        SettlementCache* cache;     //NULL if every game is solved afresh
+
+        void settleRange(const std::vector<LedgerGame>* games,
+                         std::vector<GameSettlement>* results,
+                         int first, int last) const;
+
+    public:
+        ParallelSettler(int threadCount, SolverType solver = GREEDY_SOLVER);
+        ~ParallelSettler();
+        int getThreadCount() const;
+        void setAllowedPayments(const AllowedPayments* allowed,
+                                SettlementObjective objective);
+        void setMaxPayments(int maxPayments);
+        void setCache(SettlementCache* cache);
+        void settleGames(const std::vector<LedgerGame>& games,
+                         std::vector<GameSettlement>& results);
+        static void settleGame(const LedgerGame& record, SolverType solver,
+                               GameSettlement& result,
+                               const AllowedPayments* allowed = NULL,
+                               SettlementObjective objective =
+                                   FEWEST_PAYMENTS,
+                               int maxPayments = 0,
+                               SettlementCache* cache = NULL);
+        static bool checkGame(const LedgerGame& record, std::string& error);
+};
+
+#endif
@@ -8,17 +8,28 @@
  *              add an additional buy-in to the player.
 *******************************************************************************/
 #include "Player.hpp"
+#include "PlayerNames.hpp"
 
 
 /*******************************************************************************
- *                           Player(std::string, int)
- * Description: Constructor that takes a string and an int. Sets the player's
- *              name to the string, and sets the initial buy-in to the integer.
+ *                           Player(std::string, Amount)
+ *                            Player(uint32_t, Amount)
+ * Description: Constructors that take a name, or the id PlayerNames gave it,
+ *              and an Amount. Sets the player's name to the name, and sets the
+ *              initial buy-in to the amount.
  *              Sets final stack count to -1, which is a flag value for an 
- *              un-set final stack.
+ *              un-set final stack. Only the name's id is kept; the name itself
+ *              is stored once, in PlayerNames, for every player with it.
 *******************************************************************************/
-Player::Player(std::string name, int cents) {
-    this->name = name;
+Player::Player(const std::string& name, Amount cents) {
+    this->nameId = PlayerNames::intern(name);
+    this->buyIn = cents;
+    this->finalStack = -1;
+}
+
+
+Player::Player(uint32_t nameId, Amount cents) {
+    this->nameId = nameId;
     this->buyIn = cents;
     this->finalStack = -1;
 }
@@ -34,43 +45,50 @@ Player::~Player() {
 
 /*******************************************************************************
  *                     getters and setters for Player class
- * Description: Return or set member variables for the Player object
+ * Description: Return or set member variables for the Player object. The name
+ *              is looked up in PlayerNames and returned by reference, so
+ *              reading it never copies it.
 *******************************************************************************/
-int Player::getBuyIn() {
+Amount Player::getBuyIn() const {
     return this->buyIn;
 }
 
 
-std::string Player::getName() {
-    return this->name;
+const std::string& Player::getName() const {
+    return PlayerNames::getName(this->nameId);
+}
+
+
+uint32_t Player::getNameId() const {
+    return this->nameId;
 }
 
 
-void Player::setBuyIn(int cents) {
+void Player::setBuyIn(Amount cents) {
     this->buyIn = cents;
 }
 
 
-void Player::setFinalStack(int cents) {
+void Player::setFinalStack(Amount cents) {
     this->finalStack = cents;
 }
 
 
-int Player::getFinalStack() {
+Amount Player::getFinalStack() const {
     return this->finalStack;
 }
 
 
-void Player::setName(std::string name) {
-    this->name = name;
+void Player::setName(const std::string& name) {
+    this->nameId = PlayerNames::intern(name);
 }
 
 
 /*******************************************************************************
- *                             addBuyIn(int)
+ *                             addBuyIn(Amount)
  * Description: Adds a buy-in amount to the player's buy-in
 *******************************************************************************/
-void Player::addBuyIn(int cents) {
+void Player::addBuyIn(Amount cents) {
     this->buyIn += cents;
 }
 
@@ -9,31 +9,35 @@
 *******************************************************************************/
 #ifndef PLAYER_HPP
 #define PLAYER_HPP
+#include <stdint.h>
 #include <string>
+#include "Amount.hpp"
 
 
 class Player 
 {
     private:
-        int buyIn;
-        int finalStack;
-        std::string name;
+        Amount buyIn;
+        Amount finalStack;
+        uint32_t nameId;    //the name's id in PlayerNames
 
     public:
         //constructors destructors
-        Player(std::string name, int cents);
+        Player(const std::string& name, Amount cents);
+        Player(uint32_t nameId, Amount cents);
         ~Player();
         
         //getters/setters
-        int getFinalStack();
-        int getBuyIn();
-        void setBuyIn(int cents);
-        void setFinalStack(int cents);
-        std::string getName();
-        void setName(std::string name);
+        Amount getFinalStack() const;
+        Amount getBuyIn() const;
+        void setBuyIn(Amount cents);
+        void setFinalStack(Amount cents);
+        const std::string& getName() const;
+        uint32_t getNameId() const;
+        void setName(const std::string& name);
 
         //additional functions
-        void addBuyIn(int cents);
+        void addBuyIn(Amount cents);
 };
 
 #endif
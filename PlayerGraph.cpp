@@ -8,71 +8,217 @@
  *              or is owed. At first, there are no edges in the graph. The
  *              PlayerGraph then solves the graph by a greedy algorithm that
  *              runs in O(n * log(n)) time where n is the number of players.
+ *              Nodes are indices into flat arrays and the heaps hold indices,
+ *              so solving allocates a fixed number of buffers up front instead
+ *              of one object per node and per edge.
 *******************************************************************************/
 #include "helperFunctions.hpp"
 #include <iostream>
 #include "PlayerGraph.hpp"
 #include "Player.hpp"
-#include <cassert>
+#include "BinaryLedger.hpp"
+#include "Metrics.hpp"
+#include "Validation.hpp"
+#include "SettlementWriter.hpp"
+#include "MinCostFlow.hpp"
+#include "AmountKernels.hpp"
+#include "SettlementCache.hpp"
 #include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+//solveGraphBuckets() sorts RADIX_BITS bits of the balances per pass, and
+//sorts lists shorter than RADIX_MIN_NODES with std::sort instead
+const int RADIX_BITS = 11;
+const int RADIX_BUCKETS = 1 << RADIX_BITS;
+const int RADIX_MIN_NODES = 256;
+
+//pairExactMatches() only looks for zero-sum triples when the unmatched losers
+//times the unmatched winners is at most this, so it stays well under a
+//millisecond
+const long TRIPLE_MAX_WORK = 1 << 16;
 
 
 /*******************************************************************************
 **                            PlayerGraph(Game*)
 ** Description: Constructor for a player graph. Takes a pointer to a game 
-**              object, ensures the game is balanced - that is that al of the 
-**              players' stacks sum to the game's purse, then it initializes the
-**              graph.
+**              object, initializes the graph, then ensures the game is
+**              balanced - that is that al of the players' stacks sum to the
+**              game's purse. The graph refers to the game's players rather
+**              than copying them, so the game must outlive it.
 *******************************************************************************/
 PlayerGraph::PlayerGraph(Game* game){
-    std::vector<Player*> players = game->getPlayers();
-
-    //ensure the game is balanced
-    int playerFinalStackSum = 0;
-    for(int i = 0; i < players.size(); ++i){
-        playerFinalStackSum += players.at(i)->getFinalStack();
-    }
-    assert(game->getTotalPurse() == playerFinalStackSum);
+    METRICS_TIME_PHASE(BUILD_GRAPH_PHASE);
+    const std::vector<std::unique_ptr<Player> >& players = game->getPlayers();
 
     //initialize the graph
+    this->ledger = NULL;
+    this->exactMatchPairing = true;
+    this->pairedPayments = 0;
     this->initializeGraph(players);
+
+    //ensure the game is balanced. The balances are the buy-ins less the
+    //final stacks, so they sum to 0 exactly when the stacks sum to the purse
+    VALIDATE_CHEAP(AmountKernels::sumAmounts(this->balances.data(),
+                                             players.size()) == 0);
 }
 
 
 /*******************************************************************************
-**                               ~PlayerGraph()
-** Description: Player Graph destructor. Frees dynamically allocated memory.
+**                       PlayerGraph(const BinaryLedger&)
+** Description: Constructor for a player graph of the players in an open binary
+**              ledger. The balances are read straight from the ledger's
+**              records and no Player objects are made; names are looked up in
+**              the ledger when they're needed, so it must stay open for as
+**              long as the graph is used. The ledger must be balanced.
 *******************************************************************************/
-PlayerGraph::~PlayerGraph(){
-    //deallocate adjacencey list for each Player
-    for(int i = 0; i < this->adjList.size(); ++i){
+PlayerGraph::PlayerGraph(const BinaryLedger& ledger){
+    METRICS_TIME_PHASE(BUILD_GRAPH_PHASE);
+    int playerCount = ledger.getRecordCount();
 
-        //deallocate adjcacent nodes for each player node in the graph
-        for(int j = 0; j < adjList.at(i)->adjacentNodes.size(); j++){
-            delete this->adjList.at(i)->adjacentNodes.at(j);
-        }
+    this->roster = NULL;
+    this->ledger = &ledger;
+    this->exactMatchPairing = true;
+    this->pairedPayments = 0;
+    this->playerIds.resize(playerCount);
+    this->balances.resize(playerCount);
+    for(int i = 0; i < playerCount; i++){
+        this->playerIds[i] = i;
+    }
+    AmountKernels::ledgerBalances(ledger.getRecords(), playerCount,
+                                  this->balances.data());
+
+    //no edges yet
+    this->edgeOffsets.assign(playerCount + 1, 0);
+}
+
+
+/*******************************************************************************
+**                     getNodeCount() / getEdgeCount()
+** Description: return the number of nodes (players) and edges (payments) in
+**              the graph
+*******************************************************************************/
+int PlayerGraph::getNodeCount() const
+{
+    return this->balances.size();
+}
+
+
+int PlayerGraph::getEdgeCount() const
+{
+    return this->edgePayees.size();
+}
+
+
+/*******************************************************************************
+**                              getPlayer(int)
+** Description: returns the player represented by a node
+*******************************************************************************/
+Player* PlayerGraph::getPlayer(int node) const
+{
+    VALIDATE_CHEAP(this->ledger == NULL);
+    return (*this->roster)[this->playerIds[node]].get();
+}
 
-        delete this->adjList.at(i);
+
+/*******************************************************************************
+**                          getPlayerName(int)
+**                          getPlayerName(int, size_t&)
+**                          getPlayerBuyIn(int)
+**                          getPlayerFinalStack(int)
+** Description: return the name, buy-in and final stack of the player a node
+**              represents, whether the graph was made from a Game or from a
+**              binary ledger. The second version of getPlayerName() points at
+**              the name where it's kept, the Player or the ledger's mapping,
+**              instead of copying it; the name is not null terminated.
+*******************************************************************************/
+std::string PlayerGraph::getPlayerName(int node) const
+{
+    size_t length;
+    const char* name = this->getPlayerName(node, length);
+    return std::string(name, length);
+}
+
+
+const char* PlayerGraph::getPlayerName(int node, size_t& length) const
+{
+    if(this->ledger != NULL){
+        const LedgerFileRecord& record =
+            this->ledger->getRecord(this->playerIds[node]);
+        return this->ledger->getName(record.id, length);
+    }
+    const std::string& name = this->getPlayer(node)->getName();
+    length = name.size();
+    return name.data();
+}
+
+
+Amount PlayerGraph::getPlayerBuyIn(int node) const
+{
+    if(this->ledger != NULL){
+        return this->ledger->getRecord(this->playerIds[node]).buyIn;
     }
+    return this->getPlayer(node)->getBuyIn();
+}
+
+
+Amount PlayerGraph::getPlayerFinalStack(int node) const
+{
+    if(this->ledger != NULL){
+        return this->ledger->getRecord(this->playerIds[node]).finalStack;
+    }
+    return this->getPlayer(node)->getFinalStack();
 }
 
 
 /*******************************************************************************
-**                           getAdjList()
-** Description: returns the adjacency list, which is represented by a vector of
-**              pointers to nodes
+**                    getEdgeOffsets() / getEdgePayees() / getEdgeAmounts()
+** Description: return the edges of the graph in CSR form. The payments made
+**              by node i are the entries of getEdgePayees() and
+**              getEdgeAmounts() from getEdgeOffsets()[i] up to, but not
+**              including, getEdgeOffsets()[i + 1]. Each node's payments are in
+**              the order solveGraph() made them.
 *******************************************************************************/
-std::vector<struct Node*> PlayerGraph::getAdjList()
+const std::vector<int>& PlayerGraph::getEdgeOffsets() const
+{
+    return this->edgeOffsets;
+}
+
+
+const std::vector<int>& PlayerGraph::getEdgePayees() const
 {
-    return this->adjList;
+    return this->edgePayees;
+}
+
+
+const std::vector<Amount>& PlayerGraph::getEdgeAmounts() const
+{
+    return this->edgeAmounts;
+}
+
+/*******************************************************************************
+**               setExactMatchPairing(bool) / getPairedPayments()
+** Description: turn the exact match pass of solveGraph() and
+**              solveGraphBuckets() on (the default) or off, and return how
+**              many of the last solve's payments it made
+*******************************************************************************/
+void PlayerGraph::setExactMatchPairing(bool pairing)
+{
+    this->exactMatchPairing = pairing;
+}
+
+
+int PlayerGraph::getPairedPayments() const
+{
+    return this->pairedPayments;
 }
 
 /*******************************************************************************
 **                              initializeGraph
-** input: - a vector of Player objects
-**        - an int, the total pot of the game
+** input: - the game's vector of Player objects, which the graph refers to
 ** description: initializes the graph by determining the value of each node
-**              (the playerOwed field). This value is determined by taking the
+**              (its entry in balances). This value is determined by taking the
 **              player's totalStack and subtracting the player's finalStack.
 **              Thus, negative values represent money owed to the player, and
 **              positive values represent a debt the player owes. More like a 
@@ -83,69 +229,303 @@ std::vector<struct Node*> PlayerGraph::getAdjList()
 **                is, the sum of the player's finalStacks must equal the total
 **                pot for the game.
 *******************************************************************************/
-void PlayerGraph::initializeGraph(std::vector<Player*> players){
+void PlayerGraph::initializeGraph(
+    const std::vector<std::unique_ptr<Player> >& players){
+    int playerCount = players.size();
 
-    for(int i = 0; i < players.size(); i++){
-        Player* currPlayer = players.at(i);
-        struct Node* newNode = new struct Node;
-        newNode->player = currPlayer;
+    this->roster = &players;
+    this->playerIds.resize(playerCount);
+    this->balances.resize(playerCount);
 
-        //node's value = initial buy-in - final stack
-        newNode->playerOwed = currPlayer->getBuyIn() - 
-                              currPlayer->getFinalStack();
+    for(int i = 0; i < playerCount; i++){
+        const Player* currPlayer = players[i].get();
+        this->playerIds[i] = i;
 
-        this->adjList.push_back(newNode);
+        //node's value = initial buy-in - final stack
+        this->balances[i] = currPlayer->getBuyIn() - 
+                            currPlayer->getFinalStack();
     }
+
+    //no edges yet
+    this->edgeOffsets.assign(playerCount + 1, 0);
 }
 
 /*******************************************************************************
 **                                  printGraph()
-** Description: Prints a representation of the adjacency list that represents
-**              the Player Graph.
+** Description: Prints the graph to the console as a Graphviz DOT digraph, one
+**              node per player and one edge per payment, which can be drawn
+**              with dot -Tsvg.
 *******************************************************************************/
-void PlayerGraph::printGraph(){
-    std::cout << "The graph:\n";
+void PlayerGraph::printGraph() const {
+    SettlementWriter writer(std::cout, DOT_FORMAT);
+    writer.writeGraph(*this);
+    writer.finish();
+}
 
-    /* iterate through each node, printing the name of the player at that node
-    followed by the name of the player at each adjacent node and the weight of
-    the edge to that node */
-    for(int i = 0; i < this->adjList.size(); ++i){
-        Node* currNode = this->adjList.at(i);
-        std::cout << currNode->player->getName() << " -";
 
-        for(int j = 0; j < currNode->adjacentNodes.size(); ++j){
-            std::cout << currNode->adjacentNodes.at(j)->edgeWeight << "->"
-                      << currNode->adjacentNodes.at(j)->node->player->getName() 
-                      << "-";
-        }
-        std::cout << "\n";
+/*******************************************************************************
+**                 storeEdges(payers, payees, amounts)
+** Description: Takes the edges in the order they were made and stores them in
+**              CSR form, grouped by the paying node. A stable counting sort
+**              keeps each node's edges in the order they were made.
+*******************************************************************************/
+void PlayerGraph::storeEdges(const std::vector<int>& payers,
+                             const std::vector<int>& payees,
+                             const std::vector<Amount>& amounts){
+    int nodeCount = this->getNodeCount();
+    int edgeCount = payers.size();
+
+    //count the edges leaving each node, then turn the counts into offsets
+    this->edgeOffsets.assign(nodeCount + 1, 0);
+    for(int i = 0; i < edgeCount; ++i){
+        this->edgeOffsets[payers[i] + 1]++;
+    }
+    for(int i = 0; i < nodeCount; ++i){
+        this->edgeOffsets[i + 1] += this->edgeOffsets[i];
     }
 
-    std::cout << std::flush;
+    //place each edge after the ones its payer already made
+    std::vector<int> next(this->edgeOffsets.begin(), 
+                          this->edgeOffsets.end() - 1);
+    this->edgePayees.resize(edgeCount);
+    this->edgeAmounts.resize(edgeCount);
+    for(int i = 0; i < edgeCount; ++i){
+        int slot = next[payers[i]]++;
+        this->edgePayees[slot] = payees[i];
+        this->edgeAmounts[slot] = amounts[i];
+    }
+    METRICS_ADD(EDGES_STORED, edgeCount);
 }
 
+
 /*******************************************************************************
-**                       compMin(struct Node*, struct Node*)
-**                       compMax(struct Node*, struct Node*)
-** Description: comparators for struct Node* used to compare pointers to Nodes
-**              for the heap functions in solveGraph()
+**                         hashMagnitude(magnitude)
+** Description: hashes a balance's magnitude for a MagnitudeIndex. Each width
+**              of Amount gets its own version; the 128 bit one folds the high
+**              half into the low half first.
 *******************************************************************************/
-bool compMin(const struct Node* first, struct Node* second){
-    if(first->playerOwed < second->playerOwed){
-        return true;
+inline uint64_t hashMagnitude(int32_t magnitude){
+    return (uint64_t)(uint32_t)magnitude * 0x9E3779B97F4A7C15ULL;
+}
+
+
+inline uint64_t hashMagnitude(int64_t magnitude){
+    return (uint64_t)magnitude * 0x9E3779B97F4A7C15ULL;
+}
+
+
+inline uint64_t hashMagnitude(__int128 magnitude){
+    return ((uint64_t)magnitude ^ (uint64_t)(magnitude >> 64)) *
+           0x9E3779B97F4A7C15ULL;
+}
+
+
+/*******************************************************************************
+**                              MagnitudeIndex
+** Description: an open addressing hash index from a balance's magnitude to
+**              the nodes with that magnitude, kept in the order they were
+**              added. A node that gets settled some other way is skipped, and
+**              dropped, the next time its magnitude is looked up.
+*******************************************************************************/
+struct MagnitudeIndex{
+    const Amount* balances;
+    std::vector<Amount> keys;
+    std::vector<int> heads;     //first node with the slot's magnitude, -1
+                                //for an unused slot, -2 once it's emptied
+    std::vector<int> tails;
+    std::vector<int>& next;     //the node after each node, shared by indexes
+    uint64_t mask;
+    int shift;
+
+    MagnitudeIndex(const Amount* balances, int nodes, std::vector<int>& next)
+        : balances(balances), next(next) {
+        int bits = 1;
+        while(((size_t)1 << bits) < 2 * (size_t)nodes){
+            bits++;
+        }
+        this->keys.resize((size_t)1 << bits);
+        this->heads.assign((size_t)1 << bits, -1);
+        this->tails.resize((size_t)1 << bits);
+        this->mask = ((uint64_t)1 << bits) - 1;
+        this->shift = 64 - bits;
     }
-    else{
-        return false;
+
+    //the slot for a magnitude, which is empty if it hasn't been added
+    size_t find(Amount magnitude) const {
+        size_t slot = hashMagnitude(magnitude) >> this->shift;
+        while(this->heads[slot] != -1 && this->keys[slot] != magnitude){
+            slot = (slot + 1) & this->mask;
+        }
+        return slot;
     }
-}
 
+    void add(int node, Amount magnitude){
+        size_t slot = this->find(magnitude);
+        this->next[node] = -1;
+        if(this->heads[slot] < 0){
+            this->keys[slot] = magnitude;
+            this->heads[slot] = node;
+        }
+        else{
+            this->next[this->tails[slot]] = node;
+        }
+        this->tails[slot] = node;
+    }
 
-bool compMax(const struct Node* first, struct Node* second){
-    if(first->playerOwed > second->playerOwed){
-        return true;
+    //takes node out of the list in slot, given the node before it
+    void unlink(size_t slot, int previous, int node){
+        if(previous == -1){
+            this->heads[slot] = this->next[node] == -1 ? -2 : this->next[node];
+        }
+        else{
+            this->next[previous] = this->next[node];
+        }
+        if(this->tails[slot] == node){
+            this->tails[slot] = previous;
+        }
     }
-    else{
-        return false;
+
+    //removes and returns the first unsettled node with the magnitude, other
+    //than skip, or returns -1 if there isn't one
+    int take(Amount magnitude, int skip){
+        size_t slot = this->find(magnitude);
+        int previous = -1;
+        int node = this->heads[slot];
+        while(node >= 0){
+            int following = this->next[node];
+            if(this->balances[node] == 0){
+                this->unlink(slot, previous, node);
+            }
+            else if(node != skip){
+                this->unlink(slot, previous, node);
+                return node;
+            }
+            else{
+                previous = node;
+            }
+            node = following;
+        }
+        return -1;
+    }
+};
+
+
+/*******************************************************************************
+**                 pairExactMatches(payers, payees, amounts)
+** Description: settles the nodes that can be settled on their own before the
+**              main solve. Each loser pays the first winner who is owed exactly
+**              what they owe, found in O(1) expected time through a hash index
+**              of the winners' balances, so pairing is O(n) expected. When few
+**              enough nodes are left unmatched (TRIPLE_MAX_WORK), zero-sum
+**              triples are settled too: a loser who owes what two winners are
+**              owed between them pays both, and a winner owed what two losers
+**              owe between them is paid by both. Every group settled here
+**              takes one payment fewer than it has nodes, which is as few as
+**              the group can take, and the solvers are left a smaller problem.
+**              Nodes are tried in index order, so the payments are always the
+**              same for the same balances. The payments are appended to the
+**              edge lists and the nodes' balances are set to 0.
+*******************************************************************************/
+void PlayerGraph::pairExactMatches(std::vector<int>& payers,
+                                   std::vector<int>& payees,
+                                   std::vector<Amount>& amounts){
+    int nodeCount = this->getNodeCount();
+    std::vector<Amount>& balances = this->balances;
+    auto pay = [&](int payer, int payee, Amount amount){
+        payers.push_back(payer);
+        payees.push_back(payee);
+        amounts.push_back(amount);
+        balances[payer] -= amount;
+        balances[payee] += amount;
+    };
+
+    int winnerCount = 0;
+    for(int i = 0; i < nodeCount; i++){
+        if(balances[i] < 0){
+            winnerCount++;
+        }
+    }
+    if(winnerCount == 0){
+        return;
+    }
+
+    //the winner and loser indexes hold different nodes, so they can share
+    //the links between nodes
+    std::vector<int> next(nodeCount);
+    MagnitudeIndex winnerIndex(balances.data(), winnerCount, next);
+    for(int i = 0; i < nodeCount; i++){
+        if(balances[i] < 0){
+            winnerIndex.add(i, -balances[i]);
+        }
+    }
+
+    std::vector<int> losers;
+    for(int i = 0; i < nodeCount; i++){
+        if(balances[i] <= 0){
+            continue;
+        }
+        int winner = winnerIndex.take(balances[i], -1);
+        if(winner >= 0){
+            pay(i, winner, balances[i]);
+        }
+        else{
+            losers.push_back(i);
+        }
+    }
+
+    std::vector<int> winners;
+    for(int i = 0; i < nodeCount; i++){
+        if(balances[i] < 0){
+            winners.push_back(i);
+        }
+    }
+    if((long)losers.size() * (long)winners.size() > TRIPLE_MAX_WORK){
+        return;
+    }
+
+    //a loser who owes what two winners are owed between them
+    for(int l = 0; l < losers.size(); l++){
+        int loser = losers[l];
+        for(int w = 0; w < winners.size(); w++){
+            int winner = winners[w];
+            if(balances[winner] == 0 || -balances[winner] >= balances[loser]){
+                continue;
+            }
+            int other = winnerIndex.take(balances[loser] + balances[winner],
+                                         winner);
+            if(other >= 0){
+                pay(loser, winner, -balances[winner]);
+                pay(loser, other, -balances[other]);
+                break;
+            }
+        }
+    }
+
+    //a winner owed what two losers owe between them
+    MagnitudeIndex loserIndex(balances.data(), losers.size(), next);
+    for(int l = 0; l < losers.size(); l++){
+        if(balances[losers[l]] != 0){
+            loserIndex.add(losers[l], balances[losers[l]]);
+        }
+    }
+    for(int w = 0; w < winners.size(); w++){
+        int winner = winners[w];
+        if(balances[winner] == 0){
+            continue;
+        }
+        for(int l = 0; l < losers.size(); l++){
+            int loser = losers[l];
+            if(balances[loser] == 0 || balances[loser] >= -balances[winner]){
+                continue;
+            }
+            int other = loserIndex.take(-balances[winner] - balances[loser],
+                                        loser);
+            if(other >= 0){
+                pay(loser, winner, balances[loser]);
+                pay(other, winner, balances[other]);
+                break;
+            }
+        }
     }
 }
 
@@ -161,73 +541,71 @@ bool compMax(const struct Node* first, struct Node* second){
 ** Input: An initialized PlayerGraph which consists of a set of nodes - one per
 **        player. Each node's value represents the amount owed to that player
 **        (negative values) or the amount owed by that player (positve values).
-** Output: The member varaible adjacency list is filled out by this function
-**         such that each node's value is 0 with as few edges made as possible.
-**         Each edge represents a transfer of money from a node to another.
+**        Equal and opposite balances, and small zero-sum groups, are settled
+**        first by pairExactMatches(), unless that has been turned off, and
+**        the heaps only settle what's left.
+** Output: The member edge arrays are filled out by this function such that
+**         each node's value is 0 with as few edges made as possible. Each
+**         edge represents a transfer of money from a node to another.
 *******************************************************************************/
 void PlayerGraph::solveGraph(){
+    int nodeCount = this->getNodeCount();
+
+    //every edge settles at least one node, so there are at most n - 1
+    std::vector<int> payers;
+    std::vector<int> payees;
+    std::vector<Amount> amounts;
+    payers.reserve(nodeCount);
+    payees.reserve(nodeCount);
+    amounts.reserve(nodeCount);
+
+    //settle equal and opposite balances, and small zero-sum groups, first
+    if(this->exactMatchPairing){
+        this->pairExactMatches(payers, payees, amounts);
+    }
+    this->pairedPayments = payers.size();
 
     //heapify the players with negative balances into a min heap
     //heapify the players iwth a positive balance into a max heap
-    std::vector<struct Node*> winners;
-    std::vector<struct Node*> losers;
+    std::vector<int> winners;
+    std::vector<int> losers;
 
-    //go though the adjacencey list. Put the winners into one vector, put the
-    //losers into the other
-    for(int i = 0; i < this->adjList.size(); i++){
-        struct Node* currNode = this->adjList.at(i);
-        if(currNode->playerOwed < 0) {
-            winners.push_back(currNode);
-        }
-        else if(currNode->playerOwed > 0){
-            losers.push_back(currNode);
-        }
-    }
+    //go though the nodes. Put the winners into one vector, put the losers
+    //into the other
+    AmountKernels::partitionBalances(this->balances.data(), nodeCount,
+                                     winners, losers);
+
+    compMin lessOwed = { this->balances.data() };
+    compMax moreOwed = { this->balances.data() };
 
     //make a heap out of the losers and winners vectors
-    std::make_heap(winners.begin(), winners.end(), compMax);
-    std::make_heap(losers.begin(), losers.end(), compMin);
-    //if there are no losers/winners, there is no graph. Leave it set to null
+    std::make_heap(winners.begin(), winners.end(), moreOwed);
+    std::make_heap(losers.begin(), losers.end(), lessOwed);
+    //if there are no losers/winners left, there's nothing more to add
     if(losers.size() == 0){
+        this->storeEdges(payers, payees, amounts);
         return;
     }
 
-    /* The following lines of code may be un-commented out to print the heaps
-       of winners and losers for debugging purposes if necessary
-    //---------------------------------------------------------------------------
-    std::cout << "\n---winners---" << std::endl;
-    for(int i = 0; i < winners.size(); i++){
-        std::cout << winners.at(i)->player->getName() << " -- " 
-                  << winners.at(i)->playerOwed << std::endl;
-    }
-
-    std::cout << "\n---losers---" << std::endl;
-    for(int i = 0; i < losers.size(); i++){
-        std::cout << losers.at(i)->player->getName() << " -- " 
-                  << losers.at(i)->playerOwed << std::endl;
-    }
-    //-----------------------------------------------------------------------------
-    */
-
     //get the current loser from the losers heap
-    struct Node* currentLoser = losers.front();
-    std::pop_heap(losers.begin(), losers.end(), compMin);
-    struct Node* currentWinner = NULL;
+    int currentLoser = losers.front();
+    std::pop_heap(losers.begin(), losers.end(), lessOwed);
+    int currentWinner;
 
     //solve the graph
-    //while the current loser's playerOwed value does not equal 0, there are
-    //edges that need to be added to the graph. This loop determines the value
-    //of the next edge that needs to be added, adds it, adjusts the playerOwed
-    //values, and gets the next current loser from the losers heap
-    while(currentLoser->playerOwed != 0){
+    //while the current loser's balance does not equal 0, there are edges
+    //that need to be added to the graph. This loop determines the value of
+    //the next edge that needs to be added, adds it, adjusts the balances, and
+    //gets the next current loser from the losers heap
+    while(this->balances[currentLoser] != 0){
         //currWinner <-- getMin from the minHeap
         currentWinner = winners.front();
-        std::pop_heap(winners.begin(), winners.end(), compMax);
+        std::pop_heap(winners.begin(), winners.end(), moreOwed);
 
         //transfer = min(currLoser, -(currWinnter))
-        int loserOwes = currentLoser->playerOwed;
-        int winnerOwes = -(currentWinner->playerOwed);
-        int transfer;
+        Amount loserOwes = this->balances[currentLoser];
+        Amount winnerOwes = -(this->balances[currentWinner]);
+        Amount transfer;
 
         if(loserOwes > winnerOwes){
             transfer = winnerOwes;
@@ -236,26 +614,1071 @@ void PlayerGraph::solveGraph(){
             transfer = loserOwes;
         }
         
-        //Create a new edge to add to the Player Node's adjacency List
-        //Set the value of the edge from the current loser to the current winner
-        //such that it equals the transfer amount. Also adjust the playerOwed
-        //variable of each player node affected
-        struct adjNode* newEdge = new adjNode;
-        newEdge->edgeWeight = transfer;
-        newEdge->node = currentWinner;
-        currentLoser->adjacentNodes.push_back(newEdge);
-        currentLoser->playerOwed -= transfer;
-        currentWinner->playerOwed += transfer;
+        //Record an edge from the current loser to the current winner in the
+        //transfer amount. Also adjust the balance of each node affected
+        payers.push_back(currentLoser);
+        payees.push_back(currentWinner);
+        amounts.push_back(transfer);
+        this->balances[currentLoser] -= transfer;
+        this->balances[currentWinner] += transfer;
 
         //add current loser and current winner back into their respective heaps
-        push_heap(losers.begin(), losers.end(), compMin);
-        push_heap(winners.begin(), winners.end(), compMax);
+        push_heap(losers.begin(), losers.end(), lessOwed);
+        push_heap(winners.begin(), winners.end(), moreOwed);
 
-        assert(std::is_heap(losers.begin(), losers.end(), compMin));
-        assert(std::is_heap(winners.begin(), winners.end(), compMax));
+        VALIDATE_PARANOID(std::is_heap(losers.begin(), losers.end(),
+                                       lessOwed));
+        VALIDATE_PARANOID(std::is_heap(winners.begin(), winners.end(),
+                                       moreOwed));
 
         //get next loser
         currentLoser = losers.front();
-        pop_heap(losers.begin(), losers.end(), compMin);
+        pop_heap(losers.begin(), losers.end(), lessOwed);
+    }
+
+    //two heaps made, the first pop, then two pops and two pushes per edge
+    METRICS_ADD(HEAP_OPERATIONS,
+                3 + 4 * (long)(payers.size() - this->pairedPayments));
+    this->storeEdges(payers, payees, amounts);
+}
+
+
+/*******************************************************************************
+**                 sortByMagnitude(nodes, balances, sign, scratch)
+** Description: sorts nodes largest sign * balance first, lower index first
+**              among equal balances, which is the order the solveGraph() heaps
+**              hand them out in. nodes must start out in increasing index order.
+**              Large lists are sorted with a least significant digit radix sort,
+**              which is stable and only makes as many passes over the nodes as
+**              the largest balance has digits. Small lists aren't worth
+**              clearing the digit counts for and are sorted directly.
+*******************************************************************************/
+template<class Compare>
+struct OwesMore{
+    Compare heapOrder;
+
+    bool operator()(int first, int second) const {
+        return heapOrder(second, first);
+    }
+};
+
+template<class Compare>
+void sortByMagnitude(std::vector<int>& nodes, const Amount* balances,
+                     Amount sign, Compare heapOrder,
+                     std::vector<int>& scratch){
+    if(nodes.size() < RADIX_MIN_NODES){
+        OwesMore<Compare> owesMore = { heapOrder };
+        std::sort(nodes.begin(), nodes.end(), owesMore);
+        return;
+    }
+
+    Amount largest = 0;
+    for(int i = 0; i < nodes.size(); i++){
+        largest = std::max(largest, sign * balances[nodes[i]]);
+    }
+
+    scratch.resize(nodes.size());
+    std::vector<int> counts(RADIX_BUCKETS);
+    for(int shift = 0; shift < (int)sizeof(Amount) * 8 && (largest >> shift) != 0;
+        shift += RADIX_BITS){
+        std::fill(counts.begin(), counts.end(), 0);
+        for(int i = 0; i < nodes.size(); i++){
+            Amount magnitude = sign * balances[nodes[i]];
+            counts[(int)(magnitude >> shift) & (RADIX_BUCKETS - 1)]++;
+        }
+
+        //largest digit first
+        int offset = 0;
+        for(int digit = RADIX_BUCKETS - 1; digit >= 0; digit--){
+            int count = counts[digit];
+            counts[digit] = offset;
+            offset += count;
+        }
+        for(int i = 0; i < nodes.size(); i++){
+            Amount magnitude = sign * balances[nodes[i]];
+            scratch[counts[(int)(magnitude >> shift) & (RADIX_BUCKETS - 1)]++] =
+                nodes[i];
+        }
+        nodes.swap(scratch);
+    }
+}
+
+
+/*******************************************************************************
+**             takeLargest(sorted, next, remainders, heapOrder)
+** Description: removes and returns the node that owes (or is owed) the most,
+**              or -1 if there are none left. It's either the next untouched
+**              node in sorted, or the top of the heap of nodes that have been
+**              partly settled.
+*******************************************************************************/
+template<class Compare>
+int takeLargest(const std::vector<int>& sorted, int& next,
+                std::vector<int>& remainders, Compare heapOrder){
+    bool haveSorted = next < sorted.size();
+    if(!remainders.empty() &&
+       (!haveSorted || heapOrder(sorted[next], remainders.front()))){
+        int node = remainders.front();
+        std::pop_heap(remainders.begin(), remainders.end(), heapOrder);
+        remainders.pop_back();
+        return node;
+    }
+    if(haveSorted){
+        return sorted[next++];
+    }
+    return -1;
+}
+
+
+/*******************************************************************************
+**                         solveGraphBuckets()
+** Description: makes exactly the same payments as solveGraph(), without
+**              keeping every node in a heap. The winners and losers are radix
+**              sorted once and swept from the largest down. Only a node that is
+**              partly settled has its balance change, so only those go into a
+**              (usually tiny) heap of remainders, and each step takes whichever
+**              of the next sorted node and the largest remainder is larger.
+**              Balances are bounded, so the sort takes a fixed number of
+**              passes and the whole solve is O(n) plus O(log r) per payment
+**              for r pending remainders.
+*******************************************************************************/
+void PlayerGraph::solveGraphBuckets(){
+    int nodeCount = this->getNodeCount();
+
+    std::vector<int> payers;
+    std::vector<int> payees;
+    std::vector<Amount> amounts;
+    payers.reserve(nodeCount);
+    payees.reserve(nodeCount);
+    amounts.reserve(nodeCount);
+
+    //the same first pass as solveGraph(), so the payments stay the same
+    if(this->exactMatchPairing){
+        this->pairExactMatches(payers, payees, amounts);
+    }
+    this->pairedPayments = payers.size();
+
+    std::vector<int> winners;
+    std::vector<int> losers;
+    AmountKernels::partitionBalances(this->balances.data(), nodeCount,
+                                     winners, losers);
+
+    compMin lessOwed = { this->balances.data() };
+    compMax moreOwed = { this->balances.data() };
+    std::vector<int> scratch;
+    sortByMagnitude(losers, this->balances.data(), 1, lessOwed, scratch);
+    sortByMagnitude(winners, this->balances.data(), -1, moreOwed, scratch);
+
+    std::vector<int> loserRemainders;
+    std::vector<int> winnerRemainders;
+    int nextLoser = 0;
+    int nextWinner = 0;
+
+    while(true){
+        int currentLoser = takeLargest(losers, nextLoser, loserRemainders,
+                                       lessOwed);
+        if(currentLoser < 0){
+            break;
+        }
+        int currentWinner = takeLargest(winners, nextWinner, winnerRemainders,
+                                        moreOwed);
+        VALIDATE_CHEAP(currentWinner >= 0);
+
+        Amount transfer = std::min(this->balances[currentLoser],
+                                   -(this->balances[currentWinner]));
+        payers.push_back(currentLoser);
+        payees.push_back(currentWinner);
+        amounts.push_back(transfer);
+        this->balances[currentLoser] -= transfer;
+        this->balances[currentWinner] += transfer;
+
+        if(this->balances[currentLoser] != 0){
+            loserRemainders.push_back(currentLoser);
+            std::push_heap(loserRemainders.begin(), loserRemainders.end(),
+                           lessOwed);
+        }
+        if(this->balances[currentWinner] != 0){
+            winnerRemainders.push_back(currentWinner);
+            std::push_heap(winnerRemainders.begin(), winnerRemainders.end(),
+                           moreOwed);
+        }
+    }
+
+    //each payment settles one or both of its nodes, and the other goes into a
+    //remainder heap to be popped later, so there are 2 * edges - nodes pushes
+    METRICS_ADD(HEAP_OPERATIONS, 2 * (2 * (long)(payers.size() -
+                                             this->pairedPayments) -
+                                      (long)losers.size() -
+                                      (long)winners.size()));
+    this->storeEdges(payers, payees, amounts);
+}
+
+
+/*******************************************************************************
+**       relayPayments(hub, maxPayments, runStart, degrees, payers, payees,
+**                     froms, tos, amounts)
+** Description: rearranges the payments a player makes or receives when there
+**              are more than maxPayments of them. Payments runStart up to
+**              runStart + degrees[hub] of the original payers and payees are
+**              the hub's. Each player they're with whose only payment it is
+**              becomes a relay, taking maxPayments - 1 of the others' payments
+**              and passing them on, so the hub ends up at the top of a tree of
+**              relays only log(players) deep. The largest payments are placed
+**              nearest the hub, so the least money is passed along. A player
+**              the hub pays (or is paid by) who has other payments of their
+**              own keeps that payment, and is only ever a leaf of the tree.
+**              froms and tos get the payer and payee each payment ends up
+**              between, and amounts what it ends up carrying.
+*******************************************************************************/
+void relayPayments(int hub, int maxPayments, int runStart,
+                   const std::vector<int>& degrees,
+                   const std::vector<int>& payers,
+                   const std::vector<int>& payees,
+                   std::vector<int>& froms, std::vector<int>& tos,
+                   std::vector<Amount>& amounts){
+    int runEnd = runStart + degrees[hub];
+    bool hubIsPaid = payees[runStart] == hub;
+
+    //largest payments first, in payment order among equal ones
+    std::vector<std::pair<Amount, int> > order;
+    order.reserve(runEnd - runStart);
+    for(int edge = runStart; edge < runEnd; edge++){
+        order.push_back(std::make_pair(-amounts[edge], edge));
+    }
+    std::sort(order.begin(), order.end());
+
+    //players with room for more payments, breadth first, so each is filled
+    //before anyone below it. A relay's own payment is openEdges, -1 for the
+    //hub. Relays can always be found: only the hub's first and last payments
+    //can be with players who have other payments, and every relay makes room
+    //for maxPayments - 2 more than it takes
+    std::vector<int> openNodes(1, hub);
+    std::vector<int> openEdges(1, -1);
+    std::vector<int> openSlots(1, maxPayments);
+    std::vector<int> parentEdges(order.size());
+    int front = 0;
+    for(int i = 0; i < order.size(); i++){
+        int edge = order[i].second;
+        int other = hubIsPaid ? payers[edge] : payees[edge];
+        if(hubIsPaid){
+            tos[edge] = openNodes[front];
+        }
+        else{
+            froms[edge] = openNodes[front];
+        }
+        parentEdges[i] = openEdges[front];
+        if(--openSlots[front] == 0){
+            front++;
+        }
+
+        if(degrees[other] == 1){
+            openNodes.push_back(other);
+            openEdges.push_back(edge);
+            openSlots.push_back(maxPayments - 1);
+        }
+    }
+
+    //a relay's payment carries its own and everything it passes on. Anyone
+    //below a relay was placed after it
+    for(int i = order.size() - 1; i >= 0; i--){
+        if(parentEdges[i] >= 0){
+            amounts[parentEdges[i]] += amounts[order[i].second];
+        }
+    }
+}
+
+
+/*******************************************************************************
+**                       solveGraphBounded(int)
+** Description: settles the graph so that no player makes and receives more
+**              than maxPayments payments between them. After exact matches
+**              are paired off, like solveGraph() does, the largest loser pays
+**              the largest winner until one of them is settled, sweeping down
+**              the losers and winners sorted largest first. Like
+**              solveGraph(), each payment settles at least one player, so
+**              there are fewer payments than players, and every player but
+**              the first and last a winner is paid by pays only that winner
+**              (and the same the other way). Those players can relay for a
+**              winner or loser with too many payments, which relayPayments()
+**              sorts into a tree under them. No payments are added, so there
+**              are as many as the sweep made. Sorting takes O(n log n) and the
+**              rest O(n).
+** Prereqs: maxPayments must be at least 2. With 1 allowed, only players owed
+**          exactly what another owes could ever be settled.
+*******************************************************************************/
+void PlayerGraph::solveGraphBounded(int maxPayments){
+    METRICS_TIME_PHASE(SOLVE_PHASE);
+    METRICS_ADD(GRAPHS_SOLVED, 1);
+    VALIDATE_CHEAP(maxPayments >= 2);
+    int nodeCount = this->getNodeCount();
+
+    std::vector<int> payers;
+    std::vector<int> payees;
+    std::vector<Amount> amounts;
+    payers.reserve(nodeCount);
+    payees.reserve(nodeCount);
+    amounts.reserve(nodeCount);
+
+    //exact matches settle each of their players with at most two payments
+    if(this->exactMatchPairing){
+        this->pairExactMatches(payers, payees, amounts);
+    }
+    this->pairedPayments = payers.size();
+    int paired = this->pairedPayments;
+
+    std::vector<int> winners;
+    std::vector<int> losers;
+    std::vector<int> scratch;
+    AmountKernels::partitionBalances(this->balances.data(), nodeCount,
+                                     winners, losers);
+    compMin lessOwed = { this->balances.data() };
+    compMax moreOwed = { this->balances.data() };
+    sortByMagnitude(losers, this->balances.data(), 1, lessOwed, scratch);
+    sortByMagnitude(winners, this->balances.data(), -1, moreOwed, scratch);
+
+    //sweep, noting where each player's payments start and how many there are
+    std::vector<int> runStarts(nodeCount, 0);
+    std::vector<int> degrees(nodeCount, 0);
+    int nextLoser = 0;
+    int nextWinner = 0;
+    while(nextLoser < losers.size() && nextWinner < winners.size()){
+        int loser = losers[nextLoser];
+        int winner = winners[nextWinner];
+        Amount transfer = std::min(this->balances[loser],
+                                   -this->balances[winner]);
+        int edge = payers.size() - paired;
+        if(degrees[loser]++ == 0){
+            runStarts[loser] = edge;
+        }
+        if(degrees[winner]++ == 0){
+            runStarts[winner] = edge;
+        }
+        payers.push_back(loser);
+        payees.push_back(winner);
+        amounts.push_back(transfer);
+        this->balances[loser] -= transfer;
+        this->balances[winner] += transfer;
+        if(this->balances[loser] == 0){
+            nextLoser++;
+        }
+        if(this->balances[winner] == 0){
+            nextWinner++;
+        }
+    }
+    VALIDATE_CHEAP(nextLoser == losers.size() &&
+                   nextWinner == winners.size());
+
+    //relay the payments of anyone with too many
+    std::vector<int> sweptPayers(payers.begin() + paired, payers.end());
+    std::vector<int> sweptPayees(payees.begin() + paired, payees.end());
+    std::vector<int> froms(sweptPayers);
+    std::vector<int> tos(sweptPayees);
+    std::vector<Amount> carried(amounts.begin() + paired, amounts.end());
+    for(int i = 0; i < nodeCount; i++){
+        if(degrees[i] > maxPayments){
+            relayPayments(i, maxPayments, runStarts[i], degrees, sweptPayers,
+                          sweptPayees, froms, tos, carried);
+        }
+    }
+    std::copy(froms.begin(), froms.end(), payers.begin() + paired);
+    std::copy(tos.begin(), tos.end(), payees.begin() + paired);
+    std::copy(carried.begin(), carried.end(), amounts.begin() + paired);
+
+    this->storeEdges(payers, payees, amounts);
+    VALIDATE_CHEAP(this->checkSettlement());
+    VALIDATE_CHEAP(this->checkPaymentCounts(maxPayments));
+}
+
+
+/*******************************************************************************
+**                       checkPaymentCounts(int)
+** Description: returns true if no player makes and receives more than
+**              maxPayments payments between them in the solved graph
+*******************************************************************************/
+bool PlayerGraph::checkPaymentCounts(int maxPayments) const {
+    int nodeCount = this->getNodeCount();
+    std::vector<int> payments(nodeCount, 0);
+    for(int i = 0; i < nodeCount; i++){
+        payments[i] += this->edgeOffsets[i + 1] - this->edgeOffsets[i];
+        for(int j = this->edgeOffsets[i]; j < this->edgeOffsets[i + 1]; j++){
+            payments[this->edgePayees[j]]++;
+        }
+    }
+    for(int i = 0; i < nodeCount; i++){
+        if(payments[i] > maxPayments){
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/*******************************************************************************
+**                         solve(SolverType)
+** Description: settles the graph with the chosen algorithm. The exact solver
+**              falls back to the greedy one on tables too large for it.
+*******************************************************************************/
+void PlayerGraph::solve(SolverType solver){
+    METRICS_TIME_PHASE(SOLVE_PHASE);
+    METRICS_ADD(GRAPHS_SOLVED, 1);
+    if(solver == EXACT_SOLVER){
+        this->solveGraphExact();
+    }
+    else if(solver == BUCKET_SOLVER){
+        this->solveGraphBuckets();
+    }
+    else{
+        this->solveGraph();
+    }
+    VALIDATE_CHEAP(this->checkSettlement());
+}
+
+
+/*******************************************************************************
+**                   solveCached(SolverType, SettlementCache&)
+** Description: settles the graph as solve() does, taking the payments from
+**              the cache if a game with the same balances has been settled
+**              the same way before. The graph is always solved as its shape:
+**              its nodes in order of balance, the lower index first among
+**              equal balances, which the heaps' tie-breaking keeps the order
+**              they'd be handed out in anyway. So the same balances always
+**              get the same payments, whether they came from the cache or
+**              not, moved onto whichever players are at each position.
+*******************************************************************************/
+void PlayerGraph::solveCached(SolverType solver, SettlementCache& cache){
+    int nodeCount = this->getNodeCount();
+    std::vector<Amount>& balances = this->balances;
+
+    std::vector<int> order(nodeCount);
+    for(int i = 0; i < nodeCount; i++){
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int first, int second){
+        return balances[first] < balances[second];
+    });
+    std::vector<Amount> shape(nodeCount);
+    for(int i = 0; i < nodeCount; i++){
+        shape[i] = balances[order[i]];
+    }
+    uint64_t hash = SettlementCache::hashBalances(shape);
+
+    std::vector<CachedPayment> payments;
+    int paired;
+    if(!cache.find(hash, solver, this->exactMatchPairing, shape, payments,
+                   paired)){
+        //solve the shape with its players in place, so the settlement can
+        //still be checked against their buy-ins and stacks
+        std::vector<int> playerIds(nodeCount);
+        for(int i = 0; i < nodeCount; i++){
+            playerIds[i] = this->playerIds[order[i]];
+        }
+        this->playerIds.swap(playerIds);
+        balances = shape;
+        this->solve(solver);
+        this->playerIds.swap(playerIds);
+
+        payments.reserve(this->getEdgeCount());
+        for(int i = 0; i < nodeCount; i++){
+            for(int j = this->edgeOffsets[i]; j < this->edgeOffsets[i + 1];
+                j++){
+                CachedPayment payment = { i, this->edgePayees[j],
+                                          this->edgeAmounts[j] };
+                payments.push_back(payment);
+            }
+        }
+        paired = this->pairedPayments;
+        cache.insert(hash, solver, this->exactMatchPairing, shape, payments,
+                     paired);
+    }
+
+    //move the template onto the players at each position
+    std::vector<int> payers(payments.size());
+    std::vector<int> payees(payments.size());
+    std::vector<Amount> amounts(payments.size());
+    for(int i = 0; i < payments.size(); i++){
+        payers[i] = order[payments[i].payer];
+        payees[i] = order[payments[i].payee];
+        amounts[i] = payments[i].amount;
+    }
+    std::fill(balances.begin(), balances.end(), 0);
+    this->storeEdges(payers, payees, amounts);
+    this->pairedPayments = paired;
+    VALIDATE_CHEAP(this->checkSettlement());
+}
+
+
+/*******************************************************************************
+**                         checkSettlement()
+** Description: audits a solved graph in O(n). Returns true if the players'
+**              balances net to zero, every payment is positive and goes
+**              between two different players, the payments settle every
+**              player exactly, and there are at most n - 1 of them.
+*******************************************************************************/
+bool PlayerGraph::checkSettlement() const {
+    int nodeCount = this->getNodeCount();
+    int edgeCount = this->getEdgeCount();
+    if(edgeCount > std::max(nodeCount - 1, 0) ||
+       this->edgeOffsets.size() != nodeCount + 1 ||
+       this->edgeOffsets[nodeCount] != edgeCount){
+        return false;
+    }
+
+    //what each player owes, less what they pay, plus what they're paid
+    std::vector<Amount> owed(nodeCount);
+    Amount total = 0;
+    for(int i = 0; i < nodeCount; i++){
+        owed[i] = this->getPlayerBuyIn(i) - this->getPlayerFinalStack(i);
+        total += owed[i];
+    }
+    if(total != 0){
+        return false;
+    }
+
+    for(int i = 0; i < nodeCount; i++){
+        for(int j = this->edgeOffsets[i]; j < this->edgeOffsets[i + 1]; j++){
+            int payee = this->edgePayees[j];
+            if(payee < 0 || payee >= nodeCount || payee == i ||
+               this->edgeAmounts[j] <= 0){
+                return false;
+            }
+            owed[i] -= this->edgeAmounts[j];
+            owed[payee] += this->edgeAmounts[j];
+        }
+    }
+    for(int i = 0; i < nodeCount; i++){
+        if(owed[i] != 0){
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/*******************************************************************************
+**                addToSubsetSums(low, high, count, value)
+** Description: sets high[j] = low[j] + value for count sums. Each width of
+**              Amount gets its own version, using SSE2 to add 4 (32 bit) or 2
+**              (64 bit) sums at a time where it is available.
+*******************************************************************************/
+inline void addToSubsetSums(const int32_t* low, int32_t* high, size_t count,
+                            int32_t value){
+    size_t j = 0;
+#ifdef __SSE2__
+    __m128i addend = _mm_set1_epi32(value);
+    for(; j + 4 <= count; j += 4){
+        __m128i lowSums = _mm_loadu_si128((const __m128i*)(low + j));
+        _mm_storeu_si128((__m128i*)(high + j), _mm_add_epi32(lowSums, addend));
+    }
+#endif
+    for(; j < count; j++){
+        high[j] = low[j] + value;
+    }
+}
+
+
+inline void addToSubsetSums(const int64_t* low, int64_t* high, size_t count,
+                            int64_t value){
+    size_t j = 0;
+#ifdef __SSE2__
+    __m128i addend = _mm_set1_epi64x(value);
+    for(; j + 2 <= count; j += 2){
+        __m128i lowSums = _mm_loadu_si128((const __m128i*)(low + j));
+        _mm_storeu_si128((__m128i*)(high + j), _mm_add_epi64(lowSums, addend));
+    }
+#endif
+    for(; j < count; j++){
+        high[j] = low[j] + value;
+    }
+}
+
+
+inline void addToSubsetSums(const __int128* low, __int128* high, size_t count,
+                            __int128 value){
+    for(size_t j = 0; j < count; j++){
+        high[j] = low[j] + value;
+    }
+}
+
+
+/*******************************************************************************
+**                         solveGraphExact()
+** Description: settles the graph with the fewest payments possible. If the
+**              players with a non-zero balance can be split into at most k
+**              disjoint groups that each sum to 0, the group of size s can
+**              settle among itself in s - 1 payments, so the fewest payments
+**              for n players is n - k. k is found with a dynamic program over
+**              every subset of the players:
+**
+**                  groups(S) = max over i in S of groups(S - {i})
+**                              + 1 if S sums to 0
+**
+**              Equal and opposite balances are paired off first, since some
+**              best solution always settles such a pair with one payment on
+**              its own. That shrinks the tables, which take O(2^n) memory and
+**              O(n * 2^n) time.
+** Output: returns true if the graph was solved exactly. If more than
+**         EXACT_MAX_PLAYERS players are left after pairing, the graph is
+**         solved with solveGraph() instead and false is returned.
+*******************************************************************************/
+bool PlayerGraph::solveGraphExact(){
+    int nodeCount = this->getNodeCount();
+
+    std::vector<int> payers;
+    std::vector<int> payees;
+    std::vector<Amount> amounts;
+    payers.reserve(nodeCount);
+    payees.reserve(nodeCount);
+    amounts.reserve(nodeCount);
+
+    //sort the unsettled nodes by the size of their balance so that equal and
+    //opposite balances end up next to each other, owed before owing
+    std::vector<int> order;
+    for(int i = 0; i < nodeCount; i++){
+        if(this->balances[i] != 0){
+            order.push_back(i);
+        }
+    }
+    std::vector<Amount> magnitude(nodeCount);
+    for(int i = 0; i < order.size(); i++){
+        Amount balance = this->balances[order[i]];
+        magnitude[order[i]] = balance < 0 ? -balance : balance;
+    }
+    std::vector<Amount>& balance = this->balances;
+    std::stable_sort(order.begin(), order.end(), 
+        [&magnitude, &balance](int first, int second){
+            if(magnitude[first] != magnitude[second]){
+                return magnitude[first] < magnitude[second];
+            }
+            return balance[first] < balance[second];
+        });
+
+    //pair the k-th winner and the k-th loser of each magnitude
+    std::vector<bool> paired(nodeCount, false);
+    std::vector<int> rest;
+    int runStart = 0;
+    while(runStart < order.size()){
+        int runEnd = runStart;
+        int firstLoser = runStart;
+        while(runEnd < order.size() && 
+              magnitude[order[runEnd]] == magnitude[order[runStart]]){
+            if(this->balances[order[runEnd]] < 0){
+                firstLoser = runEnd + 1;
+            }
+            runEnd++;
+        }
+
+        for(int w = runStart, l = firstLoser; w < firstLoser && l < runEnd;
+            w++, l++){
+            payers.push_back(order[l]);
+            payees.push_back(order[w]);
+            amounts.push_back(this->balances[order[l]]);
+            paired[order[l]] = true;
+            paired[order[w]] = true;
+        }
+        runStart = runEnd;
+    }
+    for(int i = 0; i < nodeCount; i++){
+        if(this->balances[i] != 0 && !paired[i]){
+            rest.push_back(i);
+        }
+    }
+
+    //too big for the subset tables
+    if(rest.size() > EXACT_MAX_PLAYERS){
+        this->solveGraph();
+        return false;
+    }
+
+    for(int i = 0; i < payers.size(); i++){
+        this->balances[payers[i]] = 0;
+        this->balances[payees[i]] = 0;
+    }
+
+    int restCount = rest.size();
+    size_t subsetCount = (size_t)1 << restCount;
+    std::vector<Amount> sums(subsetCount);
+    std::vector<unsigned char> groups(subsetCount);
+
+    //the subsets containing player k are the subsets of players 0..k-1 with
+    //player k's balance added. Each pass is a straight, independent add over
+    //a contiguous block
+    sums[0] = 0;
+    for(int k = 0; k < restCount; k++){
+        size_t half = (size_t)1 << k;
+        addToSubsetSums(sums.data(), sums.data() + half, half,
+                        this->balances[rest[k]]);
+    }
+
+    //most zero-sum groups each subset can be split into
+    groups[0] = 0;
+    for(size_t subset = 1; subset < subsetCount; subset++){
+        unsigned char best = 0;
+        for(size_t remaining = subset; remaining != 0;
+            remaining &= remaining - 1){
+            size_t bit = remaining & (~remaining + 1);
+            if(groups[subset ^ bit] > best){
+                best = groups[subset ^ bit];
+            }
+        }
+        groups[subset] = best + (sums[subset] == 0 ? 1 : 0);
+    }
+
+    //walk back down from the full set, taking away one player at a time
+    //without losing a group. Every time what is left sums to 0, the players
+    //taken away since the last time form one group
+    std::vector<int> group;
+    size_t current = subsetCount - 1;
+    while(current != 0){
+        int target = groups[current] - (sums[current] == 0 ? 1 : 0);
+        size_t remaining = current;
+        size_t bit = remaining & (~remaining + 1);
+        while(groups[current ^ bit] != target){
+            remaining &= remaining - 1;
+            bit = remaining & (~remaining + 1);
+        }
+
+        group.push_back(rest[__builtin_ctzll(bit)]);
+        current ^= bit;
+        if(sums[current] == 0){
+            this->settleGroup(group, payers, payees, amounts);
+            group.clear();
+        }
+    }
+
+    this->storeEdges(payers, payees, amounts);
+    return true;
+}
+
+
+/*******************************************************************************
+**                         settleGroup(group, payers, payees, amounts)
+** Description: settles a group of nodes whose balances sum to 0 among
+**              themselves. The largest loser pays the largest winner until
+**              one of them is settled, so a group of s nodes needs at most
+**              s - 1 payments. The payments are appended to the edge lists.
+*******************************************************************************/
+void PlayerGraph::settleGroup(const std::vector<int>& group,
+                              std::vector<int>& payers,
+                              std::vector<int>& payees,
+                              std::vector<Amount>& amounts){
+    std::vector<int> winners;
+    std::vector<int> losers;
+    for(int i = 0; i < group.size(); i++){
+        if(this->balances[group[i]] < 0){
+            winners.push_back(group[i]);
+        }
+        else if(this->balances[group[i]] > 0){
+            losers.push_back(group[i]);
+        }
+    }
+
+    compMin lessOwed = { this->balances.data() };
+    compMax moreOwed = { this->balances.data() };
+    std::stable_sort(winners.begin(), winners.end(), lessOwed);
+    std::stable_sort(losers.begin(), losers.end(), moreOwed);
+
+    int w = 0;
+    int l = 0;
+    while(w < winners.size() && l < losers.size()){
+        Amount loserOwes = this->balances[losers[l]];
+        Amount winnerOwed = -(this->balances[winners[w]]);
+        Amount transfer = std::min(loserOwes, winnerOwed);
+
+        payers.push_back(losers[l]);
+        payees.push_back(winners[w]);
+        amounts.push_back(transfer);
+        this->balances[losers[l]] -= transfer;
+        this->balances[winners[w]] += transfer;
+
+        if(this->balances[losers[l]] == 0){
+            l++;
+        }
+        if(this->balances[winners[w]] == 0){
+            w++;
+        }
+    }
+}
+
+
+/*******************************************************************************
+**      pairAllowedMatches(allowedPayers, allowedPayees, payers, payees,
+**                         amounts)
+** Description: settles each loser who is allowed to pay a winner owed
+**              exactly what the loser owes with that one payment, trying the
+**              allowed payments in order. The payments are appended to the
+**              edge lists. O(allowed payments).
+*******************************************************************************/
+void PlayerGraph::pairAllowedMatches(const std::vector<int>& allowedPayers,
+                                     const std::vector<int>& allowedPayees,
+                                     std::vector<int>& payers,
+                                     std::vector<int>& payees,
+                                     std::vector<Amount>& amounts){
+    for(int i = 0; i < allowedPayers.size(); i++){
+        int payer = allowedPayers[i];
+        int payee = allowedPayees[i];
+        Amount owes = this->balances[payer];
+        if(owes > 0 && owes == -this->balances[payee]){
+            payers.push_back(payer);
+            payees.push_back(payee);
+            amounts.push_back(owes);
+            this->balances[payer] = 0;
+            this->balances[payee] = 0;
+        }
+    }
+}
+
+
+/*******************************************************************************
+**   flowAllowed(allowedPayers, allowedPayees, payers, payees, amounts,
+**               stranded)
+** Description: settles the graph as a minimum cost flow: every loser's
+**              balance is a supply, every winner's a demand, and each allowed
+**              payment is an arc costing 1 per cent, so the flow found moves
+**              the least money, and goes direct wherever it can. Players who
+**              are even, including those already paired off, can still pass
+**              money along. The flow is a tree, so there are fewer payments
+**              than nodes. The payments are appended to the edge lists.
+** Output: returns false, with the first node that couldn't be settled in
+**         stranded, if the allowed payments can't settle everyone.
+*******************************************************************************/
+bool PlayerGraph::flowAllowed(const std::vector<int>& allowedPayers,
+                              const std::vector<int>& allowedPayees,
+                              std::vector<int>& payers,
+                              std::vector<int>& payees,
+                              std::vector<Amount>& amounts, int& stranded){
+    int nodeCount = this->getNodeCount();
+    MinCostFlow network(this->balances);
+    network.reserveArcs(allowedPayers.size());
+    for(int i = 0; i < allowedPayers.size(); i++){
+        int payer = allowedPayers[i];
+        int payee = allowedPayees[i];
+        if(payer != payee){
+            network.addArc(payer, payee, 1);
+        }
+    }
+
+    if(!network.solve()){
+        for(int i = 0; i < nodeCount; i++){
+            if(network.getShortfall(i) != 0){
+                stranded = i;
+                break;
+            }
+        }
+        return false;
+    }
+
+    for(int arc = 0; arc < network.getArcCount(); arc++){
+        Amount flow = network.getFlow(arc);
+        if(flow > 0){
+            int payer = network.getArcSource(arc);
+            int payee = network.getArcTarget(arc);
+            payers.push_back(payer);
+            payees.push_back(payee);
+            amounts.push_back(flow);
+            this->balances[payer] -= flow;
+            this->balances[payee] += flow;
+        }
+    }
+    return true;
+}
+
+
+/*******************************************************************************
+**             cancelPairCycles(paired, payers, payees, amounts)
+** Description: the first paired payments of the edge lists pair players off,
+**              and the rest are a flow that may pass money through those
+**              players, so together they can close cycles. Each paired
+**              payment is added to the flow's forest in turn, and if its
+**              players are already joined, the cycle it closes is cancelled:
+**              money is moved around the cycle until one of its payments is
+**              zero, which leaves every balance as it was and sends nothing
+**              the wrong way. The zero payments are then dropped, so there
+**              are again fewer payments than nodes, and pairedPayments is
+**              set to the paired payments left. O(paired payments * nodes)
+**              at worst, but only players the flow passed money through are
+**              ever searched from.
+*******************************************************************************/
+void PlayerGraph::cancelPairCycles(int paired, std::vector<int>& payers,
+                                   std::vector<int>& payees,
+                                   std::vector<Amount>& amounts){
+    int nodeCount = this->getNodeCount();
+    int edgeCount = payers.size();
+
+    //the payments each node makes or gets. Payments cancelled down to zero
+    //are left in and skipped
+    std::vector<std::vector<int> > incident(nodeCount);
+    for(int e = paired; e < edgeCount; e++){
+        incident[payers[e]].push_back(e);
+        incident[payees[e]].push_back(e);
+    }
+
+    std::vector<int> parentEdge(nodeCount, -1);
+    std::vector<int> searched(nodeCount, -1);
+    std::vector<int> queue;
+    queue.reserve(nodeCount);
+    std::vector<int> cycle;
+    std::vector<bool> forward;
+    for(int p = 0; p < paired; p++){
+        int from = payers[p];
+        int to = payees[p];
+
+        //search the forest from the payee for the payer
+        bool joined = false;
+        if(!incident[from].empty() && !incident[to].empty()){
+            queue.clear();
+            queue.push_back(to);
+            searched[to] = p;
+            for(int q = 0; q < queue.size() && !joined; q++){
+                int node = queue[q];
+                for(int i = 0; i < incident[node].size(); i++){
+                    int e = incident[node][i];
+                    int next = payers[e] == node ? payees[e] : payers[e];
+                    if(amounts[e] == 0 || searched[next] == p){
+                        continue;
+                    }
+                    searched[next] = p;
+                    parentEdge[next] = e;
+                    if(next == from){
+                        joined = true;
+                        break;
+                    }
+                    queue.push_back(next);
+                }
+            }
+        }
+
+        if(joined){
+            //the cycle runs from the payer to the payee by the paired payment
+            //and back down the search tree to the payer
+            cycle.assign(1, p);
+            forward.assign(1, true);
+            for(int node = from; node != to; ){
+                int e = parentEdge[node];
+                int parent = payers[e] == node ? payees[e] : payers[e];
+                cycle.push_back(e);
+                forward.push_back(payers[e] == parent);
+                node = parent;
+            }
+
+            //move the smallest backward payment's money the other way around
+            //the cycle, or if every payment goes forward, take the smallest
+            //out of all of them
+            Amount backward = 0;
+            Amount smallest = 0;
+            for(int i = 0; i < cycle.size(); i++){
+                Amount amount = amounts[cycle[i]];
+                if(!forward[i] && (backward == 0 || amount < backward)){
+                    backward = amount;
+                }
+                if(smallest == 0 || amount < smallest){
+                    smallest = amount;
+                }
+            }
+            for(int i = 0; i < cycle.size(); i++){
+                if(backward == 0){
+                    amounts[cycle[i]] -= smallest;
+                }
+                else{
+                    amounts[cycle[i]] += forward[i] ? backward : -backward;
+                }
+            }
+        }
+
+        if(amounts[p] != 0){
+            incident[from].push_back(p);
+            incident[to].push_back(p);
+        }
+    }
+
+    int kept = 0;
+    this->pairedPayments = 0;
+    for(int e = 0; e < edgeCount; e++){
+        if(amounts[e] != 0){
+            payers[kept] = payers[e];
+            payees[kept] = payees[e];
+            amounts[kept] = amounts[e];
+            kept++;
+            if(e < paired){
+                this->pairedPayments++;
+            }
+        }
+    }
+    payers.resize(kept);
+    payees.resize(kept);
+    amounts.resize(kept);
+}
+
+
+/*******************************************************************************
+**        solveConstrained(allowedPayers, allowedPayees, objective, stranded)
+** Description: settles the graph when not every player can pay every other.
+**              Payment i may only go from allowedPayers[i] to
+**              allowedPayees[i], and players may pass money along to reach
+**              someone they can't pay themselves. With LEAST_MONEY_MOVED the
+**              settlement moves the least money possible, counting money
+**              again each time it's passed along. With FEWEST_PAYMENTS, every
+**              loser allowed to pay a winner owed exactly what they owe does
+**              so first, and the rest is settled the same way, with the
+**              paired players still passing money along where they're needed
+**              to and the cycles that makes cancelled. Only if pairing off
+**              leaves someone the allowed payments can't reach is the whole
+**              graph settled without pairing instead. Either way there are
+**              fewer payments than players. The flow is found with a MinCostFlow,
+**              which settles 100,000 players with a million allowed payments
+**              in seconds.
+** Output: returns true if the graph was settled. Otherwise there are no
+**         payments, the balances are left as they were, and stranded is a
+**         node the allowed payments can't settle.
+*******************************************************************************/
+bool PlayerGraph::solveConstrained(const std::vector<int>& allowedPayers,
+                                   const std::vector<int>& allowedPayees,
+                                   SettlementObjective objective,
+                                   int& stranded){
+    METRICS_TIME_PHASE(SOLVE_PHASE);
+    METRICS_ADD(GRAPHS_SOLVED, 1);
+    int nodeCount = this->getNodeCount();
+    VALIDATE_CHEAP(allowedPayers.size() == allowedPayees.size());
+    stranded = -1;
+
+    std::vector<int> payers;
+    std::vector<int> payees;
+    std::vector<Amount> amounts;
+    payers.reserve(nodeCount);
+    payees.reserve(nodeCount);
+    amounts.reserve(nodeCount);
+    std::vector<Amount> original(this->balances);
+
+    if(objective == FEWEST_PAYMENTS){
+        this->pairAllowedMatches(allowedPayers, allowedPayees, payers,
+                                 payees, amounts);
+    }
+    this->pairedPayments = payers.size();
+    bool settled = this->flowAllowed(allowedPayers, allowedPayees, payers,
+                                     payees, amounts, stranded);
+    if(settled && this->pairedPayments > 0){
+        this->cancelPairCycles(this->pairedPayments, payers, payees, amounts);
+    }
+
+    //pairing a loser off with a winner can still leave someone only the
+    //money they would have passed on could reach
+    if(!settled && this->pairedPayments > 0){
+        this->balances = original;
+        payers.clear();
+        payees.clear();
+        amounts.clear();
+        this->pairedPayments = 0;
+        settled = this->flowAllowed(allowedPayers, allowedPayees, payers,
+                                    payees, amounts, stranded);
+    }
+    if(!settled){
+        this->balances = original;
+        payers.clear();
+        payees.clear();
+        amounts.clear();
+    }
+
+    this->storeEdges(payers, payees, amounts);
+    if(settled){
+        VALIDATE_CHEAP(this->checkSettlement());
     }
+    return settled;
 }
@@ -3,7 +3,10 @@
 ** Date: August 10, 2019
 ** Description: Header file for the PlayerGraph class. The PlayerGraph class
 **              is used to implement the graph algorithm that solves the poker
-**              problem
+**              problem. The graph is stored as flat arrays indexed by node:
+**              one array of balances, one of player ids, and the edges in
+**              compressed sparse row (CSR) form, so building and solving the
+**              graph never allocates anything per node or per edge.
 *******************************************************************************/
 #ifndef PLAYERGRAPH_HPP
 #define PLAYERGRAPH_HPP
@@ -12,19 +15,83 @@
 #include <vector>
 #include "Structs.hpp"
 
+class BinaryLedger;
+class SettlementCache;
+
 class PlayerGraph
 {
     private:
-        std::vector<struct Node*> adjList;
-        void initializeGraph(std::vector<Player*>);
+        //node data. Node i belongs to (*roster)[playerIds[i]], the game's own
+        //players, or to record playerIds[i] of the ledger for a graph read
+        //from a binary ledger, and owes balances[i] (positive) or is owed
+        //-balances[i] (negative)
+        const std::vector<std::unique_ptr<Player> >* roster;
+        const BinaryLedger* ledger;
+        std::vector<int> playerIds;
+        std::vector<Amount> balances;
+
+        //edges in CSR form. The payments made by node i are
+        //edgePayees/edgeAmounts[edgeOffsets[i]] up to edgeOffsets[i + 1]
+        std::vector<int> edgeOffsets;
+        std::vector<int> edgePayees;
+        std::vector<Amount> edgeAmounts;
+
+        //whether solveGraph() and solveGraphBuckets() settle exact matches
+        //first, and how many of their payments that made
+        bool exactMatchPairing;
+        int pairedPayments;
+
+        void initializeGraph(const std::vector<std::unique_ptr<Player> >&);
+        void storeEdges(const std::vector<int>& payers,
+                        const std::vector<int>& payees,
+                        const std::vector<Amount>& amounts);
+        void pairExactMatches(std::vector<int>& payers,
+                              std::vector<int>& payees,
+                              std::vector<Amount>& amounts);
+        void pairAllowedMatches(const std::vector<int>& allowedPayers,
+                                const std::vector<int>& allowedPayees,
+                                std::vector<int>& payers,
+                                std::vector<int>& payees,
+                                std::vector<Amount>& amounts);
+        bool flowAllowed(const std::vector<int>& allowedPayers,
+                         const std::vector<int>& allowedPayees,
+                         std::vector<int>& payers, std::vector<int>& payees,
+                         std::vector<Amount>& amounts, int& stranded);
+        void cancelPairCycles(int paired, std::vector<int>& payers,
+                              std::vector<int>& payees,
+                              std::vector<Amount>& amounts);
+        void settleGroup(const std::vector<int>& group,
+                         std::vector<int>& payers, std::vector<int>& payees,
+                         std::vector<Amount>& amounts);
+        bool checkSettlement() const;
+        bool checkPaymentCounts(int maxPayments) const;
 
     public:
         //constructor
         PlayerGraph(Game*);
-        ~PlayerGraph();
-        std::vector<struct Node*> getAdjList();
-        void printGraph();
+        PlayerGraph(const BinaryLedger&);
+        int getNodeCount() const;
+        int getEdgeCount() const;
+        Player* getPlayer(int node) const;
+        std::string getPlayerName(int node) const;
+        const char* getPlayerName(int node, size_t& length) const;
+        Amount getPlayerBuyIn(int node) const;
+        Amount getPlayerFinalStack(int node) const;
+        const std::vector<int>& getEdgeOffsets() const;
+        const std::vector<int>& getEdgePayees() const;
+        const std::vector<Amount>& getEdgeAmounts() const;
+        void setExactMatchPairing(bool pairing);
+        int getPairedPayments() const;
+        void printGraph() const;
+        void solve(SolverType);
+        void solveCached(SolverType solver, SettlementCache& cache);
         void solveGraph();
+        void solveGraphBuckets();
+        bool solveGraphExact();
+        void solveGraphBounded(int maxPayments);
+        bool solveConstrained(const std::vector<int>& allowedPayers,
+                              const std::vector<int>& allowedPayees,
+                              SettlementObjective objective, int& stranded);
 };
 
 #endif
@@ -0,0 +1,181 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Implementation of PlayerNames. The names are kept in chunks
+ *              that are allocated as they're needed and never moved, so a name
+ *              is found from its id with two array lookups. Names are found
+ *              from their text with an open addressing hash index of ids,
+ *              kept at most half full, which compares a name in place, so
+ *              interning a name that's already known allocates nothing. Each
+ *              slot keeps the top half of its name's hash next to the id, so
+ *              only a name whose hash matches is ever read, and the index
+ *              grows without reading any names.
+*******************************************************************************/
+#include "PlayerNames.hpp"
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+//slots the index starts with
+const size_t PLAYER_NAME_FIRST_SLOTS = 1024;
+
+struct PlayerNames::Table{
+    std::mutex lock;                //held while interning
+    std::string* chunks[PLAYER_NAME_CHUNK_COUNT];
+    uint32_t count;
+    uint32_t limit;                 //0 for PLAYER_NAME_MAX_COUNT
+
+    //the top 32 bits of the hash of each slot's name above the name's id
+    //+ 1, or 0 for an empty slot. The slot is picked with the top bits too
+    std::vector<uint64_t> slots;
+};
+
+
+/*******************************************************************************
+ *                                 table()
+ * Description: returns the table of names. It's static, so it starts out
+ *              zeroed, with no chunks, no names and no index
+*******************************************************************************/
+PlayerNames::Table& PlayerNames::table() {
+    static Table names;
+    return names;
+}
+
+
+/*******************************************************************************
+ *                      hashName(const char*, size_t)
+ * Description: FNV-1a hash of a name's bytes, mixed at the end so names that
+ *              differ only in their last few bytes, like most players' names
+ *              do, spread over the top bits the index uses
+*******************************************************************************/
+uint64_t PlayerNames::hashName(const char* name, size_t length) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for(size_t i = 0; i < length; ++i){
+        hash = (hash ^ (unsigned char)name[i]) * 0x100000001B3ULL;
+    }
+    hash = (hash ^ (hash >> 29)) * 0x9E3779B97F4A7C15ULL;
+    return hash ^ (hash >> 32);
+}
+
+
+/*******************************************************************************
+ *                            growIndex(Table&)
+ * Description: doubles the index and puts every name back in it. The lock
+ *              must be held.
+*******************************************************************************/
+void PlayerNames::growIndex(Table& names) {
+    std::vector<uint64_t> slots(names.slots.size() * 2, 0);
+    size_t mask = slots.size() - 1;
+    for(size_t i = 0; i < names.slots.size(); ++i){
+        if(names.slots[i] == 0){
+            continue;
+        }
+        size_t slot = (names.slots[i] >> 32) & mask;
+        while(slots[slot] != 0){
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = names.slots[i];
+    }
+    names.slots.swap(slots);
+}
+
+
+/*******************************************************************************
+ *                      intern(const char*, size_t)
+ *                        intern(const std::string&)
+ * Description: return the id of a name, storing the name and giving it the
+ *              next id if it hasn't been seen before. Returns PLAYER_NAME_NONE
+ *              for a new name if the table already holds its limit.
+*******************************************************************************/
+uint32_t PlayerNames::intern(const char* name, size_t length) {
+    uint64_t tag = hashName(name, length) >> 32;
+    Table& names = table();
+    std::lock_guard<std::mutex> guard(names.lock);
+    if(names.slots.empty()){
+        names.slots.assign(PLAYER_NAME_FIRST_SLOTS, 0);
+    }
+
+    size_t mask = names.slots.size() - 1;
+    size_t slot = tag & mask;
+    while(names.slots[slot] != 0){
+        if(names.slots[slot] >> 32 == tag){
+            uint32_t known = (uint32_t)names.slots[slot] - 1;
+            const std::string& knownName = getName(known);
+            if(knownName.size() == length &&
+               std::memcmp(knownName.data(), name, length) == 0){
+                return known;
+            }
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    uint32_t limit = names.limit != 0 ? names.limit : PLAYER_NAME_MAX_COUNT;
+    if(names.count >= limit){
+        return PLAYER_NAME_NONE;
+    }
+
+    uint32_t id = names.count;
+    std::string*& chunk = names.chunks[id >> PLAYER_NAME_CHUNK_BITS];
+    if(chunk == NULL){
+        chunk = new std::string[PLAYER_NAME_CHUNK_SIZE];
+    }
+    chunk[id & (PLAYER_NAME_CHUNK_SIZE - 1)].assign(name, length);
+    names.count++;
+    names.slots[slot] = tag << 32 | (id + 1);
+    if((size_t)names.count * 2 > names.slots.size()){
+        growIndex(names);
+    }
+    return id;
+}
+
+
+uint32_t PlayerNames::intern(const std::string& name) {
+    return intern(name.data(), name.size());
+}
+
+
+/*******************************************************************************
+ *                            getName(uint32_t)
+ * Description: returns the name with the given id, which must have been
+ *              given out by intern(). PLAYER_NAME_NONE has the empty name.
+*******************************************************************************/
+const std::string& PlayerNames::getName(uint32_t id) {
+    static const std::string none;
+    if(id == PLAYER_NAME_NONE){
+        return none;
+    }
+    return table().chunks[id >> PLAYER_NAME_CHUNK_BITS]
+                         [id & (PLAYER_NAME_CHUNK_SIZE - 1)];
+}
+
+
+/*******************************************************************************
+ *                               getCount()
+ * Description: returns how many names have been interned, which is one more
+ *              than the largest id given out
+*******************************************************************************/
+uint32_t PlayerNames::getCount() {
+    Table& names = table();
+    std::lock_guard<std::mutex> guard(names.lock);
+    return names.count;
+}
+
+
+/*******************************************************************************
+ *                  setLimit(uint32_t) / getLimit()
+ * Description: set and return the most names the table will hold, at most
+ *              PLAYER_NAME_MAX_COUNT. Names already in the table are kept
+ *              even if there are more of them than the new limit.
+*******************************************************************************/
+void PlayerNames::setLimit(uint32_t limit) {
+    Table& names = table();
+    std::lock_guard<std::mutex> guard(names.lock);
+    names.limit = limit < PLAYER_NAME_MAX_COUNT ? limit : PLAYER_NAME_MAX_COUNT;
+}
+
+
+uint32_t PlayerNames::getLimit() {
+    Table& names = table();
+    std::lock_guard<std::mutex> guard(names.lock);
+    return names.limit != 0 ? names.limit : PLAYER_NAME_MAX_COUNT;
+}
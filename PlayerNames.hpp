@@ -0,0 +1,60 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Header file for PlayerNames, the table every player's name is
+ *              kept in. Each distinct name is stored once, for the life of
+ *              the process, and given a dense 32 bit id in the order names
+ *              are first seen. A Player carries only its name's id, and the
+ *              name is looked up when it's printed, so the same few thousand
+ *              names over a season of games are each kept once, however many
+ *              seats they fill, and players can be netted across games by id
+ *              in a flat array instead of by name.
+ *
+ *              Names are never freed, so a long running server would keep
+ *              every name any request ever used. The table is capped instead:
+ *              once it holds getLimit() names, intern() refuses new ones and
+ *              returns PLAYER_NAME_NONE, which the callers report as an error
+ *              on the row or game that brought the name. The limit starts at
+ *              PLAYER_NAME_MAX_COUNT, and a server sets a lower one.
+ *
+ *              Interning a name is locked, so games can be built on any
+ *              number of threads. Looking a name up by id isn't, and never
+ *              moves a name once it's stored, so a name returned by getName()
+ *              stays valid for good.
+*******************************************************************************/
+#ifndef PLAYERNAMES_HPP
+#define PLAYERNAMES_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+//names are stored in chunks of 1 << PLAYER_NAME_CHUNK_BITS, enough chunks
+//for every 32 bit id, and the chunks are never moved
+const int PLAYER_NAME_CHUNK_BITS = 14;
+const uint32_t PLAYER_NAME_CHUNK_SIZE = 1 << PLAYER_NAME_CHUNK_BITS;
+const uint32_t PLAYER_NAME_CHUNK_COUNT = 1 << (32 - PLAYER_NAME_CHUNK_BITS);
+
+//the most names the table can hold, and the id intern() returns for a new
+//name once it's full
+const uint32_t PLAYER_NAME_MAX_COUNT = 1u << 31;
+const uint32_t PLAYER_NAME_NONE = 0xFFFFFFFF;
+
+class PlayerNames
+{
+    private:
+        struct Table;
+        static Table& table();
+        static uint64_t hashName(const char* name, size_t length);
+        static void growIndex(Table& names);
+
+    public:
+        static uint32_t intern(const char* name, size_t length);
+        static uint32_t intern(const std::string& name);
+        static const std::string& getName(uint32_t id);
+        static uint32_t getCount();
+        static void setLimit(uint32_t limit);
+        static uint32_t getLimit();
+};
+
+#endif
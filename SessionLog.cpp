@@ -0,0 +1,571 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Implementation of the SessionLog class. The log starts with a
+ *              header (magic, generation) followed by events, each stored as
+ *
+ *                  uint32 length, uint32 checksum, then length bytes of event
+ *
+ *              where the event is a type byte followed by its fields:
+ *
+ *                  add player   - buy-in, final stack (int64), name length
+ *                                 (uint8), name
+ *                  buy-in       - player (uint32), amount (int64)
+ *                  final stack  - player (uint32), amount (int64)
+ *
+ *              A snapshot is the magic, the generation of the log after it,
+ *              the player count, each player as an add player event's fields,
+ *              and a checksum of everything before it. Numbers are stored in
+ *              the machine's own byte order; the log is only ever read back by
+ *              the machine that wrote it.
+*******************************************************************************/
+#include "SessionLog.hpp"
+#include "Game.hpp"
+#include "PlayerNames.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const char SESSION_LOG_MAGIC[8] = {'P', 'K', 'R', 'S', 'L', 'O', 'G', '1'};
+const char SESSION_SNAPSHOT_MAGIC[8] = {'P', 'K', 'R', 'S', 'N', 'A', 'P', '1'};
+const size_t SESSION_LOG_HEADER_BYTES = sizeof(SESSION_LOG_MAGIC) +
+                                        sizeof(uint64_t);
+
+enum SessionEventType{
+    ADD_PLAYER_EVENT = 1,
+    BUY_IN_EVENT = 2,
+    FINAL_STACK_EVENT = 3
+};
+
+
+/*******************************************************************************
+ *                        checksum(const char*, size_t)
+ * Description: returns the 32 bit FNV-1a hash of the bytes
+*******************************************************************************/
+static uint32_t checksum(const char* bytes, size_t length){
+    uint32_t hash = 2166136261u;
+    for(size_t i = 0; i < length; ++i){
+        hash ^= (unsigned char)bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+
+/*******************************************************************************
+ *                    put(std::vector<char>&, value)
+ *                    take(const char*&, const char*, value&)
+ * Description: append a value's bytes to a buffer, and read a value's bytes
+ *              from a position in a buffer, moving the position past it.
+ *              take() returns false if the value runs past the end.
+*******************************************************************************/
+template<class T>
+static void put(std::vector<char>& buffer, T value){
+    const char* bytes = (const char*)&value;
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(value));
+}
+
+
+template<class T>
+static bool take(const char*& position, const char* end, T& value){
+    if(end - position < (ptrdiff_t)sizeof(value)){
+        return false;
+    }
+    std::memcpy(&value, position, sizeof(value));
+    position += sizeof(value);
+    return true;
+}
+
+
+/*******************************************************************************
+ *                  readPlayer(const char*&, const char*, Game*)
+ * Description: reads a player's buy-in, final stack and name, the fields of
+ *              an add player event, and adds the player to the game. Returns
+ *              false if the fields are cut short, or PlayerNames is full.
+*******************************************************************************/
+static bool readPlayer(const char*& position, const char* end, Game* target){
+    int64_t buyIn;
+    int64_t finalStack;
+    uint8_t nameLength;
+    if(!take(position, end, buyIn) || !take(position, end, finalStack) ||
+       !take(position, end, nameLength) || end - position < nameLength){
+        return false;
+    }
+
+    uint32_t nameId = PlayerNames::intern(position, nameLength);
+    if(nameId == PLAYER_NAME_NONE){
+        return false;
+    }
+    target->addPlayer(nameId, buyIn, finalStack);
+    position += nameLength;
+    return true;
+}
+
+
+/*******************************************************************************
+ *                   putPlayer(std::vector<char>&, ...)
+ * Description: appends the fields of an add player event to a buffer
+*******************************************************************************/
+static void putPlayer(std::vector<char>& buffer, const std::string& name,
+                      Amount buyIn, Amount finalStack){
+    uint8_t nameLength = name.size() < 255 ? name.size() : 255;
+    put(buffer, (int64_t)buyIn);
+    put(buffer, (int64_t)finalStack);
+    put(buffer, nameLength);
+    buffer.insert(buffer.end(), name.begin(), name.begin() + nameLength);
+}
+
+
+/*******************************************************************************
+ *                   readAll(int, std::vector<char>&)
+ *                   writeAll(int, const char*, size_t)
+ * Description: read a whole file into a buffer, and write a whole buffer to
+ *              a file descriptor. Both return false on an error.
+*******************************************************************************/
+static bool readAll(int fd, std::vector<char>& contents){
+    struct stat status;
+    if(fstat(fd, &status) != 0){
+        return false;
+    }
+    contents.resize(status.st_size);
+
+    size_t done = 0;
+    while(done < contents.size()){
+        ssize_t count = pread(fd, contents.data() + done,
+                              contents.size() - done, done);
+        if(count < 0 && errno == EINTR){
+            continue;
+        }
+        if(count <= 0){
+            return false;
+        }
+        done += count;
+    }
+    return true;
+}
+
+
+static bool writeAll(int fd, const char* bytes, size_t length){
+    while(length > 0){
+        ssize_t count = write(fd, bytes, length);
+        if(count < 0 && errno == EINTR){
+            continue;
+        }
+        if(count <= 0){
+            return false;
+        }
+        bytes += count;
+        length -= count;
+    }
+    return true;
+}
+
+
+/*******************************************************************************
+ *                  SessionLog(const Game*, const std::string&)
+ * Description: Constructor. Takes the game whose changes will be logged, and
+ *              the path of the log. The snapshot is kept next to it, with
+ *              ".snapshot" added to its name. Nothing is opened until
+ *              recover() is called.
+*******************************************************************************/
+SessionLog::SessionLog(const Game* game, const std::string& path) {
+    this->game = game;
+    this->logPath = path;
+    this->snapshotPath = path + ".snapshot";
+    this->logFd = -1;
+    this->generation = 0;
+    this->bufferedEvents = 0;
+    this->eventsSinceSnapshot = 0;
+    this->eventsReplayed = 0;
+}
+
+
+/*******************************************************************************
+ *                              ~SessionLog()
+ * Description: Destructor. Commits any buffered events and closes the log.
+*******************************************************************************/
+SessionLog::~SessionLog() {
+    if(this->logFd >= 0){
+        this->commit();
+        close(this->logFd);
+    }
+}
+
+
+/*******************************************************************************
+ *                        recover(Game*, std::string&)
+ * Description: Opens the log, creating it if there isn't one, and rebuilds
+ *              the game it describes in target, which should be empty: the
+ *              snapshot's players are added, and then the events logged since
+ *              the snapshot are replayed. A torn event at the end of the log
+ *              is dropped. target must not log its own changes to this
+ *              SessionLog until recover() returns. Returns false and sets
+ *              error if the log or snapshot can't be read.
+*******************************************************************************/
+bool SessionLog::recover(Game* target, std::string& error) {
+    if(!this->loadSnapshot(target, error)){
+        return false;
+    }
+
+    this->logFd = open(this->logPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC,
+                       0644);
+    if(this->logFd < 0){
+        error = "could not open " + this->logPath + ": " +
+                std::strerror(errno);
+        return false;
+    }
+    if(!this->replayLog(target, error)){
+        return false;
+    }
+
+    //a long log is folded into a fresh snapshot right away
+    this->eventsSinceSnapshot = this->eventsReplayed;
+    if(this->eventsSinceSnapshot >= SESSION_SNAPSHOT_EVENTS){
+        this->snapshot();
+    }
+    return true;
+}
+
+
+/*******************************************************************************
+ *                      loadSnapshot(Game*, std::string&)
+ * Description: Adds the players in the snapshot, if there is one, to target
+ *              and takes the log generation that follows it. Returns false
+ *              and sets error if the snapshot is unreadable.
+*******************************************************************************/
+bool SessionLog::loadSnapshot(Game* target, std::string& error) {
+    int fd = open(this->snapshotPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0 && errno == ENOENT){
+        this->generation = 0;
+        return true;
+    }
+
+    std::vector<char> contents;
+    bool read = fd >= 0 && readAll(fd, contents);
+    if(fd >= 0){
+        close(fd);
+    }
+    if(!read){
+        error = "could not read " + this->snapshotPath;
+        return false;
+    }
+
+    //the snapshot is renamed into place whole, so any damage is real
+    uint32_t expected;
+    const char* end = contents.data() + contents.size() - sizeof(expected);
+    if(contents.size() < sizeof(SESSION_SNAPSHOT_MAGIC) + sizeof(expected) ||
+       std::memcmp(contents.data(), SESSION_SNAPSHOT_MAGIC,
+                   sizeof(SESSION_SNAPSHOT_MAGIC)) != 0){
+        error = this->snapshotPath + " is not a session snapshot";
+        return false;
+    }
+    std::memcpy(&expected, end, sizeof(expected));
+    if(checksum(contents.data(), end - contents.data()) != expected){
+        error = this->snapshotPath + " is corrupt";
+        return false;
+    }
+
+    const char* position = contents.data() + sizeof(SESSION_SNAPSHOT_MAGIC);
+    uint64_t playerCount;
+    if(!take(position, end, this->generation) ||
+       !take(position, end, playerCount)){
+        error = this->snapshotPath + " is corrupt";
+        return false;
+    }
+    for(uint64_t i = 0; i < playerCount; ++i){
+        if(!readPlayer(position, end, target)){
+            error = this->snapshotPath + " is corrupt";
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/*******************************************************************************
+ *                       replayLog(Game*, std::string&)
+ * Description: Applies the events in the log to target. A log from before the
+ *              snapshot was taken is already covered by it, and an empty log
+ *              is new, so both are started over. Returns false and sets error
+ *              if the log belongs to some other snapshot or an event can't be
+ *              applied.
+*******************************************************************************/
+bool SessionLog::replayLog(Game* target, std::string& error) {
+    std::vector<char> contents;
+    if(!readAll(this->logFd, contents)){
+        error = "could not read " + this->logPath;
+        return false;
+    }
+
+    uint64_t logGeneration = 0;
+    if(contents.size() >= SESSION_LOG_HEADER_BYTES){
+        std::memcpy(&logGeneration, contents.data() + sizeof(SESSION_LOG_MAGIC),
+                    sizeof(logGeneration));
+    }
+    if(contents.size() < SESSION_LOG_HEADER_BYTES ||
+       logGeneration + 1 == this->generation){
+        return this->startLog(this->generation, error);
+    }
+    if(std::memcmp(contents.data(), SESSION_LOG_MAGIC,
+                   sizeof(SESSION_LOG_MAGIC)) != 0 ||
+       logGeneration != this->generation){
+        error = this->logPath + " does not belong with " + this->snapshotPath;
+        return false;
+    }
+
+    const char* position = contents.data() + SESSION_LOG_HEADER_BYTES;
+    const char* end = contents.data() + contents.size();
+    while(position < end){
+        const char* eventStart = position;
+        uint32_t length;
+        uint32_t expected;
+        if(!take(position, end, length) || !take(position, end, expected) ||
+           end - position < length ||
+           checksum(position, length) != expected){
+            //torn by a crash mid-write. Everything before it is good
+            if(ftruncate(this->logFd, eventStart - contents.data()) != 0 ||
+               fdatasync(this->logFd) != 0){
+                error = "could not repair " + this->logPath;
+                return false;
+            }
+            break;
+        }
+
+        const char* eventEnd = position + length;
+        uint8_t type = 0;
+        uint32_t player = 0;
+        int64_t amount = 0;
+        bool good = take(position, eventEnd, type);
+        if(good && type == ADD_PLAYER_EVENT){
+            good = readPlayer(position, eventEnd, target);
+        }
+        else if(good && (type == BUY_IN_EVENT || type == FINAL_STACK_EVENT)){
+            good = take(position, eventEnd, player) &&
+                   take(position, eventEnd, amount) &&
+                   player < target->getPlayerCount();
+            if(good && type == BUY_IN_EVENT){
+                target->addBuyInToPlayer(player, amount);
+            }
+            else if(good){
+                target->setFinalStack(player, amount);
+            }
+        }
+        else{
+            good = false;
+        }
+
+        if(!good){
+            error = this->logPath + " has an invalid event at byte " +
+                    std::to_string(eventStart - contents.data());
+            return false;
+        }
+        position = eventEnd;
+        this->eventsReplayed++;
+    }
+
+    if(lseek(this->logFd, 0, SEEK_END) < 0){
+        error = "could not open " + this->logPath;
+        return false;
+    }
+    return true;
+}
+
+
+/*******************************************************************************
+ *                      startLog(uint64_t, std::string&)
+ * Description: empties the log and starts it over with the given generation
+*******************************************************************************/
+bool SessionLog::startLog(uint64_t newGeneration, std::string& error) {
+    std::vector<char> header(SESSION_LOG_MAGIC,
+                             SESSION_LOG_MAGIC + sizeof(SESSION_LOG_MAGIC));
+    put(header, newGeneration);
+
+    if(ftruncate(this->logFd, 0) != 0 || lseek(this->logFd, 0, SEEK_SET) != 0 ||
+       !writeAll(this->logFd, header.data(), header.size()) ||
+       fdatasync(this->logFd) != 0){
+        error = "could not write " + this->logPath + ": " +
+                std::strerror(errno);
+        return false;
+    }
+    this->generation = newGeneration;
+    return true;
+}
+
+
+/*******************************************************************************
+ *                   appendEvent(const char*, size_t)
+ *                   eventLogged()
+ * Description: buffer an event with its length and checksum, and commit or
+ *              snapshot once enough events have built up
+*******************************************************************************/
+void SessionLog::appendEvent(const char* event, size_t length) {
+    if(this->bufferedEvents == 0){
+        this->oldestBuffered = std::chrono::steady_clock::now();
+    }
+    put(this->buffer, (uint32_t)length);
+    put(this->buffer, checksum(event, length));
+    this->buffer.insert(this->buffer.end(), event, event + length);
+    this->bufferedEvents++;
+    this->eventLogged();
+}
+
+
+void SessionLog::eventLogged() {
+    this->eventsSinceSnapshot++;
+    if(this->eventsSinceSnapshot >= SESSION_SNAPSHOT_EVENTS){
+        this->snapshot();
+        return;
+    }
+
+    if(this->bufferedEvents >= SESSION_COMMIT_EVENTS ||
+       std::chrono::steady_clock::now() - this->oldestBuffered >=
+       std::chrono::milliseconds(SESSION_COMMIT_MS)){
+        this->commit();
+    }
+}
+
+
+/*******************************************************************************
+ *              logAddPlayer(const std::string&, Amount, Amount)
+ *              logBuyIn(int, Amount)
+ *              logFinalStack(int, Amount)
+ * Description: log a change to the game. Called by the Game after it makes
+ *              the change.
+*******************************************************************************/
+void SessionLog::logAddPlayer(const std::string& name, Amount buyIn,
+                              Amount finalStack) {
+    std::vector<char> event;
+    put(event, (uint8_t)ADD_PLAYER_EVENT);
+    putPlayer(event, name, buyIn, finalStack);
+    this->appendEvent(event.data(), event.size());
+}
+
+
+void SessionLog::logBuyIn(int player, Amount amount) {
+    char event[1 + sizeof(uint32_t) + sizeof(int64_t)];
+    uint32_t playerNumber = player;
+    int64_t cents = amount;
+    event[0] = BUY_IN_EVENT;
+    std::memcpy(event + 1, &playerNumber, sizeof(playerNumber));
+    std::memcpy(event + 1 + sizeof(playerNumber), &cents, sizeof(cents));
+    this->appendEvent(event, sizeof(event));
+}
+
+
+void SessionLog::logFinalStack(int player, Amount cents) {
+    char event[1 + sizeof(uint32_t) + sizeof(int64_t)];
+    uint32_t playerNumber = player;
+    int64_t stack = cents;
+    event[0] = FINAL_STACK_EVENT;
+    std::memcpy(event + 1, &playerNumber, sizeof(playerNumber));
+    std::memcpy(event + 1 + sizeof(playerNumber), &stack, sizeof(stack));
+    this->appendEvent(event, sizeof(event));
+}
+
+
+/*******************************************************************************
+ *                                commit()
+ * Description: writes every buffered event to the log with one write and
+ *              waits for it to reach the disk. Returns false if it couldn't
+ *              be written; the events stay buffered for the next try.
+*******************************************************************************/
+bool SessionLog::commit() {
+    if(this->bufferedEvents == 0 || this->logFd < 0){
+        return this->logFd >= 0;
+    }
+    if(!writeAll(this->logFd, this->buffer.data(), this->buffer.size()) ||
+       fdatasync(this->logFd) != 0){
+        return false;
+    }
+    this->buffer.clear();
+    this->bufferedEvents = 0;
+    return true;
+}
+
+
+/*******************************************************************************
+ *                               snapshot()
+ * Description: saves the whole game as a new snapshot and starts the log
+ *              over. Returns false if the snapshot couldn't be saved, in
+ *              which case the log carries on as it was.
+*******************************************************************************/
+bool SessionLog::snapshot() {
+    if(!this->commit()){
+        return false;
+    }
+
+    std::vector<char> contents(SESSION_SNAPSHOT_MAGIC,
+                               SESSION_SNAPSHOT_MAGIC +
+                               sizeof(SESSION_SNAPSHOT_MAGIC));
+    put(contents, this->generation + 1);
+    put(contents, (uint64_t)this->game->getPlayerCount());
+    for(int i = 0; i < this->game->getPlayerCount(); ++i){
+        Player* player = this->game->getPlayer(i);
+        putPlayer(contents, player->getName(), player->getBuyIn(),
+                  player->getFinalStack());
+    }
+    put(contents, checksum(contents.data(), contents.size()));
+
+    //write it beside the old snapshot, then swap it in
+    std::string temporaryPath = this->snapshotPath + ".tmp";
+    int fd = open(temporaryPath.c_str(),
+                  O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(fd < 0){
+        return false;
+    }
+    bool written = writeAll(fd, contents.data(), contents.size()) &&
+                   fsync(fd) == 0;
+    close(fd);
+    if(!written || rename(temporaryPath.c_str(),
+                          this->snapshotPath.c_str()) != 0){
+        unlink(temporaryPath.c_str());
+        return false;
+    }
+
+    //make the rename itself durable before the old log is thrown away
+    size_t slash = this->snapshotPath.rfind('/');
+    std::string directory = slash == std::string::npos ? "." :
+                            this->snapshotPath.substr(0, slash + 1);
+    int directoryFd = open(directory.c_str(), O_RDONLY | O_CLOEXEC);
+    if(directoryFd >= 0){
+        fsync(directoryFd);
+        close(directoryFd);
+    }
+
+    std::string error;
+    if(!this->startLog(this->generation + 1, error)){
+        return false;
+    }
+    this->eventsSinceSnapshot = 0;
+    return true;
+}
+
+
+/*******************************************************************************
+ *                                finish()
+ * Description: the game is over, so there is nothing left to recover. Closes
+ *              the log and removes it and the snapshot.
+*******************************************************************************/
+void SessionLog::finish() {
+    if(this->logFd >= 0){
+        close(this->logFd);
+        this->logFd = -1;
+    }
+    this->buffer.clear();
+    this->bufferedEvents = 0;
+    unlink(this->logPath.c_str());
+    unlink(this->snapshotPath.c_str());
+}
+
+
+/*******************************************************************************
+ *                           getEventsReplayed()
+ * Description: returns how many logged events recover() replayed on top of
+ *              the snapshot
+*******************************************************************************/
+long SessionLog::getEventsReplayed() const {
+    return this->eventsReplayed;
+}
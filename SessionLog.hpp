@@ -0,0 +1,75 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Header file for the SessionLog class. A SessionLog keeps a
+ *              running Game safe from crashes. Every player added, buy-in and
+ *              final stack is appended to a write-ahead log, and every so
+ *              often a compact snapshot of the whole game is saved, so that a
+ *              restarted PokerCalc gets the game back by loading the snapshot
+ *              and replaying only the events logged since.
+ *
+ *              Events are buffered and written with a single write and
+ *              fdatasync once SESSION_COMMIT_EVENTS have built up or the
+ *              oldest has waited SESSION_COMMIT_MS, or when commit() is
+ *              called. Each event carries a checksum, so a write torn by a
+ *              crash is found and dropped on recovery.
+ *
+ *              A snapshot is written to a temporary file that is renamed
+ *              over the old snapshot. It names the generation of the log that
+ *              follows it; once it's in place the log is started over with
+ *              that generation, so a crash at any point leaves either the old
+ *              snapshot and old log or the new snapshot and a log that is
+ *              recognised as already covered by it.
+*******************************************************************************/
+#ifndef SESSIONLOG_HPP
+#define SESSIONLOG_HPP
+
+#include <stdint.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "Amount.hpp"
+
+class Game;
+
+//events buffered before a commit, longest an event waits for one, and events
+//logged between snapshots
+const int SESSION_COMMIT_EVENTS = 256;
+const int SESSION_COMMIT_MS = 20;
+const int SESSION_SNAPSHOT_EVENTS = 16384;
+
+class SessionLog
+{
+    private:
+        const Game* game;
+        std::string logPath;
+        std::string snapshotPath;
+        int logFd;
+        uint64_t generation;        //generation of the current log
+        std::vector<char> buffer;   //events not yet committed
+        int bufferedEvents;
+        std::chrono::steady_clock::time_point oldestBuffered;
+        long eventsSinceSnapshot;
+        long eventsReplayed;
+
+        bool loadSnapshot(Game* target, std::string& error);
+        bool replayLog(Game* target, std::string& error);
+        bool startLog(uint64_t newGeneration, std::string& error);
+        void appendEvent(const char* event, size_t length);
+        void eventLogged();
+
+    public:
+        SessionLog(const Game* game, const std::string& path);
+        ~SessionLog();
+        bool recover(Game* target, std::string& error);
+        void logAddPlayer(const std::string& name, Amount buyIn,
+                          Amount finalStack);
+        void logBuyIn(int player, Amount amount);
+        void logFinalStack(int player, Amount cents);
+        bool commit();
+        bool snapshot();
+        void finish();
+        long getEventsReplayed() const;
+};
+
+#endif
@@ -0,0 +1,210 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Implementation of the SettlementCache class. The entries are
+ *              kept in a list in order of use, so finding one moves it to the
+ *              front and evicting takes from the back, each in O(1). A hash
+ *              index over the list finds an entry's shape in O(1) expected
+ *              time, plus one comparison of the balances per entry with the
+ *              same hash.
+*******************************************************************************/
+#include "SettlementCache.hpp"
+#include <algorithm>
+#include <cstring>
+
+//about what an entry costs beyond the Entry itself and its vectors' contents:
+//the list's links, the index's node and bucket, and the allocator's headers
+const size_t CACHE_ENTRY_OVERHEAD = 96;
+
+
+/*******************************************************************************
+ *                          SettlementCache(size_t)
+ * Description: Constructor. The cache holds at most capacity bytes of shapes
+ *              and templates.
+*******************************************************************************/
+SettlementCache::SettlementCache(size_t capacity) {
+    this->capacity = capacity;
+    this->bytesUsed = 0;
+    this->hits = 0;
+    this->misses = 0;
+    this->evictions = 0;
+}
+
+
+/*******************************************************************************
+ *                    hashBalances(const vector<Amount>&)
+ * Description: hashes a game's sorted balances, eight bytes at a time, into
+ *              the key its shape is found by
+*******************************************************************************/
+uint64_t SettlementCache::hashBalances(const std::vector<Amount>& balances) {
+    const char* bytes = (const char*)balances.data();
+    size_t size = balances.size() * sizeof(Amount);
+    uint64_t hash = 0xCBF29CE484222325ULL ^ balances.size();
+    for(size_t i = 0; i < size; i += sizeof(uint64_t)){
+        uint64_t word = 0;
+        std::memcpy(&word, bytes + i, std::min(sizeof(uint64_t), size - i));
+        hash = (hash ^ word) * 0x9E3779B97F4A7C15ULL;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+
+/*******************************************************************************
+ *        findEntry(uint64_t, SolverType, bool, const vector<Amount>&)
+ * Description: returns the entry for the shape solved this way, or the end of
+ *              the list if there isn't one. The lock must be held.
+*******************************************************************************/
+SettlementCache::EntryList::iterator SettlementCache::findEntry(
+        uint64_t hash, SolverType solver, bool pairing,
+        const std::vector<Amount>& balances) {
+    std::pair<std::unordered_multimap<uint64_t,
+                                      EntryList::iterator>::iterator,
+              std::unordered_multimap<uint64_t,
+                                      EntryList::iterator>::iterator>
+        matches = this->index.equal_range(hash);
+    for(; matches.first != matches.second; ++matches.first){
+        EntryList::iterator entry = matches.first->second;
+        if(entry->solver == solver && entry->pairing == pairing &&
+           entry->balances == balances){
+            return entry;
+        }
+    }
+    return this->entries.end();
+}
+
+
+/*******************************************************************************
+ *                                 evict()
+ * Description: drops the least recently used entry. The lock must be held.
+*******************************************************************************/
+void SettlementCache::evict() {
+    EntryList::iterator last = --this->entries.end();
+    std::pair<std::unordered_multimap<uint64_t,
+                                      EntryList::iterator>::iterator,
+              std::unordered_multimap<uint64_t,
+                                      EntryList::iterator>::iterator>
+        matches = this->index.equal_range(last->hash);
+    for(; matches.first != matches.second; ++matches.first){
+        if(matches.first->second == last){
+            this->index.erase(matches.first);
+            break;
+        }
+    }
+    this->bytesUsed -= last->bytes;
+    this->entries.erase(last);
+    this->evictions++;
+}
+
+
+/*******************************************************************************
+ *            find(uint64_t, SolverType, bool, const vector<Amount>&,
+ *                 vector<CachedPayment>&, int&)
+ * Description: Looks up the shape with the given sorted balances and hash,
+ *              settled with the solver, and with exact matches paired first
+ *              if pairing is true. On a hit, copies its template into
+ *              payments, and how many of them were paired exact matches into
+ *              pairedPayments, and returns true. Counts a hit or a miss.
+*******************************************************************************/
+bool SettlementCache::find(uint64_t hash, SolverType solver, bool pairing,
+                           const std::vector<Amount>& balances,
+                           std::vector<CachedPayment>& payments,
+                           int& pairedPayments) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    EntryList::iterator entry = this->findEntry(hash, solver, pairing,
+                                                balances);
+    if(entry == this->entries.end()){
+        this->misses++;
+        return false;
+    }
+
+    this->entries.splice(this->entries.begin(), this->entries, entry);
+    payments = entry->payments;
+    pairedPayments = entry->pairedPayments;
+    this->hits++;
+    return true;
+}
+
+
+/*******************************************************************************
+ *            insert(uint64_t, SolverType, bool, const vector<Amount>&,
+ *                   const vector<CachedPayment>&, int)
+ * Description: Remembers how a shape was settled, evicting the least recently
+ *              used shapes until it fits. A shape bigger than the whole cache,
+ *              or already in it, isn't added.
+*******************************************************************************/
+void SettlementCache::insert(uint64_t hash, SolverType solver, bool pairing,
+                             const std::vector<Amount>& balances,
+                             const std::vector<CachedPayment>& payments,
+                             int pairedPayments) {
+    size_t bytes = sizeof(Entry) + CACHE_ENTRY_OVERHEAD +
+                   balances.size() * sizeof(Amount) +
+                   payments.size() * sizeof(CachedPayment);
+    if(bytes > this->capacity){
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(this->lock);
+    //another thread may have solved the same shape first
+    if(this->findEntry(hash, solver, pairing, balances) !=
+       this->entries.end()){
+        return;
+    }
+    while(this->bytesUsed + bytes > this->capacity){
+        this->evict();
+    }
+
+    Entry entry;
+    entry.hash = hash;
+    entry.solver = solver;
+    entry.pairing = pairing;
+    entry.balances = balances;
+    entry.payments = payments;
+    entry.pairedPayments = pairedPayments;
+    entry.bytes = bytes;
+    this->entries.push_front(entry);
+    this->index.insert(std::make_pair(hash, this->entries.begin()));
+    this->bytesUsed += bytes;
+}
+
+
+/*******************************************************************************
+ *              getCapacity() / getBytesUsed() / getEntryCount()
+ *                getHits() / getMisses() / getEvictions()
+ * Description: return how big the cache is, how full it is, and how many
+ *              lookups found a shape, missed it, and how many shapes have
+ *              been dropped to make room
+*******************************************************************************/
+size_t SettlementCache::getCapacity() const {
+    return this->capacity;
+}
+
+
+size_t SettlementCache::getBytesUsed() const {
+    std::lock_guard<std::mutex> guard(this->lock);
+    return this->bytesUsed;
+}
+
+
+int SettlementCache::getEntryCount() const {
+    std::lock_guard<std::mutex> guard(this->lock);
+    return this->entries.size();
+}
+
+
+long SettlementCache::getHits() const {
+    std::lock_guard<std::mutex> guard(this->lock);
+    return this->hits;
+}
+
+
+long SettlementCache::getMisses() const {
+    std::lock_guard<std::mutex> guard(this->lock);
+    return this->misses;
+}
+
+
+long SettlementCache::getEvictions() const {
+    std::lock_guard<std::mutex> guard(this->lock);
+    return this->evictions;
+}
@@ -0,0 +1,88 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Header file for the SettlementCache class. Many games have the
+ *              same shape - the same buy-ins and the same outcomes at the same
+ *              table - under different names. A SettlementCache remembers how
+ *              each shape was settled, so a game with the same balances as one
+ *              already solved takes its payments from the cache instead of
+ *              being solved again.
+ *
+ *              A shape is the game's balances sorted into increasing order,
+ *              and its payments are kept as a template between positions in
+ *              that order, so they fit any game with the same balances,
+ *              whoever its players are. Shapes are found by a hash of the
+ *              balances and then compared in full, so two shapes that share a
+ *              hash are never mixed up.
+ *
+ *              The cache holds at most a set number of bytes of shapes and
+ *              templates. When a new one won't fit, the least recently used
+ *              ones are dropped to make room. It's locked, so any number of
+ *              threads can share one cache.
+*******************************************************************************/
+#ifndef SETTLEMENTCACHE_HPP
+#define SETTLEMENTCACHE_HPP
+
+#include <stdint.h>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "Amount.hpp"
+#include "Structs.hpp"
+
+//a payment of a template, between the players at two positions of a shape
+struct CachedPayment{
+    int payer;
+    int payee;
+    Amount amount;
+};
+
+class SettlementCache
+{
+    private:
+        struct Entry{
+            uint64_t hash;
+            SolverType solver;
+            bool pairing;           //whether exact matches were paired first
+            std::vector<Amount> balances;
+            std::vector<CachedPayment> payments;
+            int pairedPayments;
+            size_t bytes;           //what the entry counts against capacity
+        };
+
+        //most recently used first. The index finds an entry by its hash
+        typedef std::list<Entry> EntryList;
+        EntryList entries;
+        std::unordered_multimap<uint64_t, EntryList::iterator> index;
+        size_t capacity;
+        size_t bytesUsed;
+        long hits;
+        long misses;
+        long evictions;
+        mutable std::mutex lock;
+
+        EntryList::iterator findEntry(uint64_t hash, SolverType solver,
+                                      bool pairing,
+                                      const std::vector<Amount>& balances);
+        void evict();
+
+    public:
+        SettlementCache(size_t capacity);
+        static uint64_t hashBalances(const std::vector<Amount>& balances);
+        bool find(uint64_t hash, SolverType solver, bool pairing,
+                  const std::vector<Amount>& balances,
+                  std::vector<CachedPayment>& payments, int& pairedPayments);
+        void insert(uint64_t hash, SolverType solver, bool pairing,
+                    const std::vector<Amount>& balances,
+                    const std::vector<CachedPayment>& payments,
+                    int pairedPayments);
+        size_t getCapacity() const;
+        size_t getBytesUsed() const;
+        int getEntryCount() const;
+        long getHits() const;
+        long getMisses() const;
+        long getEvictions() const;
+};
+
+#endif
@@ -0,0 +1,595 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Implementation of the SettlementServer class. All sockets are
+ *              non-blocking and watched by one epoll instance. Each pass of
+ *              the event loop waits for the first ready socket, then keeps
+ *              handling ready sockets without waiting until there are none
+ *              left, and settles every request that came in along the way in
+ *              one ParallelSettler pass. A request's latency runs from when
+ *              its last byte was read to when its response is queued.
+*******************************************************************************/
+#include "SettlementServer.hpp"
+#include "Metrics.hpp"
+#include "PlayerNames.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <sstream>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+//most ready sockets handled per epoll_wait call, most epoll_wait calls
+//before the requests read so far are settled, and bytes read per recv
+const int SERVER_MAX_EVENTS = 64;
+const int SERVER_DRAIN_PASSES = 16;
+const int SERVER_READ_BYTES = 64 * 1024;
+
+//set by SIGINT and SIGTERM to stop the event loop
+static volatile sig_atomic_t stopRequested = 0;
+
+static void requestStop(int){
+    stopRequested = 1;
+}
+
+
+/*******************************************************************************
+ *           SettlementServer(const std::string&, SolverType, int)
+ * Description: Constructor. Takes the path of the socket to listen on, the
+ *              algorithm games are solved with, and the number of threads to
+ *              solve them on. Nothing is opened until run() is called.
+*******************************************************************************/
+SettlementServer::SettlementServer(const std::string& socketPath,
+                                   SolverType solver, int threadCount)
+    : socketPath(socketPath), solver(solver), threadCount(threadCount) {
+    this->cache = NULL;
+    this->listenFd = -1;
+    this->epollFd = -1;
+    this->nextLatency = 0;
+    this->requestsServed = 0;
+    this->batchesRun = 0;
+    this->gamesSettled = 0;
+    this->gamesSkipped = 0;
+}
+
+
+/*******************************************************************************
+ *                          ~SettlementServer()
+ * Description: Destructor. Closes every connection and the socket, and
+ *              removes the socket file.
+*******************************************************************************/
+SettlementServer::~SettlementServer() {
+    while(!this->connections.empty()){
+        this->closeConnection(this->connections.begin()->second);
+    }
+    for(int i = 0; i < this->pending.size(); ++i){
+        for(int j = 0; j < this->pending[i].games.size(); ++j){
+            delete this->pending[i].games[j].game;
+        }
+    }
+    for(int i = 0; i < this->closed.size(); ++i){
+        delete this->closed[i];
+    }
+
+    if(this->listenFd >= 0){
+        ::close(this->listenFd);
+        unlink(this->socketPath.c_str());
+    }
+    if(this->epollFd >= 0){
+        ::close(this->epollFd);
+    }
+}
+
+
+/*******************************************************************************
+ *                        setCache(SettlementCache*)
+ * Description: settles the games the solver would through the cache, which
+ *              must outlive the server, so a shape sent by any client is only
+ *              solved once while it stays in the cache
+*******************************************************************************/
+void SettlementServer::setCache(SettlementCache* cache) {
+    this->cache = cache;
+}
+
+
+/*******************************************************************************
+ *                          listen(std::ostream&)
+ * Description: Creates the listening socket and the epoll instance. A stale
+ *              socket left behind by an earlier server is replaced, but any
+ *              other kind of file at the path is left alone. Returns false
+ *              and reports why on log if the server can't start.
+*******************************************************************************/
+bool SettlementServer::listen(std::ostream& log) {
+    struct sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(this->socketPath.size() >= sizeof(address.sun_path)){
+        log << "socket path " << this->socketPath << " is too long"
+            << std::endl;
+        return false;
+    }
+    std::strcpy(address.sun_path, this->socketPath.c_str());
+
+    struct stat status;
+    if(stat(this->socketPath.c_str(), &status) == 0){
+        if(!S_ISSOCK(status.st_mode)){
+            log << this->socketPath << " exists and is not a socket"
+                << std::endl;
+            return false;
+        }
+        unlink(this->socketPath.c_str());
+    }
+
+    this->listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK |
+                            SOCK_CLOEXEC, 0);
+    if(this->listenFd < 0 ||
+       bind(this->listenFd, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+       ::listen(this->listenFd, SOMAXCONN) != 0){
+        log << "could not listen on " << this->socketPath << ": "
+            << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    this->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = this->listenFd;
+    if(this->epollFd < 0 ||
+       epoll_ctl(this->epollFd, EPOLL_CTL_ADD, this->listenFd, &event) != 0){
+        log << "could not start the event loop: " << std::strerror(errno)
+            << std::endl;
+        return false;
+    }
+    return true;
+}
+
+
+/*******************************************************************************
+ *                           run(std::ostream&)
+ * Description: Serves requests until SIGINT or SIGTERM. Returns 0 after a
+ *              clean shutdown, or 2 if the server couldn't start.
+*******************************************************************************/
+int SettlementServer::run(std::ostream& log) {
+    if(!this->listen(log)){
+        return 2;
+    }
+
+    //no SA_RESTART, so a signal wakes epoll_wait up
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = requestStop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    ParallelSettler settler(this->threadCount, this->solver);
+    settler.setCache(this->cache);
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    log << "listening on " << this->socketPath << " with "
+        << settler.getThreadCount() << " threads" << std::endl;
+
+    while(!stopRequested){
+        int ready = epoll_wait(this->epollFd, events, SERVER_MAX_EVENTS, -1);
+
+        //handle everything that's ready before settling anything, but don't
+        //let a steady stream of clients hold up the ones already read
+        for(int pass = 1; ready > 0; ++pass){
+            for(int i = 0; i < ready; ++i){
+                int fd = events[i].data.fd;
+                if(fd == this->listenFd){
+                    this->acceptConnections();
+                    continue;
+                }
+
+                //the connection may have been closed earlier in this pass
+                std::map<int, Connection*>::iterator found =
+                    this->connections.find(fd);
+                if(found == this->connections.end()){
+                    continue;
+                }
+                Connection* connection = found->second;
+                if(events[i].events & EPOLLOUT){
+                    this->writeConnection(connection);
+                }
+                if(connection->fd >= 0 &&
+                   (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))){
+                    this->readConnection(connection);
+                }
+            }
+            if(pass == SERVER_DRAIN_PASSES){
+                break;
+            }
+            ready = epoll_wait(this->epollFd, events, SERVER_MAX_EVENTS, 0);
+        }
+
+        if(ready < 0 && errno != EINTR){
+            log << "event loop failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        this->settlePending(settler);
+    }
+
+    return 0;
+}
+
+
+/*******************************************************************************
+ *                          acceptConnections()
+ * Description: Accepts every connection waiting on the listening socket.
+*******************************************************************************/
+void SettlementServer::acceptConnections() {
+    while(true){
+        int fd = accept4(this->listenFd, NULL, NULL,
+                         SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if(fd < 0){
+            return;
+        }
+
+        Connection* connection = new Connection;
+        connection->fd = fd;
+        connection->scanned = 0;
+        connection->watching = EPOLLIN;
+        connection->closing = false;
+        connection->pendingRequests = 0;
+
+        struct epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if(epoll_ctl(this->epollFd, EPOLL_CTL_ADD, fd, &event) != 0){
+            ::close(fd);
+            delete connection;
+            continue;
+        }
+        this->connections[fd] = connection;
+    }
+}
+
+
+/*******************************************************************************
+ *                         readConnection(Connection*)
+ * Description: Reads everything the client has sent and queues each complete
+ *              request. When the client shuts down its end, whatever it sent
+ *              last counts as a request even without the empty line, and the
+ *              connection is closed once its responses are written.
+*******************************************************************************/
+void SettlementServer::readConnection(Connection* connection) {
+    char buffer[SERVER_READ_BYTES];
+    bool finished = false;
+
+    while(!connection->closing){
+        ssize_t received = recv(connection->fd, buffer, sizeof(buffer), 0);
+        if(received > 0){
+            connection->input.append(buffer, received);
+            continue;
+        }
+        if(received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)){
+            break;
+        }
+        if(received < 0 && errno == EINTR){
+            continue;
+        }
+        finished = true;
+        break;
+    }
+
+    if(connection->input.size() > SERVER_MAX_REQUEST_BYTES){
+        connection->input.clear();
+        connection->output += "# request is larger than " +
+                              std::to_string(SERVER_MAX_REQUEST_BYTES) +
+                              " bytes\n\n";
+        connection->closing = true;
+        this->writeConnection(connection);
+        return;
+    }
+
+    if(finished){
+        connection->closing = true;
+        if(connection->input.find_first_not_of(" \r\n") != std::string::npos){
+            connection->input += "\n\n";
+        }
+    }
+    this->takeRequests(connection);
+
+    if(connection->closing){
+        this->writeConnection(connection);
+    }
+}
+
+
+/*******************************************************************************
+ *                         takeRequests(Connection*)
+ * Description: Moves every request that ends with an empty line out of the
+ *              connection's input and onto the pending list.
+*******************************************************************************/
+void SettlementServer::takeRequests(Connection* connection) {
+    std::string& input = connection->input;
+    size_t lineStart = connection->scanned;
+    size_t requestStart = 0;
+
+    //find whole lines that haven't been looked at yet
+    size_t newline;
+    while((newline = input.find('\n', lineStart)) != std::string::npos){
+        size_t lineLength = newline - lineStart;
+        bool blank = lineLength == 0 ||
+                     (lineLength == 1 && input[lineStart] == '\r');
+        lineStart = newline + 1;
+        if(!blank){
+            continue;
+        }
+
+        std::string text = input.substr(requestStart,
+                                        lineStart - requestStart);
+        requestStart = lineStart;
+
+        //extra empty lines between requests aren't requests themselves
+        if(text.find_first_not_of(" \r\n") == std::string::npos){
+            continue;
+        }
+
+        Request request;
+        request.connection = connection;
+        request.received = std::chrono::steady_clock::now();
+
+        request.stats = text == "STATS\n\n" || text == "STATS\r\n\r\n";
+        request.metrics = text == "METRICS\n\n" ||
+                          text == "METRICS\r\n\r\n";
+        if(!request.stats && !request.metrics){
+            std::istringstream ledger(text);
+            LedgerReader reader(ledger);
+            LedgerGame record;
+            while(reader.nextGame(record)){
+                request.games.push_back(record);
+            }
+        }
+
+        connection->pendingRequests++;
+        this->pending.push_back(request);
+    }
+
+    input.erase(0, requestStart);
+    connection->scanned = lineStart - requestStart;
+}
+
+
+/*******************************************************************************
+ *                       settlePending(ParallelSettler&)
+ * Description: Settles the games of every pending request in one pass and
+ *              queues each request's response on its connection.
+*******************************************************************************/
+void SettlementServer::settlePending(ParallelSettler& settler) {
+    if(!this->pending.empty()){
+        std::vector<LedgerGame> games;
+        std::vector<GameSettlement> results;
+        for(int i = 0; i < this->pending.size(); ++i){
+            games.insert(games.end(), this->pending[i].games.begin(),
+                         this->pending[i].games.end());
+        }
+        settler.settleGames(games, results);
+        this->batchesRun++;
+
+        //write out every response first, so that the percentiles only have
+        //to be worked out once for the whole batch
+        std::vector<std::string> responses(this->pending.size());
+        std::vector<long> latencies(this->pending.size());
+        int next = 0;
+        for(int i = 0; i < this->pending.size(); ++i){
+            Request& request = this->pending[i];
+            std::ostringstream response;
+
+            for(int j = 0; j < request.games.size(); ++j, ++next){
+                const LedgerGame& record = request.games[j];
+                const GameSettlement& result = results[next];
+                if(!result.error.empty()){
+                    response << "# game " << record.gameId << " skipped: "
+                             << result.error << "\n";
+                    this->gamesSkipped++;
+                }
+                else{
+                    for(int k = 0; k < result.payments.size(); ++k){
+                        const Payment& payment = result.payments[k];
+                        response << record.gameId << ','
+                                 << payment.payer->getName() << ','
+                                 << payment.payee->getName() << ','
+                                 << payment.amount << '\n';
+                        METRICS_ADD(BYTES_PRINTED,
+                                    record.gameId.size() +
+                                    payment.payer->getName().size() +
+                                    payment.payee->getName().size() +
+                                    decimalWidth(payment.amount) + 4);
+                    }
+                    this->gamesSettled++;
+                }
+                delete record.game;
+            }
+            responses[i] = response.str();
+
+            std::chrono::duration<double, std::micro> latency =
+                std::chrono::steady_clock::now() - request.received;
+            latencies[i] = (long)latency.count();
+            this->recordLatency(latency.count());
+            this->requestsServed++;
+        }
+
+        long p50 = (long)this->getPercentile(0.50);
+        long p99 = (long)this->getPercentile(0.99);
+        for(int i = 0; i < this->pending.size(); ++i){
+            Request& request = this->pending[i];
+            std::ostringstream trailer;
+            if(request.stats){
+                trailer << this->formatStats() << "\n\n";
+            }
+            else if(request.metrics && !Metrics::isEnabled()){
+                trailer << "# PokerCalc was built without metrics; rebuild it "
+                        << "with make METRICS=1 to use METRICS\n\n";
+            }
+            else if(request.metrics){
+                Metrics::write(trailer, METRICS_PROMETHEUS);
+                trailer << "\n";
+            }
+            else{
+                trailer << "# latency_us=" << latencies[i] << " p50_us=" << p50
+                        << " p99_us=" << p99 << "\n\n";
+            }
+
+            Connection* connection = request.connection;
+            connection->pendingRequests--;
+            if(connection->fd >= 0){
+                connection->output += responses[i];
+                connection->output += trailer.str();
+                this->writeConnection(connection);
+            }
+        }
+        this->pending.clear();
+    }
+
+    for(int i = 0; i < this->closed.size(); ++i){
+        delete this->closed[i];
+    }
+    this->closed.clear();
+}
+
+
+/*******************************************************************************
+ *                        writeConnection(Connection*)
+ * Description: Writes as much of the connection's output as the socket will
+ *              take, and watches for the socket becoming writable again if
+ *              some is left. A closing connection is closed once everything
+ *              it's owed has been written.
+*******************************************************************************/
+void SettlementServer::writeConnection(Connection* connection) {
+    std::string& output = connection->output;
+    size_t written = 0;
+    bool broken = false;
+
+    while(written < output.size()){
+        ssize_t sent = send(connection->fd, output.data() + written,
+                            output.size() - written, MSG_NOSIGNAL);
+        if(sent > 0){
+            written += sent;
+        }
+        else if(sent < 0 && errno == EINTR){
+            continue;
+        }
+        else{
+            broken = sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK;
+            break;
+        }
+    }
+    output.erase(0, written);
+
+    if(broken || (connection->closing && output.empty() &&
+                  connection->pendingRequests == 0)){
+        this->closeConnection(connection);
+        return;
+    }
+
+    //a closing connection has nothing more to read, and would otherwise be
+    //reported readable forever
+    int watching = connection->closing ? 0 : EPOLLIN;
+    if(!output.empty()){
+        watching |= EPOLLOUT;
+    }
+    if(watching != connection->watching){
+        struct epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = watching;
+        event.data.fd = connection->fd;
+        epoll_ctl(this->epollFd, EPOLL_CTL_MOD, connection->fd, &event);
+        connection->watching = watching;
+    }
+}
+
+
+/*******************************************************************************
+ *                        closeConnection(Connection*)
+ * Description: Closes a connection. It isn't freed until after the next
+ *              settle, since pending requests may still point to it.
+*******************************************************************************/
+void SettlementServer::closeConnection(Connection* connection) {
+    if(connection->fd < 0){
+        return;
+    }
+    epoll_ctl(this->epollFd, EPOLL_CTL_DEL, connection->fd, NULL);
+    ::close(connection->fd);
+    this->connections.erase(connection->fd);
+    connection->fd = -1;
+    this->closed.push_back(connection);
+}
+
+
+/*******************************************************************************
+ *                          recordLatency(double)
+ *                          getPercentile(double)
+ * Description: keep the latencies of the last SERVER_LATENCY_WINDOW requests,
+ *              and return the given percentile of them (0.5 for the median)
+*******************************************************************************/
+void SettlementServer::recordLatency(double microseconds) {
+    if(this->latencies.size() < SERVER_LATENCY_WINDOW){
+        this->latencies.push_back(microseconds);
+        return;
+    }
+    this->latencies[this->nextLatency] = microseconds;
+    this->nextLatency = (this->nextLatency + 1) % SERVER_LATENCY_WINDOW;
+}
+
+
+double SettlementServer::getPercentile(double fraction) const {
+    if(this->latencies.empty()){
+        return 0.0;
+    }
+    std::vector<double> sorted(this->latencies);
+    size_t rank = (size_t)(fraction * (sorted.size() - 1) + 0.5);
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank];
+}
+
+
+/*******************************************************************************
+ *                             formatStats()
+ * Description: returns the server's counters and latency percentiles as one
+ *              line of JSON
+*******************************************************************************/
+std::string SettlementServer::formatStats() const {
+    std::ostringstream stats;
+    stats << "{\"requests\": " << this->requestsServed
+          << ", \"batches\": " << this->batchesRun
+          << ", \"games_settled\": " << this->gamesSettled
+          << ", \"games_skipped\": " << this->gamesSkipped
+          << ", \"connections\": " << this->connections.size()
+          << ", \"player_names\": " << PlayerNames::getCount();
+    if(this->cache != NULL){
+        stats << ", \"cache_hits\": " << this->cache->getHits()
+              << ", \"cache_misses\": " << this->cache->getMisses()
+              << ", \"cache_evictions\": " << this->cache->getEvictions()
+              << ", \"cache_bytes\": " << this->cache->getBytesUsed();
+    }
+    stats
+          << ", \"p50_us\": " << this->getPercentile(0.50)
+          << ", \"p99_us\": " << this->getPercentile(0.99) << "}";
+    return stats.str();
+}
+
+
+/*******************************************************************************
+ *                         printStats(std::ostream&)
+ * Description: Reports what the server has done on the log stream.
+*******************************************************************************/
+void SettlementServer::printStats(std::ostream& log) const {
+    log << "served " << this->requestsServed << " requests in "
+        << this->batchesRun << " batches (" << this->gamesSettled
+        << " games settled, " << this->gamesSkipped << " skipped), p50 "
+        << this->getPercentile(0.50) << " us, p99 "
+        << this->getPercentile(0.99) << " us, "
+        << PlayerNames::getCount() << " player names kept" << std::endl;
+    if(this->cache != NULL){
+        log << "settlement cache: " << this->cache->getHits() << " hits, "
+            << this->cache->getMisses() << " misses, "
+            << this->cache->getEvictions() << " evictions" << std::endl;
+    }
+}
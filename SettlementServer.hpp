@@ -0,0 +1,107 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Header file for the SettlementServer class. A SettlementServer
+ *              is a long running daemon that settles ledgers sent to it over a
+ *              Unix domain socket, so callers don't pay for starting PokerCalc
+ *              once per game. A request is a text ledger in the --batch format
+ *              ended by an empty line. The response is the same payment rows
+ *              --batch writes, a "# game <id> skipped: <reason>" line for each
+ *              game that couldn't be settled, a "# latency_us=..." line with
+ *              the request's latency and the server's p50 and p99, and an
+ *              empty line. A request of just "STATS" gets the server's
+ *              counters and latency percentiles back as one line of JSON,
+ *              and a request of just "METRICS" gets the pipeline's Metrics in
+ *              the Prometheus text format, followed by an empty line, or a
+ *              "# ..." error line if PokerCalc was built without metrics.
+ *              Every name a request brings stays in PlayerNames until the
+ *              server stops, so the server is started with a limit on them,
+ *              and a game with a name past it is skipped.
+ *
+ *              The server runs a single epoll event loop. Every request that
+ *              completes while the loop drains ready sockets is settled in the
+ *              same ParallelSettler pass, so concurrent clients are batched
+ *              together and share the solver threads.
+*******************************************************************************/
+#ifndef SETTLEMENTSERVER_HPP
+#define SETTLEMENTSERVER_HPP
+
+#include <chrono>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "LedgerReader.hpp"
+#include "ParallelSettler.hpp"
+#include "Structs.hpp"
+
+//largest request accepted, and how many recent requests the latency
+//percentiles are taken over
+const size_t SERVER_MAX_REQUEST_BYTES = 64 << 20;
+const int SERVER_LATENCY_WINDOW = 10000;
+
+//distinct player names a server keeps, since names are never freed, unless
+//it's started with another limit
+const int SERVER_DEFAULT_MAX_NAMES = 1000000;
+
+class SettlementServer
+{
+    private:
+        struct Connection{
+            int fd;
+            std::string input;      //received, not yet a complete request
+            size_t scanned;         //bytes of input already searched
+            std::string output;     //responses not yet written
+            int watching;           //epoll events registered for fd
+            bool closing;           //close once output has been written
+            int pendingRequests;    //requests waiting to be settled
+        };
+
+        struct Request{
+            Connection* connection;
+            std::vector<LedgerGame> games;
+            bool stats;
+            bool metrics;
+            std::chrono::steady_clock::time_point received;
+        };
+
+        std::string socketPath;
+        SolverType solver;
+        int threadCount;
+        SettlementCache* cache;     //NULL if every game is solved afresh
+        int listenFd;
+        int epollFd;
+        std::map<int, Connection*> connections;
+        std::vector<Connection*> closed;    //freed after the next settle
+        std::vector<Request> pending;
+
+        //latencies of the most recent requests, in microseconds
+        std::vector<double> latencies;
+        int nextLatency;
+        long requestsServed;
+        long batchesRun;
+        long gamesSettled;
+        long gamesSkipped;
+
+        bool listen(std::ostream& log);
+        void acceptConnections();
+        void readConnection(Connection* connection);
+        void takeRequests(Connection* connection);
+        void settlePending(ParallelSettler& settler);
+        void writeConnection(Connection* connection);
+        void closeConnection(Connection* connection);
+        void recordLatency(double microseconds);
+        double getPercentile(double fraction) const;
+        std::string formatStats() const;
+
+    public:
+        SettlementServer(const std::string& socketPath,
+                         SolverType solver = GREEDY_SOLVER,
+                         int threadCount = 1);
+        ~SettlementServer();
+        void setCache(SettlementCache* cache);
+        int run(std::ostream& log);
+        void printStats(std::ostream& log) const;
+};
+
+#endif
@@ -0,0 +1,369 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Implementation of the SettlementWriter class. Each payment is
+ *              written on its own line:
+ *
+ *                  text - [game_id: ]payer owes payee amount.
+ *                  csv  - [game_id,]payer,payee,amount
+ *                  json - {["game":"game_id",]"payer":"payer",
+ *                          "payee":"payee","amount":amount}
+ *                  dot  - "payer" -> "payee" [label="amount"];
+ *
+ *              Amounts are in cents. A DOT settlement is one digraph; a graph
+ *              written on its own also gets a node for every player, so the
+ *              players who are already even show up too, and each game of a
+ *              batch is its own cluster, with the game id in front of its
+ *              node names to keep the games' players apart.
+*******************************************************************************/
+#include "SettlementWriter.hpp"
+#include "PlayerGraph.hpp"
+#include "Metrics.hpp"
+#include <cstring>
+
+
+/*******************************************************************************
+ *                 parseOutputFormat(const char*, OutputFormat&)
+ * Description: sets format to the format with the given name (text, csv, json
+ *              or dot). Returns false if there is no such format.
+*******************************************************************************/
+bool parseOutputFormat(const char* name, OutputFormat& format){
+    if(std::strcmp(name, "text") == 0){
+        format = TEXT_FORMAT;
+    }
+    else if(std::strcmp(name, "csv") == 0){
+        format = CSV_FORMAT;
+    }
+    else if(std::strcmp(name, "json") == 0){
+        format = JSON_FORMAT;
+    }
+    else if(std::strcmp(name, "dot") == 0){
+        format = DOT_FORMAT;
+    }
+    else{
+        return false;
+    }
+    return true;
+}
+
+
+/*******************************************************************************
+ *              SettlementWriter(std::ostream&, OutputFormat)
+ * Description: Constructor. Takes the stream the payments are written to and
+ *              the format to write them in.
+*******************************************************************************/
+SettlementWriter::SettlementWriter(std::ostream& output, OutputFormat format)
+    : output(output), format(format), buffer(new char[WRITER_BUFFER_BYTES]) {
+    this->used = 0;
+    this->bytesWritten = 0;
+    this->started = false;
+    this->finished = false;
+}
+
+
+/*******************************************************************************
+ *                           ~SettlementWriter()
+ * Description: Destructor. Finishes the output if finish() wasn't called.
+*******************************************************************************/
+SettlementWriter::~SettlementWriter(){
+    this->finish();
+}
+
+
+/*******************************************************************************
+ *                             flushBuffer()
+ * Description: hands everything buffered to the output stream in one write
+*******************************************************************************/
+void SettlementWriter::flushBuffer(){
+    if(this->used == 0){
+        return;
+    }
+    this->output.write(this->buffer.get(), this->used);
+    METRICS_ADD(BYTES_PRINTED, this->used);
+    this->bytesWritten += this->used;
+    this->used = 0;
+}
+
+
+/*******************************************************************************
+ *                   put(const char*, size_t) / put(const char*)
+ * Description: append text to the buffer, writing the buffer out first if
+ *              the text doesn't fit. Text bigger than the whole buffer is
+ *              written straight to the output stream.
+*******************************************************************************/
+void SettlementWriter::put(const char* text, size_t length){
+    if(this->used + length > WRITER_BUFFER_BYTES){
+        this->flushBuffer();
+        if(length > WRITER_BUFFER_BYTES){
+            this->output.write(text, length);
+            METRICS_ADD(BYTES_PRINTED, length);
+            this->bytesWritten += length;
+            return;
+        }
+    }
+    std::memcpy(this->buffer.get() + this->used, text, length);
+    this->used += length;
+}
+
+
+void SettlementWriter::put(const char* text){
+    this->put(text, std::strlen(text));
+}
+
+
+/*******************************************************************************
+ *                             putAmount(Amount)
+ * Description: appends an amount in decimal
+*******************************************************************************/
+void SettlementWriter::putAmount(Amount amount){
+    char digits[AMOUNT_DIGITS];
+    char* end = digits + sizeof(digits);
+    char* start = formatAmount(amount, end);
+    this->put(start, end - start);
+}
+
+
+/*******************************************************************************
+ *                      putEscaped(const char*, size_t)
+ * Description: appends text with quotes and backslashes escaped, for use
+ *              inside a JSON or DOT string. JSON gets control characters
+ *              escaped too.
+*******************************************************************************/
+void SettlementWriter::putEscaped(const char* text, size_t length){
+    size_t plain = 0;
+    for(size_t i = 0; i < length; ++i){
+        unsigned char c = text[i];
+        bool control = c < 0x20 && this->format == JSON_FORMAT;
+        if(c != '"' && c != '\\' && !control){
+            continue;
+        }
+
+        //write out the run of characters that needed no escaping
+        this->put(text + plain, i - plain);
+        plain = i + 1;
+        if(c == '"' || c == '\\'){
+            char escaped[2] = {'\\', (char)c};
+            this->put(escaped, 2);
+        }
+        else{
+            const char* hex = "0123456789abcdef";
+            char escaped[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 15]};
+            this->put(escaped, 6);
+        }
+    }
+    this->put(text + plain, length - plain);
+}
+
+
+/*******************************************************************************
+ *                      putString(const char*, size_t)
+ * Description: appends text as it goes in the output format. CSV and text
+ *              take it as is, and JSON and DOT get it escaped and in double
+ *              quotes.
+*******************************************************************************/
+void SettlementWriter::putString(const char* text, size_t length){
+    if(this->format == TEXT_FORMAT || this->format == CSV_FORMAT){
+        this->put(text, length);
+        return;
+    }
+    this->put("\"", 1);
+    this->putEscaped(text, length);
+    this->put("\"", 1);
+}
+
+
+/*******************************************************************************
+ *         putDotNode(const char*, size_t, const char*, size_t)
+ * Description: appends a DOT node name for a player, "name" on its own or
+ *              "game_id/name" when there's a game id
+*******************************************************************************/
+void SettlementWriter::putDotNode(const char* gameId, size_t gameIdLength,
+                                  const char* name, size_t nameLength){
+    this->put("\"", 1);
+    if(gameId != NULL){
+        this->putEscaped(gameId, gameIdLength);
+        this->put("/", 1);
+    }
+    this->putEscaped(name, nameLength);
+    this->put("\"", 1);
+}
+
+
+/*******************************************************************************
+ *                                 start()
+ * Description: writes what comes before the first payment, which is only the
+ *              DOT digraph's header
+*******************************************************************************/
+void SettlementWriter::start(){
+    if(this->started){
+        return;
+    }
+    this->started = true;
+    if(this->format == DOT_FORMAT){
+        this->put("digraph settlement {\n");
+    }
+}
+
+
+/*******************************************************************************
+ *                          writePayment(...)
+ * Description: writes one payment. gameId is NULL for a payment that isn't
+ *              part of a batch.
+*******************************************************************************/
+void SettlementWriter::writePayment(const char* gameId, size_t gameIdLength,
+                                    const char* payer, size_t payerLength,
+                                    const char* payee, size_t payeeLength,
+                                    Amount amount){
+    switch(this->format){
+        case TEXT_FORMAT:
+            if(gameId != NULL){
+                this->put(gameId, gameIdLength);
+                this->put(": ", 2);
+            }
+            this->put(payer, payerLength);
+            this->put(" owes ", 6);
+            this->put(payee, payeeLength);
+            this->put(" ", 1);
+            this->putAmount(amount);
+            this->put(".\n", 2);
+            break;
+
+        case CSV_FORMAT:
+            if(gameId != NULL){
+                this->put(gameId, gameIdLength);
+                this->put(",", 1);
+            }
+            this->put(payer, payerLength);
+            this->put(",", 1);
+            this->put(payee, payeeLength);
+            this->put(",", 1);
+            this->putAmount(amount);
+            this->put("\n", 1);
+            break;
+
+        case JSON_FORMAT:
+            this->put("{", 1);
+            if(gameId != NULL){
+                this->put("\"game\":");
+                this->putString(gameId, gameIdLength);
+                this->put(",", 1);
+            }
+            this->put("\"payer\":");
+            this->putString(payer, payerLength);
+            this->put(",\"payee\":");
+            this->putString(payee, payeeLength);
+            this->put(",\"amount\":");
+            this->putAmount(amount);
+            this->put("}\n", 2);
+            break;
+
+        case DOT_FORMAT:
+            this->put(gameId != NULL ? "    " : "  ");
+            this->putDotNode(gameId, gameIdLength, payer, payerLength);
+            this->put(" -> ", 4);
+            this->putDotNode(gameId, gameIdLength, payee, payeeLength);
+            this->put(" [label=\"");
+            this->putAmount(amount);
+            this->put("\"];\n");
+            break;
+    }
+}
+
+
+/*******************************************************************************
+ *                      writeGraph(const PlayerGraph&)
+ * Description: writes every payment of a solved graph, reading them straight
+ *              from the graph's edge arrays and the names where they're kept
+*******************************************************************************/
+void SettlementWriter::writeGraph(const PlayerGraph& graph){
+    this->start();
+    int nodeCount = graph.getNodeCount();
+
+    //look every name up once, in node order, so the payments find their
+    //payees' names in one flat array instead of chasing each Player
+    std::vector<const char*> names(nodeCount);
+    std::vector<size_t> nameLengths(nodeCount);
+    for(int i = 0; i < nodeCount; ++i){
+        names[i] = graph.getPlayerName(i, nameLengths[i]);
+    }
+
+    //every player is a node, even if they make or get no payments
+    if(this->format == DOT_FORMAT){
+        for(int i = 0; i < nodeCount; ++i){
+            this->put("  ", 2);
+            this->putString(names[i], nameLengths[i]);
+            this->put(";\n", 2);
+        }
+    }
+
+    const std::vector<int>& offsets = graph.getEdgeOffsets();
+    const std::vector<int>& payees = graph.getEdgePayees();
+    const std::vector<Amount>& amounts = graph.getEdgeAmounts();
+    for(int i = 0; i < nodeCount; ++i){
+        for(int j = offsets[i]; j < offsets[i + 1]; ++j){
+            this->writePayment(NULL, 0, names[i], nameLengths[i],
+                               names[payees[j]], nameLengths[payees[j]],
+                               amounts[j]);
+        }
+    }
+}
+
+
+/*******************************************************************************
+ *          writeGame(const std::string&, const std::vector<Payment>&)
+ * Description: writes the payments of one game of a batch, each marked with
+ *              the game's id
+*******************************************************************************/
+void SettlementWriter::writeGame(const std::string& gameId,
+                                 const std::vector<Payment>& payments){
+    this->start();
+    if(this->format == DOT_FORMAT){
+        this->put("  subgraph \"cluster_");
+        this->putEscaped(gameId.data(), gameId.size());
+        this->put("\" {\n    label=");
+        this->putString(gameId.data(), gameId.size());
+        this->put(";\n");
+    }
+
+    for(int i = 0; i < payments.size(); ++i){
+        const Payment& payment = payments[i];
+        const std::string& payer = payment.payer->getName();
+        const std::string& payee = payment.payee->getName();
+        this->writePayment(gameId.data(), gameId.size(),
+                           payer.data(), payer.size(),
+                           payee.data(), payee.size(), payment.amount);
+    }
+
+    if(this->format == DOT_FORMAT){
+        this->put("  }\n");
+    }
+}
+
+
+/*******************************************************************************
+ *                                finish()
+ * Description: writes what comes after the last payment, which is only the
+ *              end of the DOT digraph, and flushes everything to the output
+ *              stream. Nothing more can be written afterwards.
+*******************************************************************************/
+void SettlementWriter::finish(){
+    if(this->finished){
+        return;
+    }
+    this->start();
+    if(this->format == DOT_FORMAT){
+        this->put("}\n", 2);
+    }
+    this->flushBuffer();
+    this->output.flush();
+    this->finished = true;
+}
+
+
+/*******************************************************************************
+ *                            getBytesWritten()
+ * Description: returns the number of bytes handed to the output stream so far
+*******************************************************************************/
+long SettlementWriter::getBytesWritten() const {
+    return this->bytesWritten;
+}
@@ -0,0 +1,77 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Header file for the SettlementWriter class. A SettlementWriter
+ *              writes a settlement's payments in one of several formats:
+ *
+ *                  text - "payer owes payee amount.", for people
+ *                  csv  - payer,payee,amount
+ *                  json - one JSON object per payment (JSON Lines)
+ *                  dot  - a Graphviz digraph with an edge per payment
+ *
+ *              Payments are formatted by hand into a large buffer, which is
+ *              handed to the output stream in one write whenever it fills,
+ *              so writing a settlement never flushes per line and never goes
+ *              through iostream formatting. A solved PlayerGraph is written
+ *              straight from its edge arrays.
+*******************************************************************************/
+#ifndef SETTLEMENTWRITER_HPP
+#define SETTLEMENTWRITER_HPP
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Structs.hpp"
+
+class PlayerGraph;
+
+//the formats a SettlementWriter can write
+enum OutputFormat{
+    TEXT_FORMAT,
+    CSV_FORMAT,
+    JSON_FORMAT,
+    DOT_FORMAT
+};
+
+//bytes buffered before they're written to the output stream
+const int WRITER_BUFFER_BYTES = 1 << 20;
+
+bool parseOutputFormat(const char* name, OutputFormat& format);
+
+class SettlementWriter
+{
+    private:
+        std::ostream& output;
+        OutputFormat format;
+        std::unique_ptr<char[]> buffer;
+        size_t used;
+        long bytesWritten;
+        bool started;
+        bool finished;
+
+        void flushBuffer();
+        void put(const char* text, size_t length);
+        void put(const char* text);
+        void putAmount(Amount amount);
+        void putEscaped(const char* text, size_t length);
+        void putString(const char* text, size_t length);
+        void putDotNode(const char* gameId, size_t gameIdLength,
+                        const char* name, size_t nameLength);
+        void start();
+        void writePayment(const char* gameId, size_t gameIdLength,
+                          const char* payer, size_t payerLength,
+                          const char* payee, size_t payeeLength,
+                          Amount amount);
+
+    public:
+        SettlementWriter(std::ostream& output, OutputFormat format);
+        ~SettlementWriter();
+        void writeGraph(const PlayerGraph& graph);
+        void writeGame(const std::string& gameId,
+                       const std::vector<Payment>& payments);
+        void finish();
+        long getBytesWritten() const;
+};
+
+#endif
@@ -2,21 +2,75 @@
 ** Name: Jordan K Bartos
 ** Date: August 10, 2019
 ** Description: Defines structs used in the PlayerGraph and Graph classes.
+**              Nodes of the graph are plain indices into the PlayerGraph's
+**              arrays, so the structs here work on indices rather than on
+**              pointers to individually allocated nodes.
 *******************************************************************************/
 #ifndef STRUCTS_HPP
 #define STRUCTS_HPP
 
-#include "Player.hpp"
+#include "Amount.hpp"
 
-struct Node{
-    Player* player;
-    std::vector<struct adjNode*> adjacentNodes;
-    int playerOwed;
+class Player;
+
+//one payment of a settlement
+struct Payment{
+    Player* payer;
+    Player* payee;
+    Amount amount;
+};
+
+//the algorithms PlayerGraph::solve() can settle a graph with
+enum SolverType{
+    GREEDY_SOLVER,      //heap based greedy, O(n log n)
+    BUCKET_SOLVER,      //same payments as GREEDY_SOLVER, radix sorted
+    EXACT_SOLVER        //fewest possible payments, for small tables
+};
+
+//what PlayerGraph::solveConstrained() keeps down when not every player can
+//pay every other
+enum SettlementObjective{
+    FEWEST_PAYMENTS,    //direct exact matches first, then cheapest flow
+    LEAST_MONEY_MOVED   //least money sent, counting every relay again
+};
+
+//largest number of players with a non-zero balance (after equal and opposite
+//balances are paired off) that the exact solver will take on. Its tables need
+//sizeof(Amount) + 1 bytes per subset, 36 MB at this size with 64 bit amounts
+const int EXACT_MAX_PLAYERS = 22;
+
+/*******************************************************************************
+**                       compMin(int, int)
+**                       compMax(int, int)
+** Description: comparators for node indices, ordering them by each node's
+**              balance. Used by the heap functions in solveGraph(). compMin
+**              keeps the node that owes the most at the top of a heap, and
+**              compMax keeps the node that is owed the most at the top. Equal
+**              balances are ordered by index, the lower index on top, so every
+**              solver that uses them makes the same choices on the same input,
+**              and a game solved with its nodes sorted by balance, as
+**              solveCached() does, makes the same choices for any players.
+*******************************************************************************/
+struct compMin{
+    const Amount* balances;
+
+    bool operator()(int first, int second) const {
+        if(balances[first] != balances[second]){
+            return balances[first] < balances[second];
+        }
+        return first > second;
+    }
 };
 
-struct adjNode{
-    struct Node* node;
-    int edgeWeight;
+struct compMax{
+    const Amount* balances;
+
+    bool operator()(int first, int second) const {
+        if(balances[first] != balances[second]){
+            return balances[first] > balances[second];
+        }
+        return first > second;
+    }
 };
 
 #endif
@@ -0,0 +1,154 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Implementation of the ThreadPool class. Submitted tasks are
+ *              dealt out to the workers' queues in turn. Workers run their own
+ *              tasks newest first and steal other workers' tasks oldest first.
+ *              Each queue has its own lock, so workers only contend with each
+ *              other when one of them is stealing.
+*******************************************************************************/
+#include "ThreadPool.hpp"
+
+
+/*******************************************************************************
+ *                             ThreadPool(int)
+ * Description: Constructor. Starts threadCount worker threads, at least one.
+*******************************************************************************/
+ThreadPool::ThreadPool(int threadCount) 
+    : queues(threadCount < 1 ? 1 : threadCount) {
+    this->queuedTasks = 0;
+    this->unfinishedTasks = 0;
+    this->stopping = false;
+    this->nextQueue = 0;
+
+    for(int i = 0; i < this->queues.size(); ++i){
+        this->workers.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+    }
+}
+
+
+/*******************************************************************************
+ *                             ~ThreadPool()
+ * Description: Destructor. Lets the workers finish every queued task, then
+ *              joins them.
+*******************************************************************************/
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(this->idleLock);
+        this->stopping = true;
+    }
+    this->workAvailable.notify_all();
+
+    for(int i = 0; i < this->workers.size(); ++i){
+        this->workers.at(i).join();
+    }
+}
+
+
+/*******************************************************************************
+ *                            getThreadCount()
+ * Description: returns the number of worker threads
+*******************************************************************************/
+int ThreadPool::getThreadCount() const {
+    return this->workers.size();
+}
+
+
+/*******************************************************************************
+ *                     submit(const std::function<void()>&)
+ * Description: Adds a task to the next worker's queue and wakes a worker up
+ *              to run it.
+*******************************************************************************/
+void ThreadPool::submit(const std::function<void()>& task) {
+    WorkQueue& queue = this->queues.at(this->nextQueue);
+    this->nextQueue = (this->nextQueue + 1) % this->queues.size();
+
+    this->unfinishedTasks++;
+    {
+        std::lock_guard<std::mutex> guard(queue.lock);
+        queue.tasks.push_back(task);
+        this->queuedTasks++;
+    }
+
+    //take the idle lock so a worker can't miss the wake up between checking
+    //for work and going to sleep
+    {
+        std::lock_guard<std::mutex> guard(this->idleLock);
+    }
+    this->workAvailable.notify_one();
+}
+
+
+/*******************************************************************************
+ *                                  wait()
+ * Description: Blocks until every task submitted so far has finished.
+*******************************************************************************/
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> guard(this->idleLock);
+    while(this->unfinishedTasks != 0){
+        this->allDone.wait(guard);
+    }
+}
+
+
+/*******************************************************************************
+ *                   takeTask(int, std::function<void()>&)
+ * Description: Takes the newest task from worker index's own queue or, if it
+ *              is empty, the oldest task from another worker's queue. Returns
+ *              false if every queue is empty.
+*******************************************************************************/
+bool ThreadPool::takeTask(int index, std::function<void()>& task) {
+    int queueCount = this->queues.size();
+
+    for(int i = 0; i < queueCount; ++i){
+        WorkQueue& queue = this->queues.at((index + i) % queueCount);
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if(queue.tasks.empty()){
+            continue;
+        }
+
+        if(i == 0){
+            task.swap(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else{
+            task.swap(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        this->queuedTasks--;
+        return true;
+    }
+    return false;
+}
+
+
+/*******************************************************************************
+ *                             workerLoop(int)
+ * Description: Body of each worker thread. Runs tasks until the pool is
+ *              stopping and every queue is empty, sleeping while there is no
+ *              work.
+*******************************************************************************/
+void ThreadPool::workerLoop(int index) {
+    std::function<void()> task;
+
+    while(true){
+        if(this->takeTask(index, task)){
+            task();
+            task = NULL;
+
+            if(--this->unfinishedTasks == 0){
+                std::lock_guard<std::mutex> guard(this->idleLock);
+                this->allDone.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(this->idleLock);
+        while(this->queuedTasks == 0 && !this->stopping){
+            this->workAvailable.wait(guard);
+        }
+        if(this->queuedTasks == 0 && this->stopping){
+            return;
+        }
+    }
+}
@@ -0,0 +1,50 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Header file for the ThreadPool class. A ThreadPool runs tasks
+ *              on a fixed set of worker threads. Each worker has its own queue
+ *              of tasks. A worker takes its newest task first and, when its
+ *              own queue is empty, steals the oldest task from another
+ *              worker's queue, so uneven tasks still keep every worker busy.
+*******************************************************************************/
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+    private:
+        struct WorkQueue{
+            std::mutex lock;
+            std::deque<std::function<void()> > tasks;
+        };
+
+        std::vector<std::thread> workers;
+        std::vector<WorkQueue> queues;
+        std::mutex idleLock;
+        std::condition_variable workAvailable;
+        std::condition_variable allDone;
+        std::atomic<long> queuedTasks;     //tasks waiting in a queue
+        std::atomic<long> unfinishedTasks; //tasks submitted but not finished
+        bool stopping;
+        unsigned nextQueue;
+
+        void workerLoop(int index);
+        bool takeTask(int index, std::function<void()>& task);
+
+    public:
+        ThreadPool(int threadCount);
+        ~ThreadPool();
+        int getThreadCount() const;
+        void submit(const std::function<void()>& task);
+        void wait();
+};
+
+#endif
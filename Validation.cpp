@@ -0,0 +1,20 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Implementation of PokerCalc's validation checks. A check that
+ *              fails means PokerCalc itself has a bug, so there's nothing to
+ *              recover: the check is reported and the program aborts.
+*******************************************************************************/
+#include "Validation.hpp"
+#include <cstdio>
+#include <cstdlib>
+
+
+/*******************************************************************************
+ *                 validationFailed(const char*, const char*, int)
+ * Description: reports a failed check on stderr and aborts
+*******************************************************************************/
+void validationFailed(const char* check, const char* file, int line) {
+    std::fprintf(stderr, "%s:%d: validation failed: %s\n", file, line, check);
+    std::abort();
+}
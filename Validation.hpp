@@ -0,0 +1,50 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Header file for PokerCalc's validation checks. How much is
+ *              checked is chosen when PokerCalc is built, with
+ *              POKERCALC_VALIDATION (make VALIDATION=n):
+ *
+ *                  0 (off)      nothing is checked and the checks cost nothing
+ *                  1 (cheap)    constant time checks, and an O(n) audit of
+ *                               every solved graph: the balances net to zero,
+ *                               every payment is positive and goes between
+ *                               two different players, every player ends up
+ *                               settled and there are at most n - 1 payments
+ *                  2 (paranoid) everything cheap checks, plus the expensive
+ *                               checks made inside the solvers' loops, such
+ *                               as checking both heaps after every payment,
+ *                               which makes solving O(n^2)
+ *
+ *              Cheap is the default, and is meant to stay on in production. A
+ *              failed check reports what failed and where, and aborts.
+*******************************************************************************/
+#ifndef VALIDATION_HPP
+#define VALIDATION_HPP
+
+#ifndef POKERCALC_VALIDATION
+#define POKERCALC_VALIDATION 1
+#endif
+
+#if POKERCALC_VALIDATION < 0 || POKERCALC_VALIDATION > 2
+#error "POKERCALC_VALIDATION must be 0 (off), 1 (cheap) or 2 (paranoid)"
+#endif
+
+[[noreturn]] void validationFailed(const char* check, const char* file,
+                                   int line);
+
+#if POKERCALC_VALIDATION >= 1
+#define VALIDATE_CHEAP(check) \
+    ((check) ? (void)0 : validationFailed(#check, __FILE__, __LINE__))
+#else
+#define VALIDATE_CHEAP(check) ((void)0)
+#endif
+
+#if POKERCALC_VALIDATION >= 2
+#define VALIDATE_PARANOID(check) \
+    ((check) ? (void)0 : validationFailed(#check, __FILE__, __LINE__))
+#else
+#define VALIDATE_PARANOID(check) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,1793 @@
+/*******************************************************************************
+ * Author: Jordan K Bartos
+ * Date: October 17, 2026
+ * Description: Benchmarks for PlayerGraph. Generates seeded games with several
+ *              distributions of balances at sizes from 10 to 10,000,000
+ *              players, then times building and solving a PlayerGraph for
+ *              each one. For every run it reports nanoseconds per player, the
+ *              number of allocations made while building and solving, the
+ *              process's peak resident set size so far, and the number of
+ *              payments in the settlement, along with how many of them the
+ *              exact match pass made and how many there are without it. The
+ *              peak is the process's, from getrusage(), so it only ever grows:
+ *              a run's figure is its own peak only if no earlier run went
+ *              higher. Results are written to stdout as JSON so runs can be
+ *              compared over time; progress goes to stderr.
+ *
+ *              With --live, it instead times LiveSettlement previews: chips
+ *              move between random players of a running game and the
+ *              settlement is repaired after every move.
+ *
+ *              With --session, it times logging a game's changes to a
+ *              SessionLog and rebuilding the game from the log afterwards,
+ *              for 1,000 up to 1,000,000 logged changes.
+ *
+ *              With --reads, it counts the allocations made by the read
+ *              paths used to print a settlement: reading the game's players
+ *              and their names, and the solved graph's players, names and
+ *              payments. None of them should allocate.
+ *
+ *              With --writer, it times writing a solved game's payments with
+ *              a SettlementWriter in each output format, to /dev/null, and
+ *              reports the throughput in MB/s.
+ *
+ *              With --kernels, it times the passes a PlayerGraph makes over a
+ *              binary ledger's players before solving - working out the
+ *              balances, checking they sum to 0 and splitting the winners
+ *              from the losers - with each level of AmountKernels the CPU
+ *              supports, and reports each level's speedup over plain loops.
+ *
+ *              With --club, it times netting a club's tables with a
+ *              ClubSettler, for 1,000 up to 1,000,000 seats at eight seat
+ *              tables with each player sitting at three tables on average,
+ *              and compares the club's payments with settling every table on
+ *              its own.
+ *
+ *              With --quality, it measures how many more payments the solver
+ *              makes than it has to. Seeded tables of every distribution, and
+ *              adversarial ones hiding zero-sum groups of three to five
+ *              players, are settled with the solver and compared with the
+ *              exact solver up to 18 players, and with a lower bound on the
+ *              fewest payments at 100 up to 100,000 players. It reports how
+ *              the gaps are spread and how long each solver took per table.
+ *
+ *              With --parser, it times a LedgerReader reading a text ledger
+ *              of eight seat tables held in memory, for 1,000 up to
+ *              10,000,000 rows, and reports the throughput in MB/s. The
+ *              players' names are drawn from as many names as there are rows,
+ *              and from a season's worth of 5,000 names. It first checks that
+ *              a few malformed ledgers are read the way they should be, and
+ *              exits with 1 if they aren't.
+ *
+ *              With --allowed, it times settling games over allowed payments,
+ *              a ring of them plus nine random ones per player, for 1,000 up
+ *              to 100,000 players, with both objectives. It first checks a
+ *              few small games, including ones where players paired off are
+ *              the only path between the others, and exits with 1 if any is
+ *              settled wrongly.
+ *
+ *              usage: PokerCalcBench [--seed n] [--min-players n]
+ *                                    [--max-players n]
+ *                                    [--solver greedy|bucket|exact]
+ *                                    [--distribution name] [--live]
+ *                                    [--session] [--reads] [--writer]
+ *                                    [--kernels] [--club] [--quality]
+ *                                    [--parser] [--allowed]
+*******************************************************************************/
+#include "Game.hpp"
+#include "AmountKernels.hpp"
+#include "BinaryLedger.hpp"
+#include "ClubSettler.hpp"
+#include "PlayerGraph.hpp"
+#include "LiveSettlement.hpp"
+#include "SessionLog.hpp"
+#include "SettlementWriter.hpp"
+#include "Metrics.hpp"
+#include "Validation.hpp"
+#include "LedgerReader.hpp"
+#include "helperFunctions.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+//every allocation the benchmark makes goes through here so they can be counted,
+//both by the benchmark and by Metrics when they're compiled in
+static long allocationCount = 0;
+
+void* operator new(size_t size){
+    allocationCount++;
+    METRICS_ADD(ALLOCATIONS, 1);
+    void* memory = std::malloc(size);
+    if(memory == NULL){
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
+
+//the balance distributions the benchmark covers
+const char* const DISTRIBUTIONS[] = {
+    "uniform", "heavy-tailed", "one-big-winner", "exact-pairs"
+};
+const int DISTRIBUTION_COUNT = 4;
+
+//keep repeating small games until at least this much time has been measured
+const double MIN_MEASURED_SECONDS = 0.2;
+
+//the output formats the writer benchmark covers
+const char* const WRITER_FORMATS[] = {"text", "csv", "json", "dot"};
+const int WRITER_FORMAT_COUNT = 4;
+
+//chip moves made in each live settlement run
+const int LIVE_MOVES = 2000;
+
+//the session log benchmark's log, removed once it's done, and the most
+//changes it logs
+const char* const SESSION_BENCH_LOG = "bench_session.log";
+const int SESSION_BENCH_MAX_EVENTS = 1000000;
+
+//the club benchmark's tables, the seats each player takes on average, and
+//the most seats it nets
+const int CLUB_BENCH_TABLE_SEATS = 8;
+const int CLUB_BENCH_SEATS_PER_PLAYER = 3;
+const int CLUB_BENCH_MAX_SEATS = 1000000;
+
+//the ledger parser benchmark's seats at each table, the most rows it reads,
+//and the names a season's ledgers are drawn from
+const int PARSER_TABLE_SEATS = 8;
+const int PARSER_MAX_ROWS = 10000000;
+const int PARSER_SEASON_NAMES = 5000;
+
+//malformed ledgers the parser benchmark checks first, and how each one's
+//games should be read: every game's id, then its player count, or where its
+//first bad row is
+const char* const PARSER_CHECK_LEDGERS[] = {
+    "g1,Bobby,100\ng1,Alice,100,50\ng1,Carol,50,100\n",
+    "g1,Alice,100,50\ng1,Bobby,100\ng1,Carol,50,100\n",
+    "g1,Alice,100,50\ng1,Carol,50,100\ng2,Bobby\ng2,Dave,1,1\n",
+    "g1,Alice,1,1\ng1\n",
+    "g1,Al\tce,100,50\ng1,Bobby,50,100\n"
+};
+const char* const PARSER_CHECK_GAMES[] = {
+    "g1:line 1, column 13",
+    "g1:line 2, column 13",
+    "g1:2|g2:line 3, column 9",
+    "g1:line 2, column 3",
+    "g1:2"
+};
+const int PARSER_CHECK_COUNT = 5;
+
+//the allowed payments benchmark's random payments per player, on top of the
+//ring that lets everyone reach everyone, and the most players it settles
+const int ALLOWED_RANDOM_PAYMENTS = 9;
+const int ALLOWED_MAX_PLAYERS = 100000;
+
+//small games the allowed payments benchmark checks first, each with the
+//payments the fewest payments objective should settle it with, and how many
+//of them should pair a loser off with a winner
+struct AllowedCheck{
+    int players;
+    long long balances[6];
+    int allowed;
+    int payers[6];
+    int payees[6];
+    int payments;
+    int pairedPayments;
+};
+const AllowedCheck ALLOWED_CHECKS[] = {
+    //0 and 1 pair off, and are the only path from 2 to 3
+    {4, {10, -10, 5, -5}, 3, {0, 2, 1}, {1, 0, 3}, 3, 1},
+    //two pairs, 0 and 1, and 2 and 3, are the only path from 4 to 5
+    {6, {10, -10, 20, -20, 5, -5}, 5, {0, 2, 4, 1, 3}, {1, 3, 0, 2, 5}, 5, 2},
+    //pairing 0 off with 1 would leave 3 with no way to pay 2
+    {4, {10, -10, -10, 10}, 3, {0, 0, 3}, {1, 2, 1}, 2, 0}
+};
+const int ALLOWED_CHECK_COUNT = 3;
+
+//the quality benchmark's table sizes, solved exactly up to the largest
+//small size and bounded from below at the large ones, the tables it makes
+//of each small size, and about how many players it settles at each large one
+const int QUALITY_SMALL_SIZES[] = {4, 6, 8, 10, 12, 14, 16, 18};
+const int QUALITY_SMALL_SIZE_COUNT = 8;
+const int QUALITY_LARGE_SIZES[] = {100, 1000, 10000, 100000};
+const int QUALITY_LARGE_SIZE_COUNT = 4;
+const int QUALITY_EXACT_TABLES = 200;
+const int QUALITY_BOUND_PLAYERS = 1000000;
+
+//gaps of 0 up to QUALITY_GAP_BUCKETS - 2 payments are counted on their own,
+//and the last bucket counts every larger gap
+const int QUALITY_GAP_BUCKETS = 5;
+
+struct BenchResult{
+    std::string distribution;
+    int players;
+    int iterations;
+    double nsPerPlayer;
+    long allocations;
+    long peakRssSoFarKb;        //of the process, over this and every
+                                //earlier run
+    int transactions;
+    int pairedPayments;
+    int unpairedTransactions;   //transactions without the exact match pass
+};
+
+struct LiveResult{
+    int players;
+    int moves;
+    double usPerPreview;
+    int payments;
+    int freshPayments;
+};
+
+struct ReadResult{
+    int players;
+    long calls;
+    double nsPerCall;
+    long allocations;
+};
+
+struct WriterResult{
+    std::string format;
+    int players;
+    int payments;
+    long bytes;
+    double mbPerSecond;
+};
+
+struct ParserResult{
+    int rows;
+    int names;              //how many names the players are drawn from
+    int games;
+    long bytes;
+    double mbPerSecond;
+    double nsPerRow;
+    bool valid;             //every game was read without an error
+};
+
+struct AllowedResult{
+    int players;
+    int allowed;
+    SettlementObjective objective;
+    double ms;
+    int payments;
+    int pairedPayments;
+    bool settled;           //settled, and only with allowed payments
+};
+
+struct KernelResult{
+    int players;
+    KernelLevel level;
+    double balancesNs;      //per player, for each pass
+    double checkNs;
+    double partitionNs;
+    double speedup;         //of all three passes over the plain loops
+    bool matchesScalar;     //same balances, winners and losers
+};
+
+struct ClubResult{
+    long seats;
+    int tables;
+    int players;
+    double nsPerSeat;
+    int clubPayments;
+    long tablePayments;     //settling every table on its own
+};
+
+struct QualityResult{
+    std::string distribution;
+    int players;
+    int tables;
+    bool exact;             //compared with the exact solver, not a bound
+    double payments;        //per table, from the solver
+    double reference;       //per table, the fewest possible or a bound
+    int maxGap;
+    long gaps[QUALITY_GAP_BUCKETS];
+    double solverUs;        //per table
+    double exactUs;         //per table, if exact
+    bool consistent;        //solver >= exact >= bound on every table
+};
+
+struct SessionResult{
+    int events;
+    int players;
+    double nsPerEvent;
+    double recoveryMs;
+    long eventsReplayed;
+    bool recovered;     //the rebuilt game matches the one that was logged
+};
+
+
+/*******************************************************************************
+ *                        spreadCorrection(balances)
+ * Description: Makes the balances sum to 0 by spreading the difference evenly
+ *              over every player, rather than dumping it on one player and
+ *              distorting the distribution.
+*******************************************************************************/
+void spreadCorrection(std::vector<long long>& balances){
+    long long sum = 0;
+    for(int i = 0; i < balances.size(); ++i){
+        sum += balances[i];
+    }
+
+    long long count = balances.size();
+    long long share = -sum / count;
+    long long remainder = -sum - share * count;
+    for(int i = 0; i < balances.size(); ++i){
+        balances[i] += share;
+    }
+    for(long long i = 0; i < std::llabs(remainder); ++i){
+        balances[i] += (remainder > 0 ? 1 : -1);
+    }
+}
+
+
+/*******************************************************************************
+ *              generateBalances(distribution, players, rng)
+ * Description: Generates a set of balances that sum to 0. Positive balances
+ *              are owed by the player, negative balances are owed to them.
+ *              - uniform: every balance uniform in [-200, 200]
+ *              - heavy-tailed: Pareto sized balances with random signs, so a
+ *                few players win or lose far more than the rest
+ *              - one-big-winner: everyone loses up to 200 to one player
+ *              - exact-pairs: every loser owes exactly what one winner is owed
+ *              The ranges are small enough that a game's purse still fits in
+ *              an int at 10,000,000 players.
+*******************************************************************************/
+std::vector<long long> generateBalances(const std::string& distribution,
+                                        int players, std::mt19937_64& rng){
+    std::vector<long long> balances(players);
+
+    if(distribution == "uniform"){
+        std::uniform_int_distribution<long long> amount(-200, 200);
+        for(int i = 0; i < players; ++i){
+            balances[i] = amount(rng);
+        }
+        spreadCorrection(balances);
+    }
+    else if(distribution == "heavy-tailed"){
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        for(int i = 0; i < players; ++i){
+            //Pareto with alpha = 1.2 and a minimum of 10, capped at the
+            //largest stack a player can end with
+            double size = 10.0 / std::pow(1.0 - unit(rng), 1.0 / 1.2);
+            if(size > MAX_STACK){
+                size = MAX_STACK;
+            }
+            balances[i] = (long long)size * (unit(rng) < 0.5 ? 1 : -1);
+        }
+        spreadCorrection(balances);
+    }
+    else if(distribution == "one-big-winner"){
+        std::uniform_int_distribution<long long> amount(1, 200);
+        long long pot = 0;
+        for(int i = 1; i < players; ++i){
+            balances[i] = amount(rng);
+            pot += balances[i];
+        }
+        balances[0] = -pot;
+    }
+    else{
+        std::uniform_int_distribution<long long> amount(1, 200);
+        for(int i = 0; i + 1 < players; i += 2){
+            balances[i] = amount(rng);
+            balances[i + 1] = -balances[i];
+        }
+        std::shuffle(balances.begin(), balances.end(), rng);
+    }
+
+    return balances;
+}
+
+
+/*******************************************************************************
+ *                          solverName(SolverType)
+ * Description: returns the name the --solver option uses for a solver
+*******************************************************************************/
+const char* solverName(SolverType solver){
+    if(solver == EXACT_SOLVER){
+        return "exact";
+    }
+    if(solver == BUCKET_SOLVER){
+        return "bucket";
+    }
+    return "greedy";
+}
+
+
+/*******************************************************************************
+ *                    buildGame(balances)
+ * Description: Makes a Game with one player per balance. Losers buy in for
+ *              what they lose and end with nothing, and winners buy in for
+ *              nothing and end with what they win.
+*******************************************************************************/
+Game* buildGame(const std::vector<long long>& balances){
+    Game* game = new Game;
+    for(int i = 0; i < balances.size(); ++i){
+        long long buyIn = balances[i] > 0 ? balances[i] : 0;
+        game->addPlayer("p" + std::to_string(i), buyIn, buyIn - balances[i]);
+    }
+    return game;
+}
+
+
+/*******************************************************************************
+ *                      runBenchmark(distribution, players, ...)
+ * Description: Times building and solving a PlayerGraph for one generated
+ *              game, repeating small games until enough time has been
+ *              measured.
+*******************************************************************************/
+BenchResult runBenchmark(const std::string& distribution, int players,
+                         SolverType solver, std::mt19937_64& rng){
+    std::vector<long long> balances = generateBalances(distribution, players,
+                                                       rng);
+    Game* game = buildGame(balances);
+
+    BenchResult result;
+    result.distribution = distribution;
+    result.players = players;
+    result.iterations = 0;
+    result.allocations = 0;
+    result.transactions = 0;
+
+    double measured = 0.0;
+    while(measured < MIN_MEASURED_SECONDS || result.iterations == 0){
+        long allocationsBefore = allocationCount;
+        std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+
+        PlayerGraph graph(game);
+        graph.solve(solver);
+
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+        measured += elapsed.count();
+        result.allocations = allocationCount - allocationsBefore;
+        result.transactions = graph.getEdgeCount();
+        result.pairedPayments = graph.getPairedPayments();
+        result.iterations++;
+    }
+    //solve it once more without the exact match pass, to show what it saves
+    PlayerGraph unpaired(game);
+    unpaired.setExactMatchPairing(false);
+    unpaired.solve(solver);
+    result.unpairedTransactions = unpaired.getEdgeCount();
+    delete game;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    result.peakRssSoFarKb = usage.ru_maxrss;
+    result.nsPerPlayer = measured * 1e9 / result.iterations / players;
+    return result;
+}
+
+
+/*******************************************************************************
+ *                       runLiveBenchmark(players, rng)
+ * Description: Starts a live settlement of a uniform game, then repeatedly
+ *              moves chips from one random player to another and repairs the
+ *              settlement, timing the repairs. The final settlement's size is
+ *              compared with a fresh solve of the same game.
+*******************************************************************************/
+LiveResult runLiveBenchmark(int players, std::mt19937_64& rng){
+    std::vector<long long> balances = generateBalances("uniform", players,
+                                                       rng);
+    Game* game = buildGame(balances);
+    game->startLiveSettlement();
+    LiveSettlement* live = game->getLiveSettlement();
+    live->repair();
+
+    std::uniform_int_distribution<int> pickPlayer(0, players - 1);
+    std::uniform_int_distribution<int> pickAmount(1, 200);
+    double measured = 0.0;
+
+    for(int move = 0; move < LIVE_MOVES; ++move){
+        int from = pickPlayer(rng);
+        int to = pickPlayer(rng);
+        Amount fromStack = game->getPlayer(from)->getFinalStack();
+        Amount amount = std::min((Amount)pickAmount(rng), fromStack);
+
+        std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+
+        game->setFinalStack(from, fromStack - amount);
+        game->setFinalStack(to, game->getPlayer(to)->getFinalStack() + amount);
+        live->repair();
+
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+        measured += elapsed.count();
+    }
+
+    LiveResult result;
+    result.players = players;
+    result.moves = LIVE_MOVES;
+    result.usPerPreview = measured * 1e6 / LIVE_MOVES;
+    result.payments = live->getPaymentCount();
+
+    PlayerGraph graph(game);
+    graph.solveGraph();
+    result.freshPayments = graph.getEdgeCount();
+
+    delete game;
+    return result;
+}
+
+
+/*******************************************************************************
+ *                        runLiveBenchmarks(...)
+ * Description: Runs the live settlement benchmark at each size and prints the
+ *              results as JSON.
+*******************************************************************************/
+void runLiveBenchmarks(int seed, int minPlayers, int maxPlayers){
+    std::vector<LiveResult> results;
+    for(long long players = 10; players <= maxPlayers; players *= 10){
+        if(players < minPlayers){
+            continue;
+        }
+
+        std::mt19937_64 rng(seed + players);
+        LiveResult result = runLiveBenchmark(players, rng);
+        results.push_back(result);
+        std::cerr << "live " << players << " players: "
+                  << result.usPerPreview << " us/preview, "
+                  << result.payments << " payments (fresh solve "
+                  << result.freshPayments << ")" << std::endl;
+    }
+
+    std::printf("{\n  \"benchmark\": \"LiveSettlement::repair\",\n");
+    std::printf("  \"amount_bits\": %d,\n", POKERCALC_AMOUNT_BITS);
+    std::printf("  \"seed\": %d,\n  \"results\": [\n", seed);
+    for(int i = 0; i < results.size(); ++i){
+        const LiveResult& result = results[i];
+        std::printf("    {\"players\": %d, \"moves\": %d, "
+                    "\"us_per_preview\": %.3f, \"payments\": %d, "
+                    "\"fresh_payments\": %d}%s\n",
+                    result.players, result.moves, result.usPerPreview,
+                    result.payments, result.freshPayments,
+                    i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+}
+
+
+/*******************************************************************************
+ *                       runReadBenchmark(players, rng)
+ * Description: Builds and solves a uniform game, then walks every read path
+ *              the settlement printers use, once per player and payment,
+ *              counting the allocations and timing the calls. The names are
+ *              long enough that copying one would allocate. The lengths
+ *              read are summed so the calls can't be optimized away.
+*******************************************************************************/
+ReadResult runReadBenchmark(int players, std::mt19937_64& rng){
+    std::vector<long long> balances = generateBalances("uniform", players,
+                                                       rng);
+    Game* game = buildGame(balances);
+    //names too long for the short string optimization, so any copy of a
+    //name would show up as an allocation
+    for(int i = 0; i < players; ++i){
+        game->getPlayer(i)->setName("read-benchmark-" + std::to_string(i));
+    }
+    PlayerGraph graph(game);
+    graph.solveGraph();
+
+    ReadResult result;
+    result.players = players;
+    result.calls = 0;
+    size_t checksum = 0;
+    long allocationsBefore = allocationCount;
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
+    const std::vector<std::unique_ptr<Player> >& roster = game->getPlayers();
+    result.calls++;
+    for(int i = 0; i < roster.size(); ++i){
+        checksum += roster[i]->getName().size();
+        checksum += game->getPlayer(i)->getName().size();
+        result.calls += 2;
+    }
+
+    const std::vector<int>& offsets = graph.getEdgeOffsets();
+    const std::vector<int>& payees = graph.getEdgePayees();
+    const std::vector<Amount>& amounts = graph.getEdgeAmounts();
+    result.calls += 3;
+    size_t length;
+    for(int i = 0; i < graph.getNodeCount(); ++i){
+        checksum += graph.getPlayer(i)->getName().size();
+        graph.getPlayerName(i, length);
+        checksum += length;
+        result.calls += 2;
+        for(int j = offsets[i]; j < offsets[i + 1]; ++j){
+            graph.getPlayerName(payees[j], length);
+            checksum += length + (size_t)amounts[j];
+            result.calls++;
+        }
+    }
+
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    result.allocations = allocationCount - allocationsBefore;
+    result.nsPerCall = elapsed.count() * 1e9 / result.calls;
+    if(checksum == 0){
+        std::cerr << "read benchmark read nothing" << std::endl;
+    }
+
+    delete game;
+    return result;
+}
+
+
+/*******************************************************************************
+ *                        runReadBenchmarks(...)
+ * Description: Runs the read path benchmark at each size and prints the
+ *              results as JSON.
+*******************************************************************************/
+void runReadBenchmarks(int seed, int minPlayers, int maxPlayers){
+    std::vector<ReadResult> results;
+    for(long long players = 10; players <= maxPlayers; players *= 10){
+        if(players < minPlayers){
+            continue;
+        }
+
+        std::mt19937_64 rng(seed + players);
+        ReadResult result = runReadBenchmark(players, rng);
+        results.push_back(result);
+        std::cerr << "reads " << players << " players: "
+                  << result.nsPerCall << " ns/call, "
+                  << result.allocations << " allocations" << std::endl;
+    }
+
+    std::printf("{\n  \"benchmark\": \"read paths\",\n");
+    std::printf("  \"seed\": %d,\n  \"results\": [\n", seed);
+    for(int i = 0; i < results.size(); ++i){
+        const ReadResult& result = results[i];
+        std::printf("    {\"players\": %d, \"calls\": %ld, "
+                    "\"ns_per_call\": %.2f, \"allocations\": %ld, "
+                    "\"allocations_per_call\": %.3f}%s\n",
+                    result.players, result.calls, result.nsPerCall,
+                    result.allocations,
+                    (double)result.allocations / result.calls,
+                    i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+}
+
+
+/*******************************************************************************
+ *                 runWriterBenchmarks(seed, minPlayers, maxPlayers)
+ * Description: Solves a uniform game at each size, then writes its payments
+ *              to /dev/null in every output format, repeating small games
+ *              until enough time has been measured, and prints the results
+ *              as JSON.
+*******************************************************************************/
+void runWriterBenchmarks(int seed, int minPlayers, int maxPlayers){
+    std::vector<WriterResult> results;
+    std::ofstream sink("/dev/null");
+    for(long long players = 10; players <= maxPlayers; players *= 10){
+        if(players < minPlayers){
+            continue;
+        }
+
+        std::mt19937_64 rng(seed + players);
+        std::vector<long long> balances = generateBalances("uniform", players,
+                                                           rng);
+        Game* game = buildGame(balances);
+        PlayerGraph graph(game);
+        graph.solveGraph();
+
+        for(int f = 0; f < WRITER_FORMAT_COUNT; ++f){
+            OutputFormat format;
+            parseOutputFormat(WRITER_FORMATS[f], format);
+
+            WriterResult result;
+            result.format = WRITER_FORMATS[f];
+            result.players = players;
+            result.payments = graph.getEdgeCount();
+            result.bytes = 0;
+            double measured = 0.0;
+            int iterations = 0;
+            while(measured < MIN_MEASURED_SECONDS || iterations == 0){
+                std::chrono::steady_clock::time_point start =
+                    std::chrono::steady_clock::now();
+
+                SettlementWriter writer(sink, format);
+                writer.writeGraph(graph);
+                writer.finish();
+
+                std::chrono::duration<double> elapsed =
+                    std::chrono::steady_clock::now() - start;
+                measured += elapsed.count();
+                result.bytes = writer.getBytesWritten();
+                iterations++;
+            }
+            result.mbPerSecond = result.bytes * (double)iterations /
+                                 measured / 1e6;
+            results.push_back(result);
+            std::cerr << "writer " << result.format << " " << players
+                      << " players: " << result.mbPerSecond << " MB/s"
+                      << std::endl;
+        }
+        delete game;
+    }
+
+    std::printf("{\n  \"benchmark\": \"SettlementWriter\",\n");
+    std::printf("  \"seed\": %d,\n  \"results\": [\n", seed);
+    for(int i = 0; i < results.size(); ++i){
+        const WriterResult& result = results[i];
+        std::printf("    {\"format\": \"%s\", \"players\": %d, "
+                    "\"payments\": %d, \"bytes\": %ld, "
+                    "\"mb_per_s\": %.1f}%s\n",
+                    result.format.c_str(), result.players, result.payments,
+                    result.bytes, result.mbPerSecond,
+                    i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+}
+
+
+/*******************************************************************************
+ *                 runKernelBenchmarks(seed, minPlayers, maxPlayers)
+ * Description: Makes the records of a uniform binary ledger at each size, the
+ *              way BinaryLedger::write() lays them out, then for each kernel
+ *              level works out the balances, adds them up and partitions
+ *              them, repeating small ledgers until enough time has been
+ *              measured. Each level's results are checked against the plain
+ *              loops', and the results are printed as JSON.
+*******************************************************************************/
+void runKernelBenchmarks(int seed, int minPlayers, int maxPlayers){
+    std::vector<KernelResult> results;
+    KernelLevel supported = AmountKernels::getSupportedLevel();
+    for(long long players = 10; players <= maxPlayers; players *= 10){
+        if(players < minPlayers){
+            continue;
+        }
+
+        std::mt19937_64 rng(seed + players);
+        std::vector<long long> generated = generateBalances("uniform",
+                                                            players, rng);
+        std::vector<LedgerFileRecord> records(players);
+        for(int i = 0; i < players; ++i){
+            records[i].id = i;
+            records[i].reserved = 0;
+            records[i].buyIn = generated[i] > 0 ? generated[i] : 0;
+            records[i].finalStack = records[i].buyIn - generated[i];
+        }
+
+        std::vector<Amount> balances(players);
+        std::vector<int> winners;
+        std::vector<int> losers;
+        std::vector<Amount> scalarBalances;
+        std::vector<int> scalarWinners;
+        std::vector<int> scalarLosers;
+        double scalarNs = 0.0;
+        for(int level = SCALAR_KERNELS; level <= supported; ++level){
+            AmountKernels::setLevel((KernelLevel)level);
+            KernelResult result;
+            result.players = players;
+            result.level = (KernelLevel)level;
+
+            double measured[3] = {0.0, 0.0, 0.0};
+            int iterations = 0;
+            bool balanced = true;
+            while(measured[0] + measured[1] + measured[2] <
+                  MIN_MEASURED_SECONDS || iterations == 0){
+                std::chrono::steady_clock::time_point start =
+                    std::chrono::steady_clock::now();
+                AmountKernels::ledgerBalances(records.data(), players,
+                                              balances.data());
+                std::chrono::steady_clock::time_point computed =
+                    std::chrono::steady_clock::now();
+                balanced = balanced &&
+                    AmountKernels::sumAmounts(balances.data(), players) == 0;
+                std::chrono::steady_clock::time_point checked =
+                    std::chrono::steady_clock::now();
+                AmountKernels::partitionBalances(balances.data(), players,
+                                                 winners, losers);
+                std::chrono::steady_clock::time_point partitioned =
+                    std::chrono::steady_clock::now();
+
+                measured[0] += std::chrono::duration<double>(
+                    computed - start).count();
+                measured[1] += std::chrono::duration<double>(
+                    checked - computed).count();
+                measured[2] += std::chrono::duration<double>(
+                    partitioned - checked).count();
+                iterations++;
+            }
+
+            double perPlayer = 1e9 / ((double)iterations * players);
+            result.balancesNs = measured[0] * perPlayer;
+            result.checkNs = measured[1] * perPlayer;
+            result.partitionNs = measured[2] * perPlayer;
+            double totalNs = result.balancesNs + result.checkNs +
+                             result.partitionNs;
+            if(level == SCALAR_KERNELS){
+                scalarNs = totalNs;
+                scalarBalances = balances;
+                scalarWinners = winners;
+                scalarLosers = losers;
+            }
+            result.speedup = scalarNs / totalNs;
+            result.matchesScalar = balanced && balances == scalarBalances &&
+                                   winners == scalarWinners &&
+                                   losers == scalarLosers;
+            results.push_back(result);
+            std::cerr << "kernels " << AmountKernels::getLevelName(
+                             result.level)
+                      << " " << players << " players: " << totalNs
+                      << " ns/player, " << result.speedup << "x"
+                      << (result.matchesScalar ? "" : ", WRONG RESULTS")
+                      << std::endl;
+        }
+        AmountKernels::setLevel(supported);
+    }
+
+    std::printf("{\n  \"benchmark\": \"AmountKernels\",\n");
+    std::printf("  \"amount_bits\": %d,\n", POKERCALC_AMOUNT_BITS);
+    std::printf("  \"seed\": %d,\n  \"results\": [\n", seed);
+    for(int i = 0; i < results.size(); ++i){
+        const KernelResult& result = results[i];
+        std::printf("    {\"players\": %d, \"level\": \"%s\", "
+                    "\"balances_ns_per_player\": %.3f, "
+                    "\"check_ns_per_player\": %.3f, "
+                    "\"partition_ns_per_player\": %.3f, "
+                    "\"speedup\": %.2f, \"matches_scalar\": %s}%s\n",
+                    result.players, AmountKernels::getLevelName(result.level),
+                    result.balancesNs, result.checkNs, result.partitionNs,
+                    result.speedup, result.matchesScalar ? "true" : "false",
+                    i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+}
+
+
+/*******************************************************************************
+ *                     runClubBenchmark(seats, rng)
+ * Description: Makes a club night of uniform eight seat tables whose seats
+ *              are drawn from a pool of a third as many players, nets and
+ *              settles it with a ClubSettler, then settles every table on its
+ *              own to compare.
+*******************************************************************************/
+ClubResult runClubBenchmark(long seats, std::mt19937_64& rng){
+    ClubResult result;
+    result.seats = seats;
+    result.tables = seats / CLUB_BENCH_TABLE_SEATS;
+    int poolSize = seats / CLUB_BENCH_SEATS_PER_PLAYER;
+    std::uniform_int_distribution<int> pickPlayer(0, poolSize - 1);
+
+    ClubSettler settler(1);
+    result.tablePayments = 0;
+    for(int t = 0; t < result.tables; ++t){
+        std::vector<long long> balances =
+            generateBalances("uniform", CLUB_BENCH_TABLE_SEATS, rng);
+        LedgerGame table;
+        table.gameId = "t" + std::to_string(t);
+        table.game = new Game;
+        table.firstLine = t * CLUB_BENCH_TABLE_SEATS + 1;
+        for(int i = 0; i < balances.size(); ++i){
+            long long buyIn = balances[i] > 0 ? balances[i] : 0;
+            table.game->addPlayer("p" + std::to_string(pickPlayer(rng)),
+                                  buyIn, buyIn - balances[i]);
+        }
+
+        GameSettlement alone;
+        ParallelSettler::settleGame(table, GREEDY_SOLVER, alone);
+        result.tablePayments += alone.payments.size();
+        settler.addTable(table);
+    }
+
+    std::string error;
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    if(!settler.settle("club", error)){
+        std::cerr << "club not settled: " << error << std::endl;
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    result.players = settler.getClub().getPlayerCount();
+    result.nsPerSeat = elapsed.count() * 1e9 / seats;
+    result.clubPayments = settler.getPayments().size();
+    return result;
+}
+
+
+/*******************************************************************************
+ *                 runClubBenchmarks(seed, minPlayers, maxPlayers)
+ * Description: Runs the club benchmark at each size, taking the player
+ *              limits as limits on the seats, and prints the results as JSON.
+*******************************************************************************/
+void runClubBenchmarks(int seed, int minPlayers, int maxPlayers){
+    std::vector<ClubResult> results;
+    for(long seats = 1000; seats <= maxPlayers &&
+        seats <= CLUB_BENCH_MAX_SEATS; seats *= 10){
+        if(seats < minPlayers){
+            continue;
+        }
+
+        std::mt19937_64 rng(seed + seats);
+        ClubResult result = runClubBenchmark(seats, rng);
+        results.push_back(result);
+        std::cerr << "club " << seats << " seats: " << result.nsPerSeat
+                  << " ns/seat, " << result.clubPayments << " payments ("
+                  << result.tablePayments << " table by table)" << std::endl;
+    }
+
+    std::printf("{\n  \"benchmark\": \"ClubSettler\",\n");
+    std::printf("  \"seed\": %d,\n  \"results\": [\n", seed);
+    for(int i = 0; i < results.size(); ++i){
+        const ClubResult& result = results[i];
+        std::printf("    {\"seats\": %ld, \"tables\": %d, "
+                    "\"players\": %d, \"ns_per_seat\": %.1f, "
+                    "\"club_payments\": %d, \"table_payments\": %ld}%s\n",
+                    result.seats, result.tables, result.players,
+                    result.nsPerSeat, result.clubPayments,
+                    result.tablePayments,
+                    i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+}
+
+
+/*******************************************************************************
+ *                     generateHiddenGroups(players, rng)
+ * Description: Generates balances that split into zero-sum groups of three to
+ *              five players, each with one or more losers whose losses are
+ *              shared out among the group's winners, shuffled together. Such
+ *              a table can be settled in players - groups payments, but no
+ *              balance gives the groups away.
+*******************************************************************************/
+std::vector<long long> generateHiddenGroups(int players,
+                                            std::mt19937_64& rng){
+    std::vector<long long> balances;
+    std::uniform_int_distribution<long long> amount(1, 200);
+    int left = players;
+    while(left > 0){
+        //no group may be left with fewer than three players
+        int size = left;
+        if(left > 5){
+            size = std::uniform_int_distribution<int>(3, 5)(rng);
+            size = left - size < 3 ? 3 : size;
+        }
+        int losers = std::uniform_int_distribution<int>(1, size - 1)(rng);
+        int winners = size - losers;
+
+        long long lost = 0;
+        for(int i = 0; i < losers; ++i){
+            balances.push_back(amount(rng));
+            lost += balances.back();
+        }
+
+        //cut the losses at winners - 1 distinct points, so every winner is
+        //owed at least 1
+        if(lost < winners){
+            balances[balances.size() - losers] += winners - lost;
+            lost = winners;
+        }
+        std::vector<long long> cuts;
+        while(cuts.size() < winners - 1){
+            long long cut = std::uniform_int_distribution<long long>(
+                1, lost - 1)(rng);
+            if(std::find(cuts.begin(), cuts.end(), cut) == cuts.end()){
+                cuts.push_back(cut);
+            }
+        }
+        std::sort(cuts.begin(), cuts.end());
+        cuts.push_back(lost);
+        long long previous = 0;
+        for(int i = 0; i < winners; ++i){
+            balances.push_back(previous - cuts[i]);
+            previous = cuts[i];
+        }
+        left -= size;
+    }
+
+    std::shuffle(balances.begin(), balances.end(), rng);
+    return balances;
+}
+
+
+/*******************************************************************************
+ *                      paymentLowerBound(balances)
+ * Description: returns a lower bound on the fewest payments that settle the
+ *              balances. A settlement of n players with non-zero balances
+ *              that splits them into k zero-sum groups takes n - k payments.
+ *              A group of two is an equal and opposite pair, and there are at
+ *              most P disjoint ones, so k <= P + (n - 2P) / 3. Every loser
+ *              also makes a payment and every winner receives one.
+*******************************************************************************/
+long paymentLowerBound(const std::vector<long long>& balances){
+    std::vector<long long> losses;
+    std::vector<long long> wins;
+    for(int i = 0; i < balances.size(); ++i){
+        if(balances[i] > 0){
+            losses.push_back(balances[i]);
+        }
+        else if(balances[i] < 0){
+            wins.push_back(-balances[i]);
+        }
+    }
+    std::sort(losses.begin(), losses.end());
+    std::sort(wins.begin(), wins.end());
+
+    //each loss pairs off with a win of the same size
+    long pairs = 0;
+    int w = 0;
+    for(int l = 0; l < losses.size(); ++l){
+        while(w < wins.size() && wins[w] < losses[l]){
+            ++w;
+        }
+        if(w < wins.size() && wins[w] == losses[l]){
+            ++pairs;
+            ++w;
+        }
+    }
+
+    long players = losses.size() + wins.size();
+    long groups = pairs + (players - 2 * pairs) / 3;
+    return std::max(players - groups,
+                    (long)std::max(losses.size(), wins.size()));
+}
+
+
+/*******************************************************************************
+ *        runQualityBenchmark(distribution, players, tables, exact, ...)
+ * Description: Settles the given number of generated tables with the solver,
+ *              and with the exact solver if exact is true or a lower bound
+ *              otherwise, and tallies how many more payments the solver made.
+*******************************************************************************/
+QualityResult runQualityBenchmark(const std::string& distribution,
+                                  int players, int tables, bool exact,
+                                  SolverType solver, std::mt19937_64& rng){
+    QualityResult result;
+    result.distribution = distribution;
+    result.players = players;
+    result.tables = tables;
+    result.exact = exact;
+    result.maxGap = 0;
+    result.consistent = true;
+    std::fill(result.gaps, result.gaps + QUALITY_GAP_BUCKETS, 0);
+
+    long payments = 0;
+    long reference = 0;
+    double solverSeconds = 0.0;
+    double exactSeconds = 0.0;
+    for(int t = 0; t < tables; ++t){
+        std::vector<long long> balances =
+            distribution == "hidden-groups" ?
+            generateHiddenGroups(players, rng) :
+            generateBalances(distribution, players, rng);
+        Game* game = buildGame(balances);
+        long bound = paymentLowerBound(balances);
+
+        std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+        PlayerGraph graph(game);
+        graph.solve(solver);
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+        solverSeconds += elapsed.count();
+        long made = graph.getEdgeCount();
+
+        long fewest = bound;
+        if(exact){
+            start = std::chrono::steady_clock::now();
+            PlayerGraph exactGraph(game);
+            bool solved = exactGraph.solveGraphExact();
+            elapsed = std::chrono::steady_clock::now() - start;
+            exactSeconds += elapsed.count();
+            fewest = exactGraph.getEdgeCount();
+            result.consistent = result.consistent && solved &&
+                                fewest >= bound;
+        }
+        delete game;
+
+        long gap = made - fewest;
+        result.consistent = result.consistent && gap >= 0;
+        result.maxGap = std::max(result.maxGap, (int)gap);
+        result.gaps[std::min(std::max(gap, 0L),
+                             (long)QUALITY_GAP_BUCKETS - 1)]++;
+        payments += made;
+        reference += fewest;
+    }
+
+    result.payments = (double)payments / tables;
+    result.reference = (double)reference / tables;
+    result.solverUs = solverSeconds * 1e6 / tables;
+    result.exactUs = exactSeconds * 1e6 / tables;
+    return result;
+}
+
+
+/*******************************************************************************
+ *     runQualityBenchmarks(seed, minPlayers, maxPlayers, solver, only)
+ * Description: Runs the quality benchmark for every distribution, or only the
+ *              one given, at each size within the limits, and prints the
+ *              results as JSON.
+*******************************************************************************/
+void runQualityBenchmarks(int seed, int minPlayers, int maxPlayers,
+                          SolverType solver,
+                          const std::string& onlyDistribution){
+    std::vector<std::string> distributions(DISTRIBUTIONS,
+                                           DISTRIBUTIONS + DISTRIBUTION_COUNT);
+    distributions.push_back("hidden-groups");
+
+    std::vector<QualityResult> results;
+    for(int d = 0; d < distributions.size(); ++d){
+        if(!onlyDistribution.empty() && onlyDistribution != distributions[d]){
+            continue;
+        }
+
+        for(int s = 0; s < QUALITY_SMALL_SIZE_COUNT + QUALITY_LARGE_SIZE_COUNT;
+            ++s){
+            bool exact = s < QUALITY_SMALL_SIZE_COUNT;
+            int players = exact ? QUALITY_SMALL_SIZES[s] :
+                          QUALITY_LARGE_SIZES[s - QUALITY_SMALL_SIZE_COUNT];
+            if(players < minPlayers || players > maxPlayers){
+                continue;
+            }
+            int tables = exact ? QUALITY_EXACT_TABLES :
+                         std::max(1, QUALITY_BOUND_PLAYERS / players);
+
+            std::mt19937_64 rng(seed + d * 1000003LL + players);
+            QualityResult result = runQualityBenchmark(distributions[d],
+                                                       players, tables, exact,
+                                                       solver, rng);
+            results.push_back(result);
+            std::cerr << "quality " << result.distribution << " " << players
+                      << " players: " << result.payments << " payments, "
+                      << result.reference
+                      << (exact ? " fewest" : " lower bound") << ", "
+                      << result.gaps[0] << "/" << tables << " tables "
+                      << (exact ? "optimal" : "at the bound")
+                      << (result.consistent ? "" : ", WRONG RESULTS")
+                      << std::endl;
+        }
+    }
+
+    std::printf("{\n  \"benchmark\": \"SolutionQuality\",\n");
+    std::printf("  \"solver\": \"%s\",\n", solverName(solver));
+    std::printf("  \"seed\": %d,\n  \"results\": [\n", seed);
+    for(int i = 0; i < results.size(); ++i){
+        const QualityResult& result = results[i];
+        std::printf("    {\"distribution\": \"%s\", \"players\": %d, "
+                    "\"tables\": %d, \"reference\": \"%s\", "
+                    "\"payments\": %.3f, \"reference_payments\": %.3f, "
+                    "\"gap_histogram\": [",
+                    result.distribution.c_str(), result.players,
+                    result.tables, result.exact ? "exact" : "lower-bound",
+                    result.payments, result.reference);
+        for(int b = 0; b < QUALITY_GAP_BUCKETS; ++b){
+            std::printf("%s%ld", b > 0 ? ", " : "", result.gaps[b]);
+        }
+        std::printf("], \"max_gap\": %d, \"solver_us_per_table\": %.2f, ",
+                    result.maxGap, result.solverUs);
+        if(result.exact){
+            std::printf("\"exact_us_per_table\": %.2f, ", result.exactUs);
+        }
+        else{
+            std::printf("\"exact_us_per_table\": null, ");
+        }
+        std::printf("\"consistent\": %s}%s\n",
+                    result.consistent ? "true" : "false",
+                    i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+}
+
+
+/*******************************************************************************
+ *                      runSessionBenchmark(events, rng)
+ * Description: Plays a game of the given number of changes with a session
+ *              log running: one change in ten adds a player, and the rest are
+ *              buy-ins and final stacks for random players. Then the game is
+ *              rebuilt from the log, as it would be after a crash, and
+ *              checked against the original.
+*******************************************************************************/
+SessionResult runSessionBenchmark(int events, std::mt19937_64& rng){
+    std::remove(SESSION_BENCH_LOG);
+    std::remove((std::string(SESSION_BENCH_LOG) + ".snapshot").c_str());
+
+    SessionResult result;
+    result.events = events;
+    std::string error;
+    std::uniform_int_distribution<int> pickAmount(1, 200);
+    std::uniform_int_distribution<int> pickChange(0, 9);
+
+    Game* game = new Game;
+    game->startSessionLog(SESSION_BENCH_LOG, error);
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    for(int i = 0; i < events; ++i){
+        int change = pickChange(rng);
+        if(change == 0 || game->getPlayerCount() == 0){
+            game->addPlayer("p" + std::to_string(i), pickAmount(rng));
+            continue;
+        }
+
+        std::uniform_int_distribution<int> pickPlayer(
+            0, game->getPlayerCount() - 1);
+        if(change < 6){
+            game->addBuyInToPlayer(pickPlayer(rng), pickAmount(rng));
+        }
+        else{
+            game->setFinalStack(pickPlayer(rng), pickAmount(rng));
+        }
+    }
+    game->getSessionLog()->commit();
+    std::chrono::duration<double> logging =
+        std::chrono::steady_clock::now() - start;
+
+    //a crash loses the Game but not the log
+    Game* recovered = new Game;
+    start = std::chrono::steady_clock::now();
+    result.recovered = recovered->startSessionLog(SESSION_BENCH_LOG, error);
+    std::chrono::duration<double, std::milli> recovery =
+        std::chrono::steady_clock::now() - start;
+
+    result.players = game->getPlayerCount();
+    result.nsPerEvent = logging.count() * 1e9 / events;
+    result.recoveryMs = recovery.count();
+    result.eventsReplayed = result.recovered ?
+        recovered->getSessionLog()->getEventsReplayed() : 0;
+    result.recovered = result.recovered &&
+        recovered->getPlayerCount() == game->getPlayerCount() &&
+        recovered->getTotalPurse() == game->getTotalPurse() &&
+        recovered->getTotalStacks() == game->getTotalStacks();
+
+    if(recovered->getSessionLog() != NULL){
+        recovered->getSessionLog()->finish();
+    }
+    delete recovered;
+    delete game;
+    std::remove(SESSION_BENCH_LOG);
+    std::remove((std::string(SESSION_BENCH_LOG) + ".snapshot").c_str());
+    return result;
+}
+
+
+/*******************************************************************************
+ *                          checkParserLedgers()
+ * Description: Reads each of the malformed check ledgers and returns whether
+ *              its games came out as they should: a row with too few or too
+ *              many fields spoils its own game, and no other.
+*******************************************************************************/
+bool checkParserLedgers(){
+    bool good = true;
+    for(int i = 0; i < PARSER_CHECK_COUNT; ++i){
+        std::istringstream input(PARSER_CHECK_LEDGERS[i]);
+        LedgerReader reader(input);
+        LedgerGame record;
+        std::string games;
+        while(reader.nextGame(record)){
+            if(!games.empty()){
+                games += "|";
+            }
+            games += record.gameId + ":";
+            if(record.error.empty()){
+                games += std::to_string(record.game->getPlayerCount());
+            }
+            else{
+                games += record.error.substr(0, record.error.find(": "));
+            }
+            delete record.game;
+        }
+        if(games != PARSER_CHECK_GAMES[i]){
+            std::cerr << "parser check " << i << " read " << games
+                      << " instead of " << PARSER_CHECK_GAMES[i] << std::endl;
+            good = false;
+        }
+    }
+    return good;
+}
+
+
+/*******************************************************************************
+ *               runParserBenchmark(rows, names, seed)
+ * Description: Writes a text ledger of eight seat tables into memory, with
+ *              the given number of rows and the players drawn from the given
+ *              number of names, then reads every game of it with a
+ *              LedgerReader, repeating small ledgers until enough time has
+ *              been measured.
+*******************************************************************************/
+ParserResult runParserBenchmark(int rows, int names, int seed){
+    std::mt19937_64 rng(seed + rows);
+    std::string ledger;
+    for(int row = 0; row < rows; ++row){
+        ledger += "table" + std::to_string(row / PARSER_TABLE_SEATS);
+        ledger += ",player" + std::to_string(rng() % names);
+        ledger += "," + std::to_string(rng() % 10000);
+        ledger += "," + std::to_string(rng() % 10000);
+        ledger += '\n';
+    }
+
+    ParserResult result;
+    result.rows = rows;
+    result.names = names;
+    result.bytes = ledger.size();
+    result.valid = true;
+    double measured = 0.0;
+    int iterations = 0;
+    while(measured < MIN_MEASURED_SECONDS || iterations == 0){
+        std::istringstream input(ledger);
+        std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+
+        LedgerReader reader(input);
+        LedgerGame record;
+        result.games = 0;
+        while(reader.nextGame(record)){
+            result.valid = result.valid && record.error.empty();
+            result.games++;
+            delete record.game;
+        }
+
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+        measured += elapsed.count();
+        iterations++;
+    }
+    result.mbPerSecond = result.bytes * (double)iterations / measured / 1e6;
+    result.nsPerRow = measured * 1e9 / iterations / rows;
+    return result;
+}
+
+
+/*******************************************************************************
+ *                 runParserBenchmarks(seed, minPlayers, maxPlayers)
+ * Description: Checks the malformed ledgers, then runs the parser benchmark
+ *              at each size, with names drawn from as many names as there are
+ *              rows and from a season's worth, and prints the results as
+ *              JSON. Returns false if the check failed.
+*******************************************************************************/
+bool runParserBenchmarks(int seed, int minPlayers, int maxPlayers){
+    std::vector<ParserResult> results;
+    bool checked = checkParserLedgers();
+
+    //every name read is kept in PlayerNames for good, so the season's names
+    //are read first, while they're the only ones there
+    for(int season = 1; season >= 0; --season){
+        for(long long rows = 1000;
+            rows <= std::min(maxPlayers, PARSER_MAX_ROWS); rows *= 10){
+            if(rows < minPlayers){
+                continue;
+            }
+
+            int names = season ? PARSER_SEASON_NAMES : rows;
+            ParserResult result = runParserBenchmark(rows, names, seed);
+            results.push_back(result);
+            std::cerr << "parser " << rows << " rows of " << names
+                      << " names: " << result.mbPerSecond << " MB/s"
+                      << std::endl;
+        }
+    }
+
+    std::printf("{\n  \"benchmark\": \"LedgerReader\",\n");
+    std::printf("  \"seed\": %d,\n  \"malformed_rows_ok\": %s,\n",
+                seed, checked ? "true" : "false");
+    std::printf("  \"results\": [\n");
+    for(int i = 0; i < results.size(); ++i){
+        const ParserResult& result = results[i];
+        std::printf("    {\"rows\": %d, \"names\": %d, \"games\": %d, "
+                    "\"bytes\": %ld, \"mb_per_s\": %.1f, "
+                    "\"ns_per_row\": %.1f, \"valid\": %s}%s\n",
+                    result.rows, result.names, result.games, result.bytes,
+                    result.mbPerSecond, result.nsPerRow,
+                    result.valid ? "true" : "false",
+                    i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+    return checked;
+}
+
+
+/*******************************************************************************
+ *         checkAllowedSettlement(balances, allowedPayers, allowedPayees,
+ *                                graph)
+ * Description: returns whether the graph's payments settle the balances,
+ *              every payment is positive and allowed, and there are fewer
+ *              payments than players.
+*******************************************************************************/
+bool checkAllowedSettlement(const std::vector<long long>& balances,
+                            const std::vector<int>& allowedPayers,
+                            const std::vector<int>& allowedPayees,
+                            const PlayerGraph& graph){
+    std::vector<std::pair<int, int> > allowed;
+    for(int i = 0; i < allowedPayers.size(); ++i){
+        allowed.push_back(std::make_pair(allowedPayers[i], allowedPayees[i]));
+    }
+    std::sort(allowed.begin(), allowed.end());
+
+    std::vector<long long> left(balances);
+    const std::vector<int>& offsets = graph.getEdgeOffsets();
+    const std::vector<int>& payees = graph.getEdgePayees();
+    const std::vector<Amount>& amounts = graph.getEdgeAmounts();
+    for(int payer = 0; payer < balances.size(); ++payer){
+        for(int e = offsets[payer]; e < offsets[payer + 1]; ++e){
+            if(amounts[e] <= 0 ||
+               !std::binary_search(allowed.begin(), allowed.end(),
+                                   std::make_pair(payer, payees[e]))){
+                return false;
+            }
+            left[payer] -= (long long)amounts[e];
+            left[payees[e]] += (long long)amounts[e];
+        }
+    }
+    for(int i = 0; i < left.size(); ++i){
+        if(left[i] != 0){
+            return false;
+        }
+    }
+    return graph.getEdgeCount() < balances.size();
+}
+
+
+/*******************************************************************************
+ *                          checkAllowedGames()
+ * Description: Settles each of the small check games for the fewest payments
+ *              and returns whether they all came out as they should.
+*******************************************************************************/
+bool checkAllowedGames(){
+    bool good = true;
+    for(int i = 0; i < ALLOWED_CHECK_COUNT; ++i){
+        const AllowedCheck& check = ALLOWED_CHECKS[i];
+        std::vector<long long> balances(check.balances,
+                                        check.balances + check.players);
+        std::vector<int> payers(check.payers, check.payers + check.allowed);
+        std::vector<int> payees(check.payees, check.payees + check.allowed);
+        Game* game = buildGame(balances);
+        PlayerGraph graph(game);
+        int stranded;
+        bool settled = graph.solveConstrained(payers, payees,
+                                              FEWEST_PAYMENTS, stranded) &&
+                       checkAllowedSettlement(balances, payers, payees,
+                                              graph);
+        if(!settled || graph.getEdgeCount() != check.payments ||
+           graph.getPairedPayments() != check.pairedPayments){
+            std::cerr << "allowed check " << i << " made "
+                      << graph.getEdgeCount() << " payments, "
+                      << graph.getPairedPayments() << " paired, instead of "
+                      << check.payments << ", " << check.pairedPayments
+                      << " paired" << std::endl;
+            good = false;
+        }
+        delete game;
+    }
+    return good;
+}
+
+
+/*******************************************************************************
+ *              runAllowedBenchmark(players, rng, results)
+ * Description: Generates a uniform game and a ring of allowed payments plus
+ *              random ones, then times settling it with each objective and
+ *              adds a result for each to results.
+*******************************************************************************/
+void runAllowedBenchmark(int players, std::mt19937_64& rng,
+                         std::vector<AllowedResult>& results){
+    std::vector<long long> balances = generateBalances("uniform", players,
+                                                       rng);
+    std::vector<int> payers;
+    std::vector<int> payees;
+    for(int i = 0; i < players; ++i){
+        payers.push_back(i);
+        payees.push_back((i + 1) % players);
+        for(int r = 0; r < ALLOWED_RANDOM_PAYMENTS; ++r){
+            payers.push_back(i);
+            payees.push_back(rng() % players);
+        }
+    }
+    Game* game = buildGame(balances);
+
+    const SettlementObjective objectives[] = {FEWEST_PAYMENTS,
+                                              LEAST_MONEY_MOVED};
+    for(int o = 0; o < 2; ++o){
+        AllowedResult result;
+        result.players = players;
+        result.allowed = payers.size();
+        result.objective = objectives[o];
+
+        std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+        PlayerGraph graph(game);
+        int stranded;
+        result.settled = graph.solveConstrained(payers, payees,
+                                                result.objective, stranded);
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        result.ms = elapsed.count() * 1e3;
+        result.payments = graph.getEdgeCount();
+        result.pairedPayments = graph.getPairedPayments();
+        result.settled = result.settled &&
+                         checkAllowedSettlement(balances, payers, payees,
+                                                graph);
+        results.push_back(result);
+    }
+    delete game;
+}
+
+
+/*******************************************************************************
+ *             runAllowedBenchmarks(seed, minPlayers, maxPlayers)
+ * Description: Checks the small games, then runs the allowed payments
+ *              benchmark at each size and prints the results as JSON. Returns
+ *              false if the check failed.
+*******************************************************************************/
+bool runAllowedBenchmarks(int seed, int minPlayers, int maxPlayers){
+    std::vector<AllowedResult> results;
+    bool checked = checkAllowedGames();
+    std::mt19937_64 rng(seed);
+    for(int players = 1000;
+        players <= std::min(maxPlayers, ALLOWED_MAX_PLAYERS); players *= 10){
+        if(players < minPlayers){
+            continue;
+        }
+        runAllowedBenchmark(players, rng, results);
+        const AllowedResult& fewest = results[results.size() - 2];
+        const AllowedResult& money = results[results.size() - 1];
+        std::cerr << "allowed " << players << " players: " << fewest.payments
+                  << " payments in " << fewest.ms << " ms, "
+                  << money.payments << " for the least money in " << money.ms
+                  << " ms" << std::endl;
+    }
+
+    std::printf("{\n  \"benchmark\": \"AllowedPayments\",\n");
+    std::printf("  \"seed\": %d,\n  \"checks_ok\": %s,\n",
+                seed, checked ? "true" : "false");
+    std::printf("  \"results\": [\n");
+    for(int i = 0; i < results.size(); ++i){
+        const AllowedResult& result = results[i];
+        std::printf("    {\"players\": %d, \"allowed\": %d, "
+                    "\"objective\": \"%s\", \"ms\": %.1f, "
+                    "\"payments\": %d, \"paired_payments\": %d, "
+                    "\"settled\": %s}%s\n",
+                    result.players, result.allowed,
+                    result.objective == FEWEST_PAYMENTS ? "payments"
+                                                        : "money",
+                    result.ms, result.payments, result.pairedPayments,
+                    result.settled ? "true" : "false",
+                    i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+    return checked;
+}
+
+
+/*******************************************************************************
+ *                       runSessionBenchmarks(seed)
+ * Description: Runs the session log benchmark at each size and prints the
+ *              results as JSON.
+*******************************************************************************/
+void runSessionBenchmarks(int seed){
+    std::vector<SessionResult> results;
+    for(int events = 1000; events <= SESSION_BENCH_MAX_EVENTS; events *= 10){
+        std::mt19937_64 rng(seed + events);
+        SessionResult result = runSessionBenchmark(events, rng);
+        results.push_back(result);
+        std::cerr << "session " << events << " events: "
+                  << result.nsPerEvent << " ns/event, recovered "
+                  << result.players << " players in " << result.recoveryMs
+                  << " ms" << std::endl;
+    }
+
+    std::printf("{\n  \"benchmark\": \"SessionLog\",\n");
+    std::printf("  \"seed\": %d,\n  \"results\": [\n", seed);
+    for(int i = 0; i < results.size(); ++i){
+        const SessionResult& result = results[i];
+        std::printf("    {\"events\": %d, \"players\": %d, "
+                    "\"ns_per_event\": %.1f, \"recovery_ms\": %.3f, "
+                    "\"events_replayed\": %ld, \"recovered\": %s}%s\n",
+                    result.events, result.players, result.nsPerEvent,
+                    result.recoveryMs, result.eventsReplayed,
+                    result.recovered ? "true" : "false",
+                    i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+}
+
+
+/*******************************************************************************
+ *                                  main()
+ * Description: Parses the options, runs every size and distribution, and
+ *              prints the results as JSON.
+*******************************************************************************/
+int main(int argc, char** argv){
+    int seed = 12345;
+    int minPlayers = 10;
+    int maxPlayers = 10000000;
+    SolverType solver = GREEDY_SOLVER;
+    std::string onlyDistribution;
+    bool live = false;
+    bool session = false;
+    bool reads = false;
+    bool writer = false;
+    bool kernels = false;
+    bool club = false;
+    bool quality = false;
+    bool parser = false;
+    bool allowed = false;
+
+    for(int i = 1; i < argc; ++i){
+        bool good = i + 1 < argc;
+        if(std::strcmp(argv[i], "--live") == 0){
+            live = true;
+            good = true;
+        }
+        else if(std::strcmp(argv[i], "--session") == 0){
+            session = true;
+            good = true;
+        }
+        else if(std::strcmp(argv[i], "--reads") == 0){
+            reads = true;
+            good = true;
+        }
+        else if(std::strcmp(argv[i], "--writer") == 0){
+            writer = true;
+            good = true;
+        }
+        else if(std::strcmp(argv[i], "--kernels") == 0){
+            kernels = true;
+            good = true;
+        }
+        else if(std::strcmp(argv[i], "--club") == 0){
+            club = true;
+            good = true;
+        }
+        else if(std::strcmp(argv[i], "--quality") == 0){
+            quality = true;
+            good = true;
+        }
+        else if(std::strcmp(argv[i], "--parser") == 0){
+            parser = true;
+            good = true;
+        }
+        else if(std::strcmp(argv[i], "--allowed") == 0){
+            allowed = true;
+            good = true;
+        }
+        else if(good && std::strcmp(argv[i], "--seed") == 0){
+            good = convertStringToInt(argv[++i], seed, 0, 2147483647);
+        }
+        else if(good && std::strcmp(argv[i], "--min-players") == 0){
+            good = convertStringToInt(argv[++i], minPlayers, 2, 2147483647);
+        }
+        else if(good && std::strcmp(argv[i], "--max-players") == 0){
+            good = convertStringToInt(argv[++i], maxPlayers, 2, 2147483647);
+        }
+        else if(good && std::strcmp(argv[i], "--solver") == 0){
+            ++i;
+            if(std::strcmp(argv[i], "greedy") == 0){
+                solver = GREEDY_SOLVER;
+            }
+            else if(std::strcmp(argv[i], "bucket") == 0){
+                solver = BUCKET_SOLVER;
+            }
+            else if(std::strcmp(argv[i], "exact") == 0){
+                solver = EXACT_SOLVER;
+            }
+            else{
+                good = false;
+            }
+        }
+        else if(good && std::strcmp(argv[i], "--distribution") == 0){
+            onlyDistribution = argv[++i];
+        }
+        else{
+            good = false;
+        }
+
+        if(!good){
+            std::cerr << "usage: " << argv[0] << " [--seed n] "
+                      << "[--min-players n] [--max-players n] "
+                      << "[--solver greedy|bucket|exact] [--distribution name] "
+                      << "[--live] [--session] [--reads] [--writer] "
+                      << "[--kernels] [--club] [--quality] [--parser] "
+                      << "[--allowed]" << std::endl;
+            return 2;
+        }
+    }
+
+    if(live){
+        runLiveBenchmarks(seed, minPlayers, maxPlayers);
+        return 0;
+    }
+    if(session){
+        runSessionBenchmarks(seed);
+        return 0;
+    }
+    if(reads){
+        runReadBenchmarks(seed, minPlayers, maxPlayers);
+        return 0;
+    }
+    if(writer){
+        runWriterBenchmarks(seed, minPlayers, maxPlayers);
+        return 0;
+    }
+    if(kernels){
+        runKernelBenchmarks(seed, minPlayers, maxPlayers);
+        return 0;
+    }
+    if(club){
+        runClubBenchmarks(seed, minPlayers, maxPlayers);
+        return 0;
+    }
+    if(quality){
+        runQualityBenchmarks(seed, minPlayers, maxPlayers, solver,
+                             onlyDistribution);
+        return 0;
+    }
+    if(parser){
+        return runParserBenchmarks(seed, minPlayers, maxPlayers) ? 0 : 1;
+    }
+    if(allowed){
+        return runAllowedBenchmarks(seed, minPlayers, maxPlayers) ? 0 : 1;
+    }
+
+    std::vector<BenchResult> results;
+    for(int d = 0; d < DISTRIBUTION_COUNT; ++d){
+        std::string distribution = DISTRIBUTIONS[d];
+        if(!onlyDistribution.empty() && onlyDistribution != distribution){
+            continue;
+        }
+
+        for(long long players = 10; players <= maxPlayers; players *= 10){
+            if(players < minPlayers){
+                continue;
+            }
+
+            //each run gets its own seeded generator, so a run can be
+            //reproduced on its own with --distribution and the size limits
+            std::mt19937_64 rng(seed + d * 1000003LL + players);
+            BenchResult result = runBenchmark(distribution, players, solver,
+                                              rng);
+            results.push_back(result);
+            std::cerr << distribution << " " << players << " players: "
+                      << result.nsPerPlayer << " ns/player, "
+                      << result.transactions << " payments ("
+                      << result.unpairedTransactions << " without pairing)"
+                      << std::endl;
+        }
+    }
+
+    std::printf("{\n  \"benchmark\": \"PlayerGraph::solve\",\n");
+    std::printf("  \"solver\": \"%s\",\n",
+                solverName(solver));
+    std::printf("  \"amount_bits\": %d,\n", POKERCALC_AMOUNT_BITS);
+    std::printf("  \"metrics\": %s,\n",
+                Metrics::isEnabled() ? "true" : "false");
+    std::printf("  \"validation\": %d,\n", POKERCALC_VALIDATION);
+    std::printf("  \"seed\": %d,\n  \"results\": [\n", seed);
+    for(int i = 0; i < results.size(); ++i){
+        const BenchResult& result = results[i];
+        std::printf("    {\"distribution\": \"%s\", \"players\": %d, "
+                    "\"iterations\": %d, \"ns_per_player\": %.2f, "
+                    "\"allocations\": %ld, \"peak_rss_so_far_kb\": %ld, "
+                    "\"transactions\": %d, \"paired_payments\": %d, "
+                    "\"transactions_without_pairing\": %d}%s\n",
+                    result.distribution.c_str(), result.players,
+                    result.iterations, result.nsPerPlayer, result.allocations,
+                    result.peakRssSoFarKb, result.transactions,
+                    result.pairedPayments, result.unpairedTransactions,
+                    i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+    return 0;
+}
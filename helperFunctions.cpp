@@ -51,49 +51,73 @@ bool isAnInt(const std::string &INPUT_STRING)
 
 
 /*******************************************************************************
-**				bool convertStringtoInt(string&,int&,int,int)
-** Description: Takes a reference to a string, a reference to an int (this
-** will take the value of the converted int), an int for the minimum allowable
-** value, and an int for the maximum allowable value. It returns true on a 
-** successful conversion and false on an unsuccessful conversion. It uses the
-** isAnInt() function also found in this file.
+**			bool convertCharsToInt(const char*,const char*,int&,int,int)
+** Description: Takes the characters from first up to last, a reference to an
+** int (this will take the value of the converted int), an int for the minimum
+** allowable value, and an int for the maximum allowable value. It returns true
+** on a successful conversion and false on an unsuccessful conversion. The
+** characters are read once, and only an int written the way std::to_string()
+** would write it is accepted: an optional '-', then digits without leading
+** zeros.
 *******************************************************************************/
-bool convertStringToInt(const std::string &INPUT_STRING,int &convertedInt,
-	 int min, int max)
+bool convertCharsToInt(const char *first, const char *last, int &convertedInt,
+	int min, int max)
 {
-	int tempInt;
+	bool negative = (first != last && *first == '-');
+	if(negative)
+	{
+		first++;
+	}
 
-	if(isAnInt(INPUT_STRING))	//make sure string can be made an int
+	//no digits, a leading zero, or "-0"
+	if(first == last || (*first == '0' && (last - first > 1 || negative)))
 	{
-		tempInt = std::atoi(INPUT_STRING.c_str());	//convert string to an
-											//int
-											
-		//if the string contained an integer larger than INT_MAX, it will
-		//overflow. So, comparing the original string to the tempInt will
-		//indicate if the input was too large/too small to be an int
-		if((std::to_string(tempInt)).compare(INPUT_STRING) == 0)
-		{
-			//is int in specified range?
-			if(tempInt >= min && tempInt <= max)
-			{
-				convertedInt = tempInt;
-				return true;
-			}
-			else
-			{
-				return false;
-			}
-		}
-		else
+		return false;
+	}
+
+	//an int has at most 10 digits, so the value can't overflow a long long
+	if(last - first > 10)
+	{
+		return false;
+	}
+	long long value = 0;
+	for(; first != last; ++first)
+	{
+		unsigned digit = (unsigned char)*first - '0';
+		if(digit > 9)
 		{
 			return false;
 		}
+		value = value * 10 + digit;
 	}
-	else
+	if(negative)
+	{
+		value = -value;
+	}
+
+	//is int in specified range?
+	if(value < min || value > max)
 	{
 		return false;
 	}
-	
+	convertedInt = (int)value;
+	return true;
+}
+
+
+/*******************************************************************************
+**				bool convertStringtoInt(string&,int&,int,int)
+** Description: Takes a reference to a string, a reference to an int (this
+** will take the value of the converted int), an int for the minimum allowable
+** value, and an int for the maximum allowable value. It returns true on a 
+** successful conversion and false on an unsuccessful conversion. It uses the
+** convertCharsToInt() function also found in this file.
+*******************************************************************************/
+bool convertStringToInt(const std::string &INPUT_STRING,int &convertedInt,
+	 int min, int max)
+{
+	return convertCharsToInt(INPUT_STRING.data(),
+		INPUT_STRING.data() + INPUT_STRING.size(), convertedInt, min, max);
 }
 
 
@@ -12,7 +12,15 @@
 #include <string>
 #include <fstream>
 
+//limits on user supplied values shared by the interactive menus and the
+//batch ledger reader
+const int MIN_NAME_LENGTH = 2;
+const int MAX_NAME_LENGTH = 20;
+const int MIN_STACK = 0;
+const int MAX_STACK = 1000000;
+
 bool isAnInt(const std::string&);
+bool convertCharsToInt(const char*,const char*,int&,int,int);
 bool convertStringToInt(const std::string&,int&,int,int);
 void pause();
 void clearTheScreen();
@@ -10,12 +10,25 @@
 #include "Game.hpp"
 #include "helperFunctions.hpp"
 #include "PlayerGraph.hpp"
+#include "BatchSettler.hpp"
+#include "ClubSettler.hpp"
+#include "BalanceSummary.hpp"
+#include "ParallelSettler.hpp"
+#include "BinaryLedger.hpp"
+#include "SettlementServer.hpp"
+#include "SettlementCache.hpp"
+#include "SessionLog.hpp"
+#include "SettlementWriter.hpp"
+#include "AllowedPayments.hpp"
+#include "LedgerReader.hpp"
+#include "Metrics.hpp"
+#include "PlayerNames.hpp"
+#include <chrono>
 #include <iostream>
-
-const int MIN_NAME_LENGTH = 2;
-const int MAX_NAME_LENGTH = 20;
-const int MIN_STACK = 0;
-const int MAX_STACK = 1000000;
+#include <fstream>
+#include <cstring>
+#include <thread>
+#include <utility>
 
 
 //function prototypes
@@ -23,18 +36,335 @@ int mainMenu(Game*);
 void addPlayer(Game*);
 void addBuyInToPlayer(Game*);
 bool splashScreen();
+int runBatch(const char* inputPath, const char* outputPath,
+             SolverType solver, int threadCount, OutputFormat format,
+             const char* allowedPath, SettlementObjective objective,
+             int maxPayments, int cacheMegabytes);
+int runClub(const char* inputPath, const char* outputPath,
+            const char* drillDownPath, SolverType solver, int threadCount,
+            OutputFormat format, const char* allowedPath,
+            SettlementObjective objective, int maxPayments);
+int runLedger(const char* ledgerPath, const char* outputPath,
+              const char* settledPath, SolverType solver,
+              OutputFormat format, const char* allowedPath,
+              SettlementObjective objective, int maxPayments);
+bool readAllowedPayments(const char* allowedPath, AllowedPayments& allowed);
+int packLedger(const char* inputPath, const char* ledgerPath);
+int summarizeLedger(const char* inputPath, const char* summaryPath,
+                    int workerCount);
+int mergeSummaries(const char* mergedPath, int summaryCount,
+                   char** summaryPaths);
+int runSummary(const char* summaryPath, const char* outputPath,
+               SolverType solver, OutputFormat format,
+               const char* allowedPath, SettlementObjective objective,
+               int maxPayments);
+int runServer(const char* socketPath, SolverType solver, int threadCount,
+              int cacheMegabytes, int maxNames);
+void printUsage(const char* programName);
 
 
 /*******************************************************************************
  *                          main()
- * Description: main function for PokerCalc execution. Creates a Game object,
- *              manages user input for the main menu of the game
+ * Description: main function for PokerCalc execution. With no arguments, it
+ *              creates a Game object and manages user input for the main menu
+ *              of the game. With --batch, every game in a ledger file (or
+ *              stdin, given "-") is settled without any prompts. With
+ *              --ledger, the game in a binary ledger is settled, and --pack
+ *              turns a one game text ledger into a binary one. With --serve,
+ *              ledgers sent to a Unix domain socket are settled until the
+ *              server is stopped. With --log, the interactive game is logged
+ *              as it's played, and a game that was cut short is picked back
+ *              up where it left off. --batch and --ledger can be limited to the
+ *              payments listed with --allowed, or to --max-payments per player,
+ *              and --batch and --serve can settle through a --cache of games
+ *              already solved. With --club, the games of a batch are a club's
+ *              tables, and their players are netted over every table and
+ *              settled once. --summarize adds up each player's buy-ins and
+ *              final stacks over a ledger into a summary, on --workers
+ *              processes, --merge merges summaries into one, and --summary
+ *              settles the players of a summary as one game. In any mode,
+ *              --metrics writes the settlement pipeline's Metrics to a file
+ *              when PokerCalc exits.
 *******************************************************************************/
-int main() {
+int main(int argc, char** argv) {
+    const char* batchPath = NULL;
+    const char* ledgerPath = NULL;
+    const char* socketPath = NULL;
+    const char* logPath = NULL;
+    const char* settledPath = NULL;
+    const char* outputPath = NULL;
+    const char* metricsPath = NULL;
+    const char* allowedPath = NULL;
+    const char* drillDownPath = NULL;
+    const char* summarizePath = NULL;
+    const char* summaryPath = NULL;
+    const char* settleSummaryPath = NULL;
+    SolverType solver = GREEDY_SOLVER;
+    SettlementObjective objective = FEWEST_PAYMENTS;
+    int threadCount = 1;
+    int maxPayments = 0;
+    int workerCount = 0;
+    int cacheMegabytes = 0;
+    int maxNames = 0;
+    OutputFormat format = CSV_FORMAT;
+    bool batchOptionGiven = false;
+    bool formatGiven = false;
+    bool objectiveGiven = false;
+    bool solverGiven = false;
+    bool club = false;
+
+    //parse command line options
+    for(int i = 1; i < argc; ++i){
+        if(std::strcmp(argv[i], "--batch") == 0 && i + 1 < argc){
+            batchPath = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "--log") == 0 && i + 1 < argc){
+            logPath = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "--serve") == 0 && i + 1 < argc){
+            socketPath = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "--ledger") == 0 && i + 1 < argc){
+            ledgerPath = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "--write-ledger") == 0 && i + 1 < argc){
+            settledPath = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "--pack") == 0 && i + 2 < argc &&
+                argc == 4){
+            return packLedger(argv[i + 1], argv[i + 2]);
+        }
+        else if(std::strcmp(argv[i], "--summarize") == 0 && i + 2 < argc){
+            summarizePath = argv[++i];
+            summaryPath = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc){
+            if(!convertStringToInt(argv[++i], workerCount, 0, 1024)){
+                printUsage(argv[0]);
+                return 2;
+            }
+            //0 means one worker per core
+            if(workerCount == 0){
+                workerCount = std::thread::hardware_concurrency();
+                if(workerCount < 1){
+                    workerCount = 1;
+                }
+            }
+        }
+        else if(std::strcmp(argv[i], "--merge") == 0 && i == 1 &&
+                argc >= 4){
+            return mergeSummaries(argv[2], argc - 3, argv + 3);
+        }
+        else if(std::strcmp(argv[i], "--summary") == 0 && i + 1 < argc){
+            settleSummaryPath = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "--output") == 0 && i + 1 < argc){
+            outputPath = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "--metrics") == 0 && i + 1 < argc){
+            metricsPath = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "--solver") == 0 && i + 1 < argc){
+            batchOptionGiven = true;
+            solverGiven = true;
+            ++i;
+            if(std::strcmp(argv[i], "greedy") == 0){
+                solver = GREEDY_SOLVER;
+            }
+            else if(std::strcmp(argv[i], "exact") == 0){
+                solver = EXACT_SOLVER;
+            }
+            else if(std::strcmp(argv[i], "bucket") == 0){
+                solver = BUCKET_SOLVER;
+            }
+            else{
+                printUsage(argv[0]);
+                return 2;
+            }
+        }
+        else if(std::strcmp(argv[i], "--format") == 0 && i + 1 < argc){
+            formatGiven = true;
+            if(!parseOutputFormat(argv[++i], format)){
+                printUsage(argv[0]);
+                return 2;
+            }
+        }
+        else if(std::strcmp(argv[i], "--club") == 0){
+            club = true;
+        }
+        else if(std::strcmp(argv[i], "--drill-down") == 0 && i + 1 < argc){
+            drillDownPath = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "--allowed") == 0 && i + 1 < argc){
+            allowedPath = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "--objective") == 0 && i + 1 < argc){
+            objectiveGiven = true;
+            ++i;
+            if(std::strcmp(argv[i], "payments") == 0){
+                objective = FEWEST_PAYMENTS;
+            }
+            else if(std::strcmp(argv[i], "money") == 0){
+                objective = LEAST_MONEY_MOVED;
+            }
+            else{
+                printUsage(argv[0]);
+                return 2;
+            }
+        }
+        else if(std::strcmp(argv[i], "--max-payments") == 0 &&
+                i + 1 < argc){
+            //with one payment each, only exact matches could be settled
+            if(!convertStringToInt(argv[++i], maxPayments, 2, 1000000)){
+                printUsage(argv[0]);
+                return 2;
+            }
+        }
+        else if(std::strcmp(argv[i], "--cache") == 0 && i + 1 < argc){
+            if(!convertStringToInt(argv[++i], cacheMegabytes, 1, 1 << 20)){
+                printUsage(argv[0]);
+                return 2;
+            }
+        }
+        else if(std::strcmp(argv[i], "--max-names") == 0 && i + 1 < argc){
+            if(!convertStringToInt(argv[++i], maxNames, 1, 2147483647)){
+                printUsage(argv[0]);
+                return 2;
+            }
+        }
+        else if(std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc){
+            batchOptionGiven = true;
+            if(!convertStringToInt(argv[++i], threadCount, 0, 1024)){
+                printUsage(argv[0]);
+                return 2;
+            }
+            //0 means one thread per core
+            if(threadCount == 0){
+                threadCount = std::thread::hardware_concurrency();
+                if(threadCount < 1){
+                    threadCount = 1;
+                }
+            }
+        }
+        else{
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    //metrics are written when PokerCalc exits, whichever mode it ran in
+    if(metricsPath != NULL){
+        if(!Metrics::isEnabled()){
+            std::cerr << "PokerCalc was built without metrics; rebuild it "
+                      << "with make METRICS=1 to use --metrics" << std::endl;
+            return 2;
+        }
+        Metrics::writeFileAtExit(metricsPath);
+    }
+
+    //an objective only means something with allowed payments
+    if(objectiveGiven && allowedPath == NULL){
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    //a limit on payments per player picks its own solver
+    if(maxPayments > 0 && (solverGiven || allowedPath != NULL)){
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    //a cache only holds the solver's settlements, for a batch or a server
+    if(cacheMegabytes > 0 && (allowedPath != NULL || maxPayments > 0 ||
+                              club || (batchPath == NULL &&
+                                       socketPath == NULL))){
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    //only a server runs long enough for its names to pile up
+    if(maxNames > 0 && socketPath == NULL){
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    int modes = (batchPath != NULL) + (ledgerPath != NULL) +
+                (socketPath != NULL) + (logPath != NULL) +
+                (summarizePath != NULL) + (settleSummaryPath != NULL);
+    if(summarizePath != NULL || workerCount > 0){
+        if(modes != 1 || summarizePath == NULL || outputPath != NULL ||
+           settledPath != NULL || batchOptionGiven || formatGiven ||
+           allowedPath != NULL || maxPayments > 0 || club){
+            printUsage(argv[0]);
+            return 2;
+        }
+        return summarizeLedger(summarizePath, summaryPath,
+                               workerCount > 0 ? workerCount : 1);
+    }
+    if(modes == 1 && settleSummaryPath != NULL && settledPath == NULL &&
+       !club && drillDownPath == NULL){
+        return runSummary(settleSummaryPath, outputPath, solver, format,
+                          allowedPath, objective, maxPayments);
+    }
+    if(club || drillDownPath != NULL){
+        if(modes != 1 || batchPath == NULL || settledPath != NULL || !club){
+            printUsage(argv[0]);
+            return 2;
+        }
+        return runClub(batchPath, outputPath, drillDownPath, solver,
+                       threadCount, format, allowedPath, objective,
+                       maxPayments);
+    }
+    if(modes == 1 && batchPath != NULL && settledPath == NULL){
+        return runBatch(batchPath, outputPath, solver, threadCount, format,
+                        allowedPath, objective, maxPayments, cacheMegabytes);
+    }
+    if(modes == 1 && ledgerPath != NULL){
+        return runLedger(ledgerPath, outputPath, settledPath, solver, format,
+                         allowedPath, objective, maxPayments);
+    }
+    if(modes == 1 && socketPath != NULL && outputPath == NULL &&
+       settledPath == NULL && !formatGiven && allowedPath == NULL &&
+       maxPayments == 0){
+        return runServer(socketPath, solver, threadCount, cacheMegabytes,
+                         maxNames);
+    }
+    if(modes > (logPath != NULL) || outputPath != NULL ||
+       settledPath != NULL || batchOptionGiven || formatGiven ||
+       allowedPath != NULL || maxPayments > 0){
+        printUsage(argv[0]);
+        return 2;
+    }
 
     while(splashScreen()){
         Game* game = new Game;
-        while(mainMenu(game));
+
+        //pick up a game that was cut short
+        if(logPath != NULL){
+            std::string error;
+            if(!game->startSessionLog(logPath, error)){
+                std::cerr << error << std::endl;
+                delete game;
+                return 2;
+            }
+            if(game->getPlayerCount() > 0){
+                clearTheScreen();
+                std::cout << "Recovered a game of " << game->getPlayerCount()
+                          << " players from " << logPath << ".\n";
+                pause();
+            }
+        }
+
+        //each change is on disk before the next menu is shown
+        while(mainMenu(game)){
+            if(game->getSessionLog() != NULL &&
+               !game->getSessionLog()->commit()){
+                std::cerr << "Could not write to " << logPath << std::endl;
+            }
+        }
+        if(game->getSessionLog() != NULL){
+            game->getSessionLog()->finish();
+        }
         pause();
         delete game;
     }
@@ -111,8 +441,7 @@ void addPlayer(Game* game){
     userStack = getIntFromUser(MIN_STACK, MAX_STACK);
 
     //add the player
-    Player* newPlayer = new Player(userName, userStack);
-    game->addPlayer(newPlayer);
+    game->addPlayer(std::move(userName), userStack);
     return;
 }
 
@@ -126,7 +455,7 @@ void addBuyInToPlayer(Game* game){
     clearTheScreen();
 
     //get the vector of players from the game
-    std::vector<Player*> players = game->getPlayers();
+    const std::vector<std::unique_ptr<Player> >& players = game->getPlayers();
 
     //make sure there are players entered in the game
     if(players.size() == 0){
@@ -184,3 +513,606 @@ bool splashScreen() {
         return false;
     }
 }
+
+
+/*******************************************************************************
+ *           readAllowedPayments(const char*, AllowedPayments&)
+ * Description: Reads the allowed payments at allowedPath. Reports why on
+ *              stderr and returns false if they can't be read.
+*******************************************************************************/
+bool readAllowedPayments(const char* allowedPath, AllowedPayments& allowed){
+    std::ifstream allowedFile(allowedPath);
+    if(!allowedFile){
+        std::cerr << "Could not open allowed payments " << allowedPath
+                  << std::endl;
+        return false;
+    }
+    if(!allowed.read(allowedFile)){
+        std::cerr << allowedPath << ": " << allowed.getError() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+
+/*******************************************************************************
+ *      runBatch(const char*, const char*, SolverType, int, OutputFormat,
+ *               const char*, SettlementObjective, int, int)
+ * Description: Settles every game in the ledger at inputPath ("-" for stdin)
+ *              with the given solver on threadCount threads and writes the
+ *              payments in the given format to outputPath, or to stdout if no
+ *              output path was given. If allowedPath isn't NULL, games are
+ *              settled with only the payments it allows, keeping the
+ *              objective down, instead of with the solver. If maxPayments
+ *              isn't 0, games are instead settled so no player makes and
+ *              receives more than maxPayments payments. If cacheMegabytes
+ *              isn't 0, games with the same balances as one already solved
+ *              take its payments from a cache that size. Throughput is
+ *              reported on stderr.
+*******************************************************************************/
+int runBatch(const char* inputPath, const char* outputPath,
+             SolverType solver, int threadCount, OutputFormat format,
+             const char* allowedPath, SettlementObjective objective,
+             int maxPayments, int cacheMegabytes){
+    AllowedPayments allowed;
+    if(allowedPath != NULL && !readAllowedPayments(allowedPath, allowed)){
+        return 2;
+    }
+
+    std::ifstream inputFile;
+    std::ofstream outputFile;
+    std::istream* input = &std::cin;
+    std::ostream* output = &std::cout;
+
+    if(std::strcmp(inputPath, "-") != 0){
+        inputFile.open(inputPath);
+        if(!inputFile){
+            std::cerr << "Could not open ledger " << inputPath << std::endl;
+            return 2;
+        }
+        input = &inputFile;
+    }
+
+    if(outputPath != NULL){
+        outputFile.open(outputPath);
+        if(!outputFile){
+            std::cerr << "Could not open output " << outputPath << std::endl;
+            return 2;
+        }
+        output = &outputFile;
+    }
+
+    //settling does not mix with console prompts, so cin/cout can be untied
+    std::ios_base::sync_with_stdio(false);
+    std::cin.tie(NULL);
+
+    BatchSettler settler(*input, *output, std::cerr, solver, threadCount,
+                         format);
+    if(allowedPath != NULL){
+        settler.setAllowedPayments(&allowed, objective);
+    }
+    settler.setMaxPayments(maxPayments);
+    SettlementCache cache((size_t)cacheMegabytes << 20);
+    if(cacheMegabytes > 0){
+        settler.setCache(&cache);
+    }
+    int status = settler.run();
+    settler.printStats();
+    return status;
+}
+
+
+/*******************************************************************************
+ *   runClub(const char*, const char*, const char*, SolverType, int,
+ *           OutputFormat, const char*, SettlementObjective, int)
+ * Description: Settles the games in the ledger at inputPath ("-" for stdin)
+ *              as the tables of one club: each player is netted over every
+ *              table they sat at, and the club makes one settlement, written
+ *              as the payments of a game with the id "club" to outputPath, or
+ *              to stdout if no output path was given. The tables are gathered
+ *              on threadCount threads. The settlement is limited by
+ *              allowedPath and maxPayments as runBatch()'s games are. If
+ *              drillDownPath isn't NULL, what each player won or lost at each
+ *              table is written there. Tables that can't be settled are left
+ *              out and reported on stderr, along with how long it all took.
+*******************************************************************************/
+int runClub(const char* inputPath, const char* outputPath,
+            const char* drillDownPath, SolverType solver, int threadCount,
+            OutputFormat format, const char* allowedPath,
+            SettlementObjective objective, int maxPayments){
+    AllowedPayments allowed;
+    if(allowedPath != NULL && !readAllowedPayments(allowedPath, allowed)){
+        return 2;
+    }
+
+    std::ifstream inputFile;
+    std::ofstream outputFile;
+    std::ofstream drillDownFile;
+    std::istream* input = &std::cin;
+    std::ostream* output = &std::cout;
+
+    if(std::strcmp(inputPath, "-") != 0){
+        inputFile.open(inputPath);
+        if(!inputFile){
+            std::cerr << "Could not open ledger " << inputPath << std::endl;
+            return 2;
+        }
+        input = &inputFile;
+    }
+
+    if(outputPath != NULL){
+        outputFile.open(outputPath);
+        if(!outputFile){
+            std::cerr << "Could not open output " << outputPath << std::endl;
+            return 2;
+        }
+        output = &outputFile;
+    }
+
+    if(drillDownPath != NULL){
+        drillDownFile.open(drillDownPath);
+        if(!drillDownFile){
+            std::cerr << "Could not open drill-down " << drillDownPath
+                      << std::endl;
+            return 2;
+        }
+    }
+
+    std::ios_base::sync_with_stdio(false);
+    std::cin.tie(NULL);
+
+    ClubSettler settler(threadCount, solver);
+    if(allowedPath != NULL){
+        settler.setAllowedPayments(&allowed, objective);
+    }
+    settler.setMaxPayments(maxPayments);
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    LedgerReader reader(*input);
+    LedgerGame record;
+    while(reader.nextGame(record)){
+        settler.addTable(record);
+    }
+
+    std::string error;
+    bool settled = settler.settle("club", error);
+    int tablesSkipped = 0;
+    for(int i = 0; i < settler.getTableCount(); ++i){
+        if(!settler.getTableError(i).empty()){
+            std::cerr << "game " << settler.getTable(i).gameId
+                      << " skipped: " << settler.getTableError(i) << "\n";
+            tablesSkipped++;
+        }
+    }
+    if(!settled){
+        std::cerr << "club not settled: " << error << std::endl;
+        return 1;
+    }
+
+    SettlementWriter writer(*output, format);
+    writer.writeGame("club", settler.getPayments());
+    writer.finish();
+    if(drillDownPath != NULL){
+        settler.writeDrillDown(drillDownFile);
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    std::cerr << "settled a club of "
+              << settler.getTableCount() - tablesSkipped << " tables ("
+              << settler.getSeatCount() << " seats, "
+              << settler.getClub().getPlayerCount() << " players) with "
+              << settler.getPayments().size() << " payments, skipped "
+              << tablesSkipped << " tables in " << elapsed.count()
+              << " s on " << threadCount << " threads" << std::endl;
+    return tablesSkipped > 0 ? 1 : 0;
+}
+
+
+/*******************************************************************************
+ *                runLedger(const char*, const char*, const char*,
+ *                          SolverType, OutputFormat, const char*,
+ *                          SettlementObjective, int)
+ * Description: Settles the game in the binary ledger at ledgerPath, reading
+ *              it in place, and writes the payments in the given format to
+ *              outputPath (stdout if it's NULL). If allowedPath isn't NULL,
+ *              the game is settled with only the payments it allows, which
+ *              can't be for a particular game, keeping the objective down. If
+ *              maxPayments isn't 0, no player makes and receives more than
+ *              maxPayments payments. If settledPath isn't NULL, the settled
+ *              game is also written there as a binary ledger.
+*******************************************************************************/
+int runLedger(const char* ledgerPath, const char* outputPath,
+              const char* settledPath, SolverType solver,
+              OutputFormat format, const char* allowedPath,
+              SettlementObjective objective, int maxPayments){
+    AllowedPayments allowed;
+    if(allowedPath != NULL){
+        if(!readAllowedPayments(allowedPath, allowed)){
+            return 2;
+        }
+        if(allowed.hasGamePairs()){
+            std::cerr << allowedPath << ": a binary ledger has no game ids, "
+                      << "so payments can't be allowed for one game only"
+                      << std::endl;
+            return 2;
+        }
+    }
+
+    BinaryLedger ledger;
+    if(!ledger.open(ledgerPath)){
+        std::cerr << ledgerPath << ": " << ledger.getError() << std::endl;
+        return 2;
+    }
+
+    //the same precondition Game::checkStacks() enforces interactively. The
+    //ledger tallied the totals when it was opened
+    Amount totalPurse = ledger.getTotalBuyIns();
+    Amount totalStacks = ledger.getTotalFinalStacks();
+    if(totalPurse != ledger.getTotalBuyIns() ||
+       totalStacks != ledger.getTotalFinalStacks()){
+        std::cerr << ledgerPath << ": amounts overflow the "
+                  << POKERCALC_AMOUNT_BITS << " bit amount type"
+                  << std::endl;
+        return 1;
+    }
+    if(totalPurse != totalStacks){
+        std::cerr << ledgerPath << ": stacks total " << totalStacks
+                  << " but the purse is " << totalPurse << std::endl;
+        return 1;
+    }
+
+    PlayerGraph graph(ledger);
+    if(allowedPath == NULL && maxPayments > 0){
+        graph.solveGraphBounded(maxPayments);
+    }
+    else if(allowedPath == NULL){
+        graph.solve(solver);
+    }
+    else{
+        std::vector<int> payers;
+        std::vector<int> payees;
+        allowed.findPairs("", graph, payers, payees);
+        int stranded;
+        if(!graph.solveConstrained(payers, payees, objective, stranded)){
+            std::cerr << ledgerPath << ": the allowed payments can't settle "
+                      << graph.getPlayerName(stranded) << std::endl;
+            return 1;
+        }
+    }
+
+    std::ofstream outputFile;
+    std::ostream* output = &std::cout;
+    if(outputPath != NULL){
+        outputFile.open(outputPath);
+        if(!outputFile){
+            std::cerr << "Could not open output " << outputPath << std::endl;
+            return 2;
+        }
+        output = &outputFile;
+    }
+    std::ios_base::sync_with_stdio(false);
+
+    SettlementWriter writer(*output, format);
+    writer.writeGraph(graph);
+    writer.finish();
+
+    if(settledPath != NULL){
+        std::string error;
+        if(!BinaryLedger::write(settledPath, graph, error)){
+            std::cerr << error << std::endl;
+            return 2;
+        }
+    }
+
+    std::cerr << "settled " << graph.getNodeCount() << " players with "
+              << graph.getEdgeCount() << " payments" << std::endl;
+    return 0;
+}
+
+
+/*******************************************************************************
+ *                     packLedger(const char*, const char*)
+ * Description: Reads the one game in the text ledger at inputPath and writes
+ *              it to ledgerPath as an unsettled binary ledger.
+*******************************************************************************/
+int packLedger(const char* inputPath, const char* ledgerPath){
+    std::ifstream input(inputPath);
+    if(!input){
+        std::cerr << "Could not open ledger " << inputPath << std::endl;
+        return 2;
+    }
+
+    LedgerReader reader(input);
+    LedgerGame record;
+    if(!reader.nextGame(record)){
+        std::cerr << inputPath << " has no games" << std::endl;
+        return 1;
+    }
+
+    int status = 0;
+    LedgerGame extra;
+    if(reader.nextGame(extra)){
+        delete extra.game;
+        std::cerr << inputPath << " has more than one game" << std::endl;
+        status = 1;
+    }
+    else if(!record.error.empty()){
+        std::cerr << record.error << std::endl;
+        status = 1;
+    }
+    else if(!record.game->amountsFit() ||
+            record.game->getTotalStacks() != record.game->getTotalPurse()){
+        std::cerr << inputPath << ": the stacks don't add up to the purse"
+                  << std::endl;
+        status = 1;
+    }
+    else{
+        std::string error;
+        PlayerGraph graph(record.game);
+        if(!BinaryLedger::write(ledgerPath, graph, error)){
+            std::cerr << error << std::endl;
+            status = 2;
+        }
+    }
+
+    delete record.game;
+    return status;
+}
+
+
+/*******************************************************************************
+ *               summarizeLedger(const char*, const char*, int)
+ * Description: Adds up each player's buy-ins and final stacks over every game
+ *              of the text ledger at inputPath (stdin if it's "-") and saves
+ *              the summary to summaryPath. With more than one worker, the
+ *              ledger is cut into that many parts at game boundaries and each
+ *              part is summarized by a process of its own. Games that can't
+ *              be settled are left out and reported on stderr.
+*******************************************************************************/
+int summarizeLedger(const char* inputPath, const char* summaryPath,
+                    int workerCount){
+    if(std::strcmp(inputPath, "-") == 0 && workerCount > 1){
+        std::cerr << "a ledger read from stdin can't be split between "
+                  << "workers" << std::endl;
+        return 2;
+    }
+    std::ios_base::sync_with_stdio(false);
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    BalanceSummary summary;
+    std::string error;
+    if(!summary.addLedgerFile(inputPath, workerCount,
+                              std::string(summaryPath) + ".part", std::cerr,
+                              error) ||
+       !summary.write(summaryPath, error)){
+        std::cerr << error << std::endl;
+        return 2;
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    std::cerr << "summarized " << summary.getGameCount() << " games ("
+              << summary.getSeatCount() << " seats, "
+              << summary.getPlayerCount() << " players), skipped "
+              << summary.getSkippedCount() << " games in "
+              << elapsed.count() << " s on " << workerCount << " workers"
+              << std::endl;
+    return summary.getSkippedCount() > 0 ? 1 : 0;
+}
+
+
+/*******************************************************************************
+ *                    mergeSummaries(const char*, int, char**)
+ * Description: Merges the summaryCount summaries at summaryPaths into one and
+ *              saves it to mergedPath. The same summaries make the same file
+ *              whatever order they're given in.
+*******************************************************************************/
+int mergeSummaries(const char* mergedPath, int summaryCount,
+                   char** summaryPaths){
+    BalanceSummary merged;
+    BalanceSummary summary;
+    std::string error;
+    for(int i = 0; i < summaryCount; ++i){
+        if(!summary.read(summaryPaths[i], error)){
+            std::cerr << error << std::endl;
+            return 2;
+        }
+        if(!merged.merge(summary, error)){
+            std::cerr << summaryPaths[i] << ": " << error << std::endl;
+            return 2;
+        }
+    }
+    if(!merged.write(mergedPath, error)){
+        std::cerr << error << std::endl;
+        return 2;
+    }
+
+    std::cerr << "merged " << summaryCount << " summaries of "
+              << merged.getGameCount() << " games into "
+              << merged.getPlayerCount() << " players" << std::endl;
+    return 0;
+}
+
+
+/*******************************************************************************
+ *              runSummary(const char*, const char*, SolverType,
+ *                         OutputFormat, const char*, SettlementObjective,
+ *                         int)
+ * Description: Settles the players of the summary at summaryPath as one game,
+ *              with game id "league", and writes the payments in the given
+ *              format to outputPath (stdout if it's NULL). allowedPath and
+ *              maxPayments limit the payments as they do for runLedger().
+*******************************************************************************/
+int runSummary(const char* summaryPath, const char* outputPath,
+               SolverType solver, OutputFormat format,
+               const char* allowedPath, SettlementObjective objective,
+               int maxPayments){
+    AllowedPayments allowed;
+    if(allowedPath != NULL && !readAllowedPayments(allowedPath, allowed)){
+        return 2;
+    }
+
+    BalanceSummary summary;
+    std::string error;
+    if(!summary.read(summaryPath, error)){
+        std::cerr << error << std::endl;
+        return 2;
+    }
+
+    //settled like any game of a batch, which checks the stacks add up to
+    //the purse. A summary of settleable games always balances
+    Game league;
+    if(!summary.makeGame(league, error)){
+        std::cerr << summaryPath << ": " << error << std::endl;
+        return 1;
+    }
+    LedgerGame record;
+    record.gameId = "league";
+    record.game = &league;
+    record.firstLine = 0;
+    GameSettlement settlement;
+    ParallelSettler::settleGame(record, solver, settlement,
+                                allowedPath != NULL ? &allowed : NULL,
+                                objective, maxPayments);
+    if(!settlement.error.empty()){
+        //the league isn't on any one line of a ledger
+        error = settlement.error;
+        size_t lineEnd = error.find(": ");
+        if(error.compare(0, 5, "line ") == 0 && lineEnd != std::string::npos){
+            error.erase(0, lineEnd + 2);
+        }
+        std::cerr << summaryPath << ": " << error << std::endl;
+        return 1;
+    }
+
+    std::ofstream outputFile;
+    std::ostream* output = &std::cout;
+    if(outputPath != NULL){
+        outputFile.open(outputPath);
+        if(!outputFile){
+            std::cerr << "Could not open output " << outputPath << std::endl;
+            return 2;
+        }
+        output = &outputFile;
+    }
+    std::ios_base::sync_with_stdio(false);
+
+    SettlementWriter writer(*output, format);
+    writer.writeGame("league", settlement.payments);
+    writer.finish();
+
+    std::cerr << "settled a league of " << summary.getGameCount()
+              << " games (" << summary.getSeatCount() << " seats, "
+              << summary.getPlayerCount() << " players) with "
+              << settlement.payments.size() << " payments" << std::endl;
+    return 0;
+}
+
+
+/*******************************************************************************
+ *             runServer(const char*, SolverType, int, int, int)
+ * Description: Serves settlement requests on the Unix domain socket at
+ *              socketPath until the server is stopped with SIGINT or SIGTERM,
+ *              then reports its request counts and latencies on stderr. If
+ *              cacheMegabytes isn't 0, games are settled through a cache that
+ *              size, shared by every client. Every player name a request
+ *              brings is kept until the server stops, so at most maxNames
+ *              distinct names are kept (SERVER_DEFAULT_MAX_NAMES if it's 0),
+ *              and a game with a name past that is skipped.
+*******************************************************************************/
+int runServer(const char* socketPath, SolverType solver, int threadCount,
+              int cacheMegabytes, int maxNames){
+    PlayerNames::setLimit(maxNames > 0 ? maxNames : SERVER_DEFAULT_MAX_NAMES);
+    SettlementServer server(socketPath, solver, threadCount);
+    SettlementCache cache((size_t)cacheMegabytes << 20);
+    if(cacheMegabytes > 0){
+        server.setCache(&cache);
+    }
+    int status = server.run(std::cerr);
+    server.printStats(std::cerr);
+    return status;
+}
+
+
+/*******************************************************************************
+ *                          printUsage(const char*)
+ * Description: Prints the command line options
+*******************************************************************************/
+void printUsage(const char* programName){
+    std::cerr << "usage: " << programName << "\n"
+              << "       " << programName 
+              << " --batch <ledger.csv|-> [--output <payments.csv>]\n"
+              << "           [--solver greedy|bucket|exact] [--threads <n>]\n"
+              << "           [--format text|csv|json|dot] "
+              << "[--allowed <allowed.csv>]\n"
+              << "           [--objective payments|money] "
+              << "[--max-payments <n>]\n"
+              << "           [--club [--drill-down <tables.csv>]] "
+              << "[--cache <megabytes>]\n"
+              << "       " << programName
+              << " --ledger <game.pkl> [--output <payments.csv>]\n"
+              << "           [--solver greedy|bucket|exact] "
+              << "[--write-ledger <settled.pkl>]\n"
+              << "           [--format text|csv|json|dot] "
+              << "[--allowed <allowed.csv>]\n"
+              << "           [--objective payments|money] "
+              << "[--max-payments <n>]\n"
+              << "       " << programName
+              << " --pack <game.csv> <game.pkl>\n"
+              << "       " << programName
+              << " --summarize <ledger.csv|-> <summary.pks> "
+              << "[--workers <n>]\n"
+              << "       " << programName
+              << " --merge <merged.pks> <summary.pks>...\n"
+              << "       " << programName
+              << " --summary <summary.pks> [--output <payments.csv>]\n"
+              << "           [--solver greedy|bucket|exact] "
+              << "[--format text|csv|json|dot]\n"
+              << "           [--allowed <allowed.csv>] "
+              << "[--objective payments|money]\n"
+              << "           [--max-payments <n>]\n"
+              << "       " << programName
+              << " --serve <socket> [--solver greedy|bucket|exact] "
+              << "[--threads <n>]\n"
+              << "           [--cache <megabytes>] [--max-names <n>]\n"
+              << "       " << programName << " --log <session.log>\n"
+              << "Any of these can add --metrics <file.json|file.prom>.\n"
+              << "\n"
+              << "Ledger rows are game_id,player_name,buy_in,final_stack.\n"
+              << "Payments are written as game_id,payer,payee,amount, or in "
+              << "the --format given.\n"
+              << "The bucket solver makes the same payments as the greedy one "
+              << "with a radix sort.\n"
+              << "The exact solver finds the fewest payments for tables of up "
+              << "to " << EXACT_MAX_PLAYERS << " unsettled players.\n"
+              << "--threads 0 settles games on every core.\n"
+              << "Allowed payment rows are [game_id,]payer_name,payee_name; "
+              << "with --allowed, players\n"
+              << "only pay as allowed, passing money along if they must, with "
+              << "the fewest payments\n"
+              << "or the least money moved.\n"
+              << "--max-payments n (at least 2) settles so no player makes and "
+              << "receives more than\n"
+              << "n payments, passing money along where needed, in place of "
+              << "--solver.\n"
+              << "--club settles a batch's games as one club's tables, netting "
+              << "each player over\n"
+              << "every table first; --drill-down writes "
+              << "player_name,game_id,net for each seat.\n"
+              << "--summarize adds up each player over a ledger on --workers "
+              << "processes (0 for\n"
+              << "one per core); summaries --merge in any order, and --summary "
+              << "settles one as\n"
+              << "game league.\n"
+              << "--cache keeps the payments of up to that many megabytes of "
+              << "game shapes, so games\n"
+              << "with the same balances as one already solved aren't solved "
+              << "again.\n"
+              << "--max-names caps the distinct player names a server keeps "
+              << "(default " << SERVER_DEFAULT_MAX_NAMES << ");\n"
+              << "games with a name past the cap are skipped."
+              << std::endl;
+}